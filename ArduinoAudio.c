@@ -50,7 +50,7 @@ USB_ClassInfo_Audio_Device_t Speaker_Audio_Interface =
 					{
 						.Address          = AUDIO_STREAM_OUT_EPADDR,
 						.Size             = AUDIO_STREAM_OUT_EPSIZE,
-						.Banks            = 2,
+						.Banks            = AUDIO_STREAM_OUT_BANKS,
 					}
 			},
 	};
@@ -72,7 +72,34 @@ USB_ClassInfo_Audio_Device_t Speaker_Audio_Interface =
 
 /** Current audio sampling frequency of the streaming audio endpoint. */
 static uint32_t CurrentAudioSampleFrequency = 8000;
-static uint32_t baud = 500000;
+
+/** Indicates if the serial link to the ATMEGA328 must be renegotiated, as the sample rate or the settings it
+ *  was negotiated with have changed.
+ */
+static bool LinkRenegotiationPending;
+
+/** Indicates if the speaker or microphone stream is open, and the sample engine is running. */
+static bool StreamActive;
+
+/** Indicates if the link is being negotiated, which holds off playback until \ref Link_Task() reports it done. */
+static bool LinkNegotiating;
+
+/** Indicates if the host selected the speaker stream's 8-bit mono alternate setting, \ref SPEAKER_ALT_PCM8. */
+static bool SpeakerPCM8;
+
+/** Indicates if the link was negotiated to 8-bit mono for the 8-bit mono alternate setting, so that each byte the
+ *  host sends is forwarded to the link as is.
+ */
+static bool SpeakerBytes;
+
+/** Set on each USB start of frame, when the next packet of the microphone stream is due. */
+static bool MicFramePending;
+
+/** Timer 1 count at the last USB start of frame, and the number of start of frames taken since the main loop
+ *  last processed them, saturating.
+ */
+static volatile uint16_t StartOfFrameCount;
+static volatile uint8_t  StartOfFramesPending;
 
 /** Main program entry point. This routine contains the overall program flow, including initial
  *  setup of all components and the main program loop.
@@ -85,6 +112,49 @@ int main(void)
 
 	for (;;)
 	{
+		bool StreamEnabled = ((USB_DeviceState == DEVICE_STATE_Configured) &&
+		                      (Speaker_Audio_Interface.State.InterfaceEnabled || Mic_Audio_Interface.State.InterfaceEnabled ||
+		                       VendorStream_IsEnabled()));
+
+		if (StreamEnabled != StreamActive)
+		{
+			StreamActive = StreamEnabled;
+
+			if (StreamActive)
+			  StartStream();
+			else
+			  StopStream();
+		}
+
+		#if !defined(AUDIO_OUT_PORTC)
+		if (Link_Task() && LinkNegotiating)
+		{
+			LinkNegotiating = false;
+			ConfigureFrames();
+		}
+		#endif
+
+		if (StreamActive && !(LinkNegotiating) && (LinkRenegotiationPending || Link_IsRenegotiationNeeded()))
+		{
+			LinkRenegotiationPending = false;
+			NegotiateLink();
+		}
+
+		StartOfFrame_Task();
+		Audio_Task();
+		Mic_Task();
+		#if defined(AUDIO_CLASS_2)
+		Feedback_Task();
+		#endif
+		#if defined(LEVEL_METER)
+		Meter_Task();
+		#endif
+		Clock_Task();
+
+		/* Settings are only saved while idle, so that a stream never has to share the main loop with the EEPROM */
+		if (!(StreamActive))
+		  Settings_Task();
+
 		Audio_Device_USBTask(&Speaker_Audio_Interface);
 		Audio_Device_USBTask(&Mic_Audio_Interface);
 		USB_USBTask();
@@ -104,77 +174,519 @@ void SetupHardware(void)
 #endif
 
 	/* Hardware Initialization */
-	Serial_Init(baud, false);
+	Settings_Init();
+	#if defined(AUDIO_OUT_PORTC)
+	PortDAC_Init();
+	#else
+	Link_Init();
+	#endif
 	LEDs_Init();
 	USB_Init();
 
-	/* Sample reload timer initialization */
-	TIMSK0  = (1 << OCIE0A);
-	OCR0A   = ((F_CPU / 8 / CurrentAudioSampleFrequency) - 1);
-	TCCR0A  = (1 << WGM01);  // CTC mode
-	TCCR0B  = (1 << CS01);   // Fcpu/8 speed
+	Clock_Init();
+	Mix_Init();
+	Dsp_Init();
+	Level_Init();
+
+	/* Sample reload timer initialization; the timer itself only runs while a stream is open */
+	Clock_SetRate(CurrentAudioSampleFrequency);
+	Dsp_SetRate(CurrentAudioSampleFrequency);
+	Level_SetRate(CurrentAudioSampleFrequency);
+	Emission_SetRate(CurrentAudioSampleFrequency);
+	Conceal_SetRate(CurrentAudioSampleFrequency);
+	SampleRing_Reset(1, false);
 }
 
-/** ISR to handle sending the sample over USART to the atmega328 */
-ISR(TIMER0_COMPA_vect, ISR_BLOCK)
+/** Starts the sample engine when the host opens the speaker or microphone stream. The link to the ATMEGA328
+ *  is brought up to the fastest mode it supports, and the sample timer is started once the ring has been
+ *  filled to the target depth, so the first samples play immediately and without gaps.
+ */
+void StartStream(void)
 {
-	uint8_t PrevEndpoint = Endpoint_GetCurrentEndpoint();
+	LinkRenegotiationPending = false;
+	NegotiateLink();
+}
+
+/** Stops the sample engine when the host closes both streams, so an idle device spends no time in the
+ *  sample ISR: the sample timer is stopped, the ring emptied, and the output muted.
+ */
+void StopStream(void)
+{
+	Clock_Stop();
+	SampleRing_Reset(AudioArena.SampleRing.FrameEntries, false);
+	Jitter_Stop();
+	Conceal_Reset();
+
+	#if defined(AUDIO_OUT_PORTC)
+	PortDAC_Output(0);
+	#else
+	LinkNegotiating = false;
+	Link_Stop();
+	#endif
+
+	LEDs_TurnOffLEDs(LEDS_LED1);
+}
+
+/** Starts negotiating the serial link to the ATMEGA328 with the active settings. While the microphone stream is
+ *  open the receiver is also asked to capture. Playback is held off until the handshake, which is stepped from
+ *  the main loop, has finished and \ref ConfigureFrames() has prepared the sample ring for the frame layout the
+ *  link ended up with.
+ */
+void NegotiateLink(void)
+{
+	#if defined(AUDIO_OUT_PORTC)
+	/* There is no link in this mode; samples go straight to the ladder DAC as mono */
+	ConfigureFrames();
+	#else
+	/* Hold playback off while the link changes format under the sample ISR */
+	SampleRing_Reset(AudioArena.SampleRing.FrameEntries, false);
+
+	uint8_t Format = Settings_Active.LinkFormat;
+
+	/* The 8-bit mono alternate setting gets a link of its own format, so each byte goes out as it came in; the
+	 * capture needs 16-bit frames, so the microphone stream takes precedence while it is open */
+	if (Mic_Audio_Interface.State.InterfaceEnabled)
+	  Format |= LINK_FORMAT_CAPTURE;
+	else if (SpeakerPCM8)
+	  Format = 0;
+
+	Link_Negotiate(Settings_Active.LinkBaud, Format, CurrentAudioSampleFrequency);
+	LinkNegotiating = true;
+	#endif
+}
+
+/** Prepares the sample ring, the mixer and everything after it for the frame layout the link was negotiated to.
+ *  While the receiver is capturing the sample timer is started straight away, as its frames are the capture's
+ *  sample clock.
+ */
+void ConfigureFrames(void)
+{
+	#if defined(AUDIO_OUT_PORTC)
+	SampleRing_Reset(1, false);
+	Mix_SetLayout(1);
+	Dsp_Configure(Settings_Active.DspStages, 1);
+	Level_Configure(1, PORTC_DAC_BITS);
+	Jitter_Reset(1, GetRingDepth(1), CurrentAudioSampleFrequency);
+	Conceal_Reset();
+	Conceal_SetBypass(false);
+	#else
+	MicRing_Reset();
+
+	SampleRing_Reset((Link_Format & LINK_FORMAT_STEREO) ? 2 : 1, (Link_Format == 0));
+	Mix_SetLayout(AudioArena.SampleRing.FrameEntries);
+	Dsp_Configure(Settings_Active.DspStages, AudioArena.SampleRing.FrameEntries);
+	Level_Configure(AudioArena.SampleRing.FrameEntries, ((Link_Format & LINK_FORMAT_16BIT) ? 16 : 8));
+	Jitter_Reset(AudioArena.SampleRing.FrameEntries, GetRingDepth(AudioArena.SampleRing.FrameEntries), CurrentAudioSampleFrequency);
+	Conceal_Reset();
+
+	/* Bytes of the 8-bit mono alternate setting are neither merged by the jitter buffer controller nor faded */
+	SpeakerBytes = (SpeakerPCM8 && (Link_Format == 0));
+	Conceal_SetBypass(SpeakerBytes);
+
+	if (Link_Format & LINK_FORMAT_CAPTURE)
+	  Clock_Start();
+	#endif
+}
+
+/** Sets the sample rate of both streams, which share the sample clock.
+ *
+ *  \param[in] SampleFrequency  New sample rate in Hz.
+ */
+void SetSampleFrequency(const uint32_t SampleFrequency)
+{
+	CurrentAudioSampleFrequency = SampleFrequency;
+
+	/* Adjust sample reload timer to the new frequency */
+	Clock_SetRate(CurrentAudioSampleFrequency);
+	Dsp_SetRate(CurrentAudioSampleFrequency);
+	Level_SetRate(CurrentAudioSampleFrequency);
+	Emission_SetRate(CurrentAudioSampleFrequency);
+	Conceal_SetRate(CurrentAudioSampleFrequency);
+	Trace_Record(TRACE_EVENT_RateChange, (CurrentAudioSampleFrequency / 1000));
+
+	/* The link may need a different mode to carry the new sample rate */
+	LinkRenegotiationPending = true;
+}
+
+/** Determines if samples are taken from the vendor stream rather than the speaker stream, which is the case while
+ *  the vendor stream is open and the speaker stream is not.
+ *
+ *  \return Boolean \c true if the vendor stream is being played, \c false otherwise
+ */
+bool IsVendorStreamPlaying(void)
+{
+	return (VendorStream_IsEnabled() && !(Speaker_Audio_Interface.State.InterfaceEnabled));
+}
+
+/** Determines the depth in frames of the jitter buffer. The host fills the ring behind the vendor stream as far as
+ *  flow control lets it, so that stream has the whole ring as its buffer instead, and the adaptive controller would
+ *  only ever see a ring it could shrink.
+ *
+ *  \param[in] FrameEntries  Number of ring entries in each frame.
+ *
+ *  \return Target depth of the ring in frames, or zero to adapt the depth to the host.
+ */
+uint8_t GetRingDepth(const uint8_t FrameEntries)
+{
+	return IsVendorStreamPlaying() ? (SAMPLE_RING_SIZE / FrameEntries) : Settings_Active.RingDepth;
+}
+
+/** Moves received samples from the streaming endpoint into the sample ring, through the downmix matrix into
+ *  the channels the link carries and then the processing chain. Samples of the 8-bit mono alternate setting
+ *  skip both, as the host has already reduced them; once the link has been negotiated to 8-bit mono for them
+ *  each byte also skips the jitter buffer controller and goes into the ring as is, for the link to send
+ *  unchanged. Until then, or while the microphone stream holds the link in a capture format, they are widened
+ *  to every channel of the link's format. Playback starts once the ring holds the target depth of the jitter
+ *  buffer controller. While the vendor stream is played its bulk endpoint takes the
+ *  place of the speaker stream's, in the same format.
+ */
+void Audio_Task(void)
+{
+	uint8_t FrameEntries = AudioArena.SampleRing.FrameEntries;
+	uint8_t Frames       = 0;
+	bool    Vendor       = IsVendorStreamPlaying();
 
-	/* Check that the USB bus is ready for the next sample to read */
-	if (Audio_Device_IsSampleReceived(&Speaker_Audio_Interface))
+	/* Packets are left in the endpoint until the link has settled on the frame layout to fill the ring with */
+	if (LinkNegotiating)
+	  return;
+
+	Jitter_Observe();
+
+	while (((SAMPLE_RING_SIZE - SampleRing_Count()) >= FrameEntries) &&
+	       (Vendor ? VendorStream_IsSampleReceived() : Audio_Device_IsSampleReceived(&Speaker_Audio_Interface)))
 	{
-		/* Retrieve the signed 16-bit left and right audio samples, convert to 8-bit */
-		int8_t LeftSample_8Bit  = (Audio_Device_ReadSample16(&Speaker_Audio_Interface) >> 8);
-		int8_t RightSample_8Bit = (Audio_Device_ReadSample16(&Speaker_Audio_Interface) >> 8);
-
-		/* Mix the two channels together to produce a mono, 8-bit sample */
-		int8_t MixedSample_8Bit = (((int16_t)LeftSample_8Bit + (int16_t)RightSample_8Bit) >> 1);
- 
-		if(UCSR1A & (1<<UDRE1)) { 
-			//turn on LED 1 when we actually send a sample over USART for debug purposes
-			LEDs_TurnOnLEDs(LEDS_LED1);
-			UDR1 = MixedSample_8Bit ^ (1 << 7);
+		int16_t Input[AUDIO_IN_CHANNELS];
+		int16_t Output[MIX_OUTPUTS];
+
+		if (SpeakerBytes)
+		{
+			/* Place the byte in the upper half of the entry, which is all the 8-bit link sends of it */
+			Output[0] = (int16_t)((uint16_t)((uint8_t)Audio_Device_ReadSample8(&Speaker_Audio_Interface) ^ 0x80) << 8);
+
+			Frames++;
+			Level_Process(Output);
+			SampleRing_Push(Output[0]);
+			continue;
+		}
+
+		if (SpeakerPCM8)
+		{
+			/* Widen the unsigned sample so that the link takes back exactly the same byte, on every channel */
+			Output[0] = (int16_t)((uint16_t)((uint8_t)Audio_Device_ReadSample8(&Speaker_Audio_Interface) ^ 0x80) << 8);
+			Output[1] = Output[0];
 		}
+		else
+		{
+			/* Retrieve one sample of each stream channel, widening 8-bit unsigned samples to signed 16-bit */
+			for (uint8_t Channel = 0; Channel < AUDIO_IN_CHANNELS; Channel++)
+			{
+				#if (AUDIO_IN_SUBFRAME_SIZE == 1)
+				Input[Channel] = (int16_t)((uint16_t)((uint8_t)(Vendor ? VendorStream_ReadSample8() : Audio_Device_ReadSample8(&Speaker_Audio_Interface)) ^ 0x80) << 8);
+				#else
+				Input[Channel] = (Vendor ? VendorStream_ReadSample16() : Audio_Device_ReadSample16(&Speaker_Audio_Interface));
+				#endif
+			}
+
+			Mix_Process(Input, Output);
+			Dsp_Process(Output);
+		}
+
+		Frames++;
+
+		/* The depth controller may merge this frame into the next one, to shrink the buffer */
+		if (!(Jitter_Process(Output)))
+		  continue;
+
+		Level_Process(Output);
+
+		for (uint8_t Entry = 0; Entry < FrameEntries; Entry++)
+		  SampleRing_Push(Output[Entry]);
+	}
+
+	if (Frames)
+	  Trace_Record(TRACE_EVENT_Packet, Frames);
+
+	if (!(SampleRing_IsPrimed()) && (SampleRing_Count() >= (Jitter_TargetDepth * FrameEntries)))
+	{
+		/* Crossfade from wherever the underrun concealment has got to, or from midscale at the stream start */
+		Conceal_Resume();
+		SampleRing_SetPrimed(true);
+		Jitter_Started();
+
+		/* Start the sample timer with the ring full, if this is the start of the stream */
+		Clock_Start();
+
+		/* Turn on LED 1 once samples are flowing over the USART, for debug purposes */
+		LEDs_TurnOnLEDs(LEDS_LED1);
+	}
+}
+
+/** Processes the USB start of frames timestamped since the last call, measuring the sample clock against the host,
+ *  advancing the trace time and releasing the next packet of the microphone stream. If the main loop fell more
+ *  than a frame behind, the interval up to the latest start of frame is not known, and the clock measurement
+ *  starts over from it.
+ */
+void StartOfFrame_Task(void)
+{
+	uint16_t Timestamp;
+	uint8_t  Frames;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Timestamp            = StartOfFrameCount;
+		Frames               = StartOfFramesPending;
+		StartOfFramesPending = 0;
 	}
 
-	// Endpoint_SelectEndpoint(Mic_Audio_Interface.Config.DataINEndpoint.Address);
-	
-	// LEDs_SetAllLEDs(!(Speaker_Audio_Interface.State.InterfaceEnabled) ? LEDMASK_USB_READY : LEDS_NO_LEDS);
-	/* Check that the USB bus is ready for the next sample to write */
-	// if (Audio_Device_IsReadyForNextSample(&Mic_Audio_Interface))
-	// {
-	// 		LEDs_TurnOnLEDs(LEDS_LED1);
-	// 	int16_t AudioSample;
-	// 	static uint8_t SquareWaveSampleCount;
-	// 	static int16_t CurrentWaveValue;
-
-	// 	/* In test tone mode, generate a square wave at 1/256 of the sample rate */
-	// 	if (SquareWaveSampleCount++ == 0xFF)
-	// 		CurrentWaveValue ^= 0x8000;
-			
-	// 	AudioSample = CurrentWaveValue;
-	// 	Audio_Device_WriteSample16(&Mic_Audio_Interface, 0);
-	// }
+	if (!(Frames))
+	  return;
+
+	Clock_StartOfFrame(Timestamp, (Frames == 1));
+	Trace_StartOfFrame(Frames);
+
+	MicFramePending = true;
+}
+
+/** Sends the microphone samples received from the ATMEGA328 since the last USB frame to the host, once per
+ *  frame. If the receiver is not capturing, as in \c AUDIO_OUT_PORTC mode or when the link fell back to 8-bit
+ *  mono frames, a packet of silence at the nominal rate is sent instead so that the stream still runs.
+ */
+void Mic_Task(void)
+{
+	if (!(MicFramePending) || !(Audio_Device_IsReadyForNextSample(&Mic_Audio_Interface)))
+	  return;
+
+	MicFramePending = false;
+
+	bool    Capturing = (Link_Format & LINK_FORMAT_CAPTURE);
+	uint8_t Samples   = Capturing ? MicRing_Count() : (CurrentAudioSampleFrequency / 1000);
+
+	Samples = MIN(Samples, (AUDIO_STREAM_IN_EPSIZE / sizeof(int16_t)));
+
+	for (uint8_t i = 0; i < Samples; i++)
+	  Endpoint_Write_16_LE(Capturing ? MicRing_Pop() : 0);
+
+	Endpoint_ClearIN();
+}
+
+#if defined(LEVEL_METER)
+/** Sends the levels metered since the last report to the host every \ref LEVEL_PERIOD_MS milliseconds, timed by
+ *  the USB frame number. The totals are started over for each period whether or not the host has collected the
+ *  report before, so that each report covers a single period; a report the endpoint has no room for is dropped,
+ *  which the host sees as a gap in the sequence numbers.
+ */
+void Meter_Task(void)
+{
+	static uint16_t LastReportFrame;
+
+	if (USB_DeviceState != DEVICE_STATE_Configured)
+	  return;
+
+	uint16_t Frame = USB_Device_GetFrameNumber();
+
+	/* The frame number is 11 bits wide, which is enough for the longest report period */
+	if (((Frame - LastReportFrame) & 0x7FF) < LEVEL_PERIOD_MS)
+	  return;
+
+	LastReportFrame = Frame;
+
+	LevelReport_t Report;
+	Level_GetReport(&Report);
+
+	uint8_t PrevEndpoint = Endpoint_GetCurrentEndpoint();
+
+	Endpoint_SelectEndpoint(LEVEL_METER_EPADDR);
+
+	if (Endpoint_IsINReady())
+	{
+		Endpoint_Write_Stream_LE(&Report, sizeof(Report), NULL);
+		Endpoint_ClearIN();
+	}
 
 	Endpoint_SelectEndpoint(PrevEndpoint);
 }
+#endif
 
-/** Event handler for the library USB Connection event. */
-void EVENT_USB_Device_Connect(void)
+#if defined(AUDIO_CLASS_2)
+/** Sends the rate at which the speaker stream's samples are played out to the host over the explicit feedback
+ *  endpoint, whenever its bank is free. The measured rate of the sample clock is trimmed by the distance of the
+ *  ring from the jitter buffer's target depth, so the host also steers the ring back towards the target.
+ */
+void Feedback_Task(void)
 {
+	if (!(StreamActive))
+	  return;
+
+	Endpoint_SelectEndpoint(AUDIO_STREAM_FEEDBACK_EPADDR);
+
+	if (!(Endpoint_IsINReady()))
+	  return;
+
+	uint32_t Feedback = Clock_GetFeedback();
+
+	if (SampleRing_IsPrimed())
+	{
+		int16_t DepthError = ((int16_t)Jitter_TargetDepth - (SampleRing_Count() / AudioArena.SampleRing.FrameEntries));
 
-	/* Sample reload timer initialization */
-	TIMSK0  = (1 << OCIE0A);
-	OCR0A   = ((F_CPU / 8 / CurrentAudioSampleFrequency) - 1);
-	TCCR0A  = (1 << WGM01);  // CTC mode
-	TCCR0B  = (1 << CS01);   // Fcpu/8 speed
+		DepthError = MAX(MIN(DepthError, FEEDBACK_MAX_DEPTH_ERROR), -FEEDBACK_MAX_DEPTH_ERROR);
+		Feedback  += ((int32_t)DepthError << FEEDBACK_DEPTH_SHIFT);
+	}
+
+	Endpoint_Write_8(Feedback & 0xFF);
+	Endpoint_Write_8(Feedback >> 8);
+	Endpoint_Write_8(Feedback >> 16);
+	Endpoint_ClearIN();
 }
 
+/** Processes the Audio Class 2.0 requests to the entities of the audio function, which the library's Audio
+ *  Class 1.0 driver would misread, as they reuse its request codes. The clock source's sampling frequency and
+ *  validity are handled here, while the mixer unit's requests are passed to the same callback as in Audio
+ *  Class 1.0 mode. This must be called from the library USB Control Request reception event, before the
+ *  driver is given the request.
+ */
+void Audio2_ProcessControlRequest(void)
+{
+	if (!(Endpoint_IsSETUPReceived()))
+	  return;
+
+	if ((USB_ControlRequest.bmRequestType & (CONTROL_REQTYPE_TYPE | CONTROL_REQTYPE_RECIPIENT)) != (REQTYPE_CLASS | REQREC_INTERFACE))
+	  return;
+
+	/* Entities are addressed through the control interface, with the entity ID in the upper byte */
+	if ((USB_ControlRequest.wIndex & 0xFF) != INTERFACE_ID_AudioControl)
+	  return;
+
+	uint8_t EntityID = (USB_ControlRequest.wIndex >> 8);
+	uint8_t Selector = (USB_ControlRequest.wValue >> 8);
+	bool    IsGet    = (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST);
+
+	if ((EntityID == AUDIO2_CLOCK_SOURCE_ID) && (Selector == AUDIO2_CS_SAM_FREQ_CONTROL))
+	{
+		if ((USB_ControlRequest.bRequest == AUDIO2_REQ_CUR) && IsGet)
+		{
+			Endpoint_ClearSETUP();
+			Endpoint_Write_Control_Stream_LE(&CurrentAudioSampleFrequency, MIN(sizeof(uint32_t), USB_ControlRequest.wLength));
+			Endpoint_ClearOUT();
+			return;
+		}
+		else if ((USB_ControlRequest.bRequest == AUDIO2_REQ_CUR) && (USB_ControlRequest.wLength == sizeof(uint32_t)))
+		{
+			uint32_t SampleFrequency;
+			uint8_t  SampleRates = Audio2_GetSampleRateCount();
+
+			Endpoint_ClearSETUP();
+			Endpoint_Read_Control_Stream_LE(&SampleFrequency, sizeof(uint32_t));
+
+			/* Reject rates outside the advertised ranges by stalling the status stage */
+			for (uint8_t i = 0; i < SampleRates; i++)
+			{
+				if (pgm_read_dword(&Audio2_SampleRateRanges.SubRanges[i].Minimum) == SampleFrequency)
+				{
+					Endpoint_ClearIN();
+
+					if (SampleFrequency != CurrentAudioSampleFrequency)
+					  SetSampleFrequency(SampleFrequency);
+
+					return;
+				}
+			}
+
+			Endpoint_StallTransaction();
+			return;
+		}
+		else if ((USB_ControlRequest.bRequest == AUDIO2_REQ_RANGE) && IsGet)
+		{
+			/* Offer only the rates the probed link can carry, the first of the table's subranges */
+			USB_Audio2_SampleRateRanges_t SampleRateRanges;
+			uint8_t                       SampleRates = Audio2_GetSampleRateCount();
+			uint16_t                      RangesSize  = (sizeof(SampleRateRanges.TotalSubRanges) +
+			                                             (SampleRates * sizeof(SampleRateRanges.SubRanges[0])));
+
+			memcpy_P(&SampleRateRanges, &Audio2_SampleRateRanges, RangesSize);
+			SampleRateRanges.TotalSubRanges = SampleRates;
+
+			Endpoint_ClearSETUP();
+			Endpoint_Write_Control_Stream_LE(&SampleRateRanges, MIN(RangesSize, USB_ControlRequest.wLength));
+			Endpoint_ClearOUT();
+			return;
+		}
+	}
+	else if ((EntityID == AUDIO2_CLOCK_SOURCE_ID) && (Selector == AUDIO2_CS_CLOCK_VALID_CONTROL))
+	{
+		if ((USB_ControlRequest.bRequest == AUDIO2_REQ_CUR) && IsGet)
+		{
+			uint8_t ClockValid = true;
+
+			Endpoint_ClearSETUP();
+			Endpoint_Write_Control_Stream_LE(&ClockValid, MIN(sizeof(uint8_t), USB_ControlRequest.wLength));
+			Endpoint_ClearOUT();
+			return;
+		}
+	}
+	else if (EntityID == AUDIO_MIXER_UNIT_ID)
+	{
+		/* Crosspoints are addressed as in Audio Class 1.0, by input and output channel number */
+		uint16_t Parameter = USB_ControlRequest.wValue;
+
+		if ((USB_ControlRequest.bRequest == AUDIO2_REQ_CUR) &&
+		    CALLBACK_Audio_Device_GetSetInterfaceProperty(&Speaker_Audio_Interface, AUDIO_REQ_GetCurrent, EntityID, Parameter, NULL, NULL))
+		{
+			uint8_t  Value[2];
+			uint16_t Length = sizeof(Value);
+
+			Endpoint_ClearSETUP();
+
+			if (IsGet)
+			{
+				CALLBACK_Audio_Device_GetSetInterfaceProperty(&Speaker_Audio_Interface, AUDIO_REQ_GetCurrent, EntityID, Parameter, &Length, Value);
+				Endpoint_Write_Control_Stream_LE(Value, MIN(Length, USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+			else
+			{
+				Endpoint_Read_Control_Stream_LE(Value, MIN(Length, USB_ControlRequest.wLength));
+				Endpoint_ClearIN();
+
+				Length = MIN(Length, USB_ControlRequest.wLength);
+				CALLBACK_Audio_Device_GetSetInterfaceProperty(&Speaker_Audio_Interface, AUDIO_REQ_SetCurrent, EntityID, Parameter, &Length, Value);
+			}
+
+			return;
+		}
+		else if ((USB_ControlRequest.bRequest == AUDIO2_REQ_RANGE) && IsGet &&
+		         CALLBACK_Audio_Device_GetSetInterfaceProperty(&Speaker_Audio_Interface, AUDIO_REQ_GetMinimum, EntityID, Parameter, NULL, NULL))
+		{
+			/* A single subrange of the minimum, maximum and resolution, each as a 16-bit value */
+			static const uint8_t RangeProperties[] = {AUDIO_REQ_GetMinimum, AUDIO_REQ_GetMaximum, AUDIO_REQ_GetResolution};
+
+			uint8_t Range[2 + (sizeof(RangeProperties) * 2)] = {1, 0};
+
+			for (uint8_t i = 0; i < sizeof(RangeProperties); i++)
+			{
+				uint16_t Length = 2;
+
+				CALLBACK_Audio_Device_GetSetInterfaceProperty(&Speaker_Audio_Interface, RangeProperties[i], EntityID, Parameter,
+				                                              &Length, &Range[2 + (i * 2)]);
+			}
+
+			Endpoint_ClearSETUP();
+			Endpoint_Write_Control_Stream_LE(Range, MIN(sizeof(Range), USB_ControlRequest.wLength));
+			Endpoint_ClearOUT();
+			return;
+		}
+	}
+
+	/* Stall anything else addressed to the entities, rather than let the driver take it as an older request */
+	Endpoint_ClearSETUP();
+	Endpoint_StallTransaction();
+}
+#endif
+
 /** Event handler for the library USB Disconnection event. */
 void EVENT_USB_Device_Disconnect(void)
 {
 	/* Stop the sample reload timer */
-	TCCR0B = 0;
+	Clock_Stop();
 }
 
 /** Event handler for the library USB Configuration Changed event. */
@@ -182,21 +694,116 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 {
 	bool ConfigSuccess = true;
 
+	#if defined(AUDIO_CLASS_2)
+	/* The feedback endpoint has the lowest number, so it must be configured first */
+	ConfigSuccess &= Endpoint_ConfigureEndpoint(AUDIO_STREAM_FEEDBACK_EPADDR, EP_TYPE_ISOCHRONOUS, 8, 1);
+	#endif
+
+	#if defined(VENDOR_STREAM)
+	ConfigSuccess &= VendorStream_ConfigureEndpoint();
+	#endif
+
+	#if defined(LEVEL_METER)
+	ConfigSuccess &= Endpoint_ConfigureEndpoint(LEVEL_METER_EPADDR, EP_TYPE_INTERRUPT, LEVEL_METER_EPSIZE, 1);
+	#endif
+
 	ConfigSuccess &= Audio_Device_ConfigureEndpoints(&Speaker_Audio_Interface);
 	ConfigSuccess &= Audio_Device_ConfigureEndpoints(&Mic_Audio_Interface);
 
+	/* Timestamp each start of frame, to measure the sample clock against the host */
+	USB_Device_EnableSOFEvents();
+
 	LEDs_SetAllLEDs(ConfigSuccess ? LEDS_LED2 : LEDS_NO_LEDS);
 }
+
+/** Event handler for the library USB Start of Frame event. The library's USB interrupt runs with interrupts
+ *  disabled, so only the timestamp is taken here, and the frame is processed from the main loop by
+ *  \ref StartOfFrame_Task().
+ */
+void EVENT_USB_Device_StartOfFrame(void)
+{
+	StartOfFrameCount = TCNT1;
+
+	if (StartOfFramesPending != UINT8_MAX)
+	  StartOfFramesPending++;
+}
 void EVENT_USB_Device_UnhandledControlRequest(void) {
 }
 
 /** Event handler for the library USB Control Request reception event. */
 void EVENT_USB_Device_ControlRequest(void)
 {
+	Vendor_ProcessControlRequest();
+
+	#if defined(VENDOR_STREAM)
+	VendorStream_ProcessControlRequest();
+	#endif
+
+	#if defined(AUDIO_CLASS_2)
+	Audio2_ProcessControlRequest();
+	#endif
+
 	Audio_Device_ProcessControlRequest(&Speaker_Audio_Interface);
 	Audio_Device_ProcessControlRequest(&Mic_Audio_Interface);
 }
 
+/** Audio class driver event for the start or stop of a stream, when the host selects an alternate setting of
+ *  a streaming interface. Settings changed through the vendor requests are put into effect when the speaker
+ *  stream starts, and the link is renegotiated to start or stop the capture when the microphone stream does.
+ *
+ *  \param[in] AudioInterfaceInfo  Pointer to a structure containing an Audio Class configuration and state.
+ */
+void EVENT_Audio_Device_StreamStartStop(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo)
+{
+	/* The driver only keeps whether a stream is open, but the SET_INTERFACE request is still at hand */
+	uint8_t AltSetting = (USB_ControlRequest.wValue & 0x0F);
+
+	Trace_Record(TRACE_EVENT_AltSetting, ((AudioInterfaceInfo->Config.StreamingInterfaceNumber << 4) | AltSetting));
+
+	/* Switching to or from the 8-bit mono alternate setting switches the link to or from 8-bit mono frames */
+	if ((AudioInterfaceInfo == &Speaker_Audio_Interface) && (SpeakerPCM8 != (AltSetting == SPEAKER_ALT_PCM8)))
+	{
+		SpeakerPCM8              = (AltSetting == SPEAKER_ALT_PCM8);
+		LinkRenegotiationPending = true;
+	}
+
+	if ((AudioInterfaceInfo == &Speaker_Audio_Interface) && AudioInterfaceInfo->State.InterfaceEnabled)
+	{
+		if (memcmp(&Settings_Active, &Settings_Pending, sizeof(AppSettings_t)))
+		{
+			Settings_Apply();
+			LinkRenegotiationPending = true;
+		}
+	}
+	else if (AudioInterfaceInfo == &Mic_Audio_Interface)
+	{
+		LinkRenegotiationPending = true;
+	}
+}
+
+#if defined(VENDOR_STREAM)
+/** Vendor stream event for the start or stop of the stream, when the host selects an alternate setting of the
+ *  vendor stream interface. Opening it puts the rate set for it and any changed settings into effect, unless an
+ *  audio class stream is already open, as the streams share the sample clock and the host of those owns it.
+ */
+void EVENT_VendorStream_StartStop(void)
+{
+	Trace_Record(TRACE_EVENT_AltSetting, ((INTERFACE_ID_VendorStream << 4) | VendorStream_Enabled));
+
+	if (!(VendorStream_Enabled) || Speaker_Audio_Interface.State.InterfaceEnabled || Mic_Audio_Interface.State.InterfaceEnabled)
+	  return;
+
+	if (VendorStream_SampleRate != CurrentAudioSampleFrequency)
+	  SetSampleFrequency(VendorStream_SampleRate);
+
+	if (memcmp(&Settings_Active, &Settings_Pending, sizeof(AppSettings_t)))
+	  Settings_Apply();
+
+	/* The ring depth differs between the streams, so the jitter buffer is set up again */
+	LinkRenegotiationPending = true;
+}
+#endif
+
 /** Audio class driver callback for the setting and retrieval of streaming endpoint properties. This callback must be implemented
  *  in the user application to handle property manipulations on streaming audio endpoints.
  *
@@ -227,7 +834,7 @@ bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t*
                                                   uint8_t* Data)
 {
 	/* Check the requested endpoint to see if a supported endpoint is being manipulated */
-	if (&AudioInterfaceInfo == &Speaker_Audio_Interface
+	if (AudioInterfaceInfo == &Speaker_Audio_Interface
 	  && EndpointAddress == Speaker_Audio_Interface.Config.DataOUTEndpoint.Address)
 	{
 		/* Check the requested control to see if a supported control is being manipulated */
@@ -240,10 +847,7 @@ bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t*
 					if (DataLength != NULL)
 					{
 						/* Set the new sampling frequency to the value given by the host */
-						CurrentAudioSampleFrequency = (((uint32_t)Data[2] << 16) | ((uint32_t)Data[1] << 8) | (uint32_t)Data[0]);
-  
-						/* Adjust sample reload timer to the new frequency */
-						OCR0A = ((F_CPU / 8 / CurrentAudioSampleFrequency) - 1);
+						SetSampleFrequency(((uint32_t)Data[2] << 16) | ((uint32_t)Data[1] << 8) | (uint32_t)Data[0]);
 					}
   
 					return true;
@@ -264,7 +868,7 @@ bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t*
 	}
   //
 	// /* Check the requested endpoint to see if a supported endpoint is being manipulated */
-	if (&AudioInterfaceInfo == &Mic_Audio_Interface
+	if (AudioInterfaceInfo == &Mic_Audio_Interface
 	  && EndpointAddress == Mic_Audio_Interface.Config.DataINEndpoint.Address)
 	{
 		/* Check the requested control to see if a supported control is being manipulated */
@@ -277,10 +881,7 @@ bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t*
 					if (DataLength != NULL)
 					{
 						/* Set the new sampling frequency to the value given by the host */
-						CurrentAudioSampleFrequency = (((uint32_t)Data[2] << 16) | ((uint32_t)Data[1] << 8) | (uint32_t)Data[0]);
-  
-						/* Adjust sample reload timer to the new frequency */
-						OCR0A = ((F_CPU / 8 / CurrentAudioSampleFrequency) - 1);
+						SetSampleFrequency(((uint32_t)Data[2] << 16) | ((uint32_t)Data[1] << 8) | (uint32_t)Data[0]);
 					}
   
 					return true;
@@ -332,7 +933,57 @@ bool CALLBACK_Audio_Device_GetSetInterfaceProperty(USB_ClassInfo_Audio_Device_t*
                                                    uint16_t* const DataLength,
                                                    uint8_t* Data)
 {
-	/* No audio interface entities in the device descriptor, thus no properties to get or set. */
-	// Audio_ClassRequests_t
+	/* The only entity with controls is the mixer unit, whose crosspoints are addressed by input and output
+	 * channel numbers, counting from one */
+	if ((AudioInterfaceInfo == &Speaker_Audio_Interface) && (EntityAddress == AUDIO_MIXER_UNIT_ID))
+	{
+		uint8_t InputChannel  = (Parameter >> 8);
+		uint8_t OutputChannel = (Parameter & 0xFF);
+		int16_t Value;
+
+		if (!(InputChannel) || (InputChannel > AUDIO_IN_CHANNELS) || !(OutputChannel) || (OutputChannel > MIX_OUTPUTS))
+		  return false;
+
+		switch (Property)
+		{
+			case AUDIO_REQ_SetCurrent:
+				/* Check if we are just testing for a valid property, or actually adjusting it */
+				if (DataLength != NULL)
+				{
+					if (*DataLength < 2)
+					  return false;
+
+					Mix_SetGain((InputChannel - 1), (OutputChannel - 1), (int16_t)(((uint16_t)Data[1] << 8) | Data[0]));
+				}
+
+				return true;
+			case AUDIO_REQ_GetCurrent:
+				Value = Mix_GetGain((InputChannel - 1), (OutputChannel - 1));
+				break;
+			case AUDIO_REQ_GetMinimum:
+				Value = (MIX_GAIN_MIN_DB * 256);
+				break;
+			case AUDIO_REQ_GetMaximum:
+				Value = (MIX_GAIN_MAX_DB * 256);
+				break;
+			case AUDIO_REQ_GetResolution:
+				Value = 256;
+				break;
+			default:
+				return false;
+		}
+
+		/* Check if we are just testing for a valid property, or actually reading it */
+		if (DataLength != NULL)
+		{
+			*DataLength = 2;
+
+			Data[1] = (Value >> 8);
+			Data[0] = (Value &  0xFF);
+		}
+
+		return true;
+	}
+
 	return false;
 }
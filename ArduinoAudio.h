@@ -41,9 +41,26 @@
 		#include <avr/wdt.h>
 		#include <avr/power.h>
 		#include <avr/interrupt.h>
+		#include <util/atomic.h>
 		#include <stdlib.h>
+		#include <string.h>
 
+		#include "Clock.h"
+		#include "Conceal.h"
 		#include "Descriptors.h"
+		#include "Dsp.h"
+		#include "Emission.h"
+		#include "Jitter.h"
+		#include "Level.h"
+		#include "Link.h"
+		#include "MicRing.h"
+		#include "Mix.h"
+		#include "PortDAC.h"
+		#include "SampleRing.h"
+		#include "Settings.h"
+		#include "Trace.h"
+		#include "Vendor.h"
+		#include "VendorStream.h"
 		#include "Config/AppConfig.h"
 
 		#include <LUFA/Drivers/Board/LEDs.h>
@@ -51,6 +68,11 @@
 		#include <LUFA/Platform/Platform.h>
 		#include <LUFA/Drivers/Peripheral/Serial.h>
 
+	/* Preprocessor Checks: */
+		#if defined(INTERRUPT_CONTROL_ENDPOINT)
+			#error Control requests must be processed from the main loop, as the sample ISR cannot nest into the USB endpoint interrupt.
+		#endif
+
 	/* Macros: */
 		/** LED mask for the library LED driver, to indicate that the USB interface is not ready. */
 		#define LEDMASK_USB_NOTREADY      LEDS_LED1
@@ -64,14 +86,39 @@
 		/** LED mask for the library LED driver, to indicate that an error has occurred in the USB interface. */
 		#define LEDMASK_USB_ERROR        (LEDS_LED1 | LEDS_LED3)
 
+		/** Largest distance in frames of the sample ring from its target depth which the feedback endpoint acts
+		 *  on, and the shift of each frame of distance into the 10.14 feedback value, a 64th of a sample per frame.
+		 */
+		#define FEEDBACK_MAX_DEPTH_ERROR  4
+		#define FEEDBACK_DEPTH_SHIFT      8
+
 	/* Function Prototypes: */
 		void SetupHardware(void);
+		void StartStream(void);
+		void StopStream(void);
+		void NegotiateLink(void);
+		void ConfigureFrames(void);
+		void SetSampleFrequency(const uint32_t SampleFrequency);
+		bool IsVendorStreamPlaying(void);
+		uint8_t GetRingDepth(const uint8_t FrameEntries);
+		void Audio_Task(void);
+		void Mic_Task(void);
+		void StartOfFrame_Task(void);
+		#if defined(LEVEL_METER)
+		void Meter_Task(void);
+		#endif
+		#if defined(AUDIO_CLASS_2)
+		void Feedback_Task(void);
+		void Audio2_ProcessControlRequest(void);
+		#endif
 
-		void EVENT_USB_Device_Connect(void);
 		void EVENT_USB_Device_Disconnect(void);
 		void EVENT_USB_Device_ConfigurationChanged(void);
+		void EVENT_USB_Device_StartOfFrame(void);
 		void EVENT_USB_Device_ControlRequest(void);
 
+		void EVENT_Audio_Device_StreamStartStop(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo);
+
 		bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo,
 		                                                  const uint8_t EndpointProperty,
 		                                                  const uint8_t EndpointAddress,
@@ -0,0 +1,20 @@
+/** \file
+ *
+ *  Audio arena, the single statically sized object holding all of the buffers and state of the sample path.
+ *  See \ref AudioArena_t; Tools/ramreport.py reports the arena alongside the rest of the static RAM use.
+ */
+
+#include <stddef.h>
+
+#include "Arena.h"
+
+/* Compile time checks that the arena contents fit its configured size, and are where SampleISR.S expects */
+_Static_assert(sizeof(AudioArena_t) == AUDIO_ARENA_SIZE,
+               "AUDIO_ARENA_SIZE is too small for the audio buffers; reduce SAMPLE_RING_SIZE or raise it.");
+_Static_assert(offsetof(AudioArena_t, SampleRing.Data) == ARENA_SAMPLE_RING_DATA,
+               "Sample ring entries must start the arena.");
+_Static_assert(offsetof(AudioArena_t, SampleRing.Head) == ARENA_SAMPLE_RING_HEAD,
+               "Sample ring head must directly follow the ring entries.");
+
+/** Audio arena instance. */
+AudioArena_t AudioArena;
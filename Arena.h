@@ -0,0 +1,95 @@
+/** \file
+ *
+ *  Header file for Arena.c.
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+	/* Includes: */
+		#if !defined(__ASSEMBLER__)
+			#include <stdint.h>
+		#endif
+
+		#include "LinkProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Offset of the sample ring entries within \ref AudioArena, for the hand-written sample ISR. */
+		#define ARENA_SAMPLE_RING_DATA       0
+
+		/** Offset of the sample ring head index within \ref AudioArena, for the hand-written sample ISR. */
+		#define ARENA_SAMPLE_RING_HEAD       (SAMPLE_RING_SIZE * 2)
+
+	#if !defined(__ASSEMBLER__)
+		/* Type Defines: */
+			/** Type define for the sample ring, filled from the streaming endpoint and drained by the sample ISR.
+			 *  The head and tail indexes run freely, and are masked with \c SAMPLE_RING_MASK on access.
+			 */
+			typedef struct
+			{
+				int16_t          Data[SAMPLE_RING_SIZE]; /**< Ring entries, one per sample of each frame */
+				volatile uint8_t Head; /**< Index of the next entry to write */
+				#if !defined(SAMPLE_ISR_ASM)
+				volatile uint8_t Tail; /**< Index of the next entry to read, kept in r3 by the hand-written ISR */
+				#endif
+				uint8_t          FrameEntries; /**< Number of ring entries making up each sample frame */
+			} __attribute__((packed)) SampleRing_t;
+
+			/** Type define for the remainder of the link sample frame being sent, after the first byte written by
+			 *  \c Link_SendFrame().
+			 */
+			typedef struct
+			{
+				volatile uint8_t Queue[LINK_MAX_FRAME_BYTES - 1]; /**< Bytes still to be sent */
+				volatile uint8_t Index; /**< Index of the next byte in \c Queue to send */
+				volatile uint8_t Count; /**< Number of bytes queued, cleared once the frame is handed to the USART */
+			} __attribute__((packed)) LinkTx_t;
+
+			/** Type define for the sample clock state, shared between the sample ISR and the main loop. */
+			typedef struct
+			{
+				uint8_t           PeriodWhole; /**< Whole timer ticks of the trimmed sample period */
+				uint16_t          PeriodFraction; /**< Fractional timer ticks of the sample period, in 1/65536ths */
+				uint16_t          Phase; /**< Fractional tick accumulator of the sample ISR */
+				uint16_t          LastCount; /**< Timer 1 count at the previous start of frame */
+				uint32_t          WindowCounts; /**< Timer 1 counts accumulated over the current window */
+				uint16_t          WindowFrames; /**< Frames timestamped in the current window, zero to restart */
+				uint32_t          WindowTotal; /**< Timer 1 counts over the last completed window */
+				volatile uint8_t  WindowReady; /**< Set when \c WindowTotal holds a window not yet processed */
+			} __attribute__((packed)) ClockState_t;
+
+			/** Type define for the state of the underrun concealment, shared between the sample ISR and the main
+			 *  loop.
+			 */
+			typedef struct
+			{
+				int16_t Level[2]; /**< Frame the current fade or crossfade starts from, one sample per channel */
+				uint8_t Weight; /**< Weight of \c Level in the output in 1/256ths, zero once the fade is over */
+				uint8_t Step; /**< Amount \c Weight falls by on each frame, set by the sample rate */
+			} __attribute__((packed)) ConcealState_t;
+
+			/** Type define for the audio arena, holding every audio buffer, codec state and counter of the sample
+			 *  path in a single object whose size is fixed by \c AUDIO_ARENA_SIZE, so that the RAM left over for
+			 *  the stack is known at build time. The sample ring must remain the first member, at the offsets
+			 *  given by the \c ARENA_SAMPLE_RING_* macros. All arena types are packed, which changes nothing on
+			 *  the AVR but keeps the layout the same when the pipeline is compiled for a host.
+			 */
+			typedef union
+			{
+				struct
+				{
+					SampleRing_t   SampleRing; /**< Sample ring between the streaming endpoint and the sample ISR */
+					LinkTx_t       LinkTx; /**< Sample frame bytes queued for the link USART */
+					ClockState_t   Clock; /**< Sample clock period and start of frame measurement */
+					ConcealState_t Conceal; /**< Fade out and crossfade of the underrun concealment */
+				} __attribute__((packed));
+
+				uint8_t Reserved[AUDIO_ARENA_SIZE]; /**< Fixes the arena size, leaving any unused space spare */
+			} __attribute__((packed)) AudioArena_t;
+
+		/* External Variables: */
+			extern AudioArena_t AudioArena;
+	#endif
+
+#endif
@@ -0,0 +1,56 @@
+/** \file
+ *
+ *  Cycle budget of the sample path. The time between two frames is split into \ref BUDGET_PARTS equal parts,
+ *  and each user of the CPU is given a whole number of them, so that the shares the DSP chain, the level meter
+ *  and the downmix benchmark are held to can be seen to add up to no more than the CPU, with the interrupts and
+ *  the rest of the main loop given theirs rather than being whatever is left over.
+ */
+
+#ifndef _BUDGET_H_
+#define _BUDGET_H_
+
+	/* Includes: */
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Number of parts the time between two frames is split into. */
+		#define BUDGET_PARTS                 16
+
+		/** Parts given to the interrupts: the sample ISR, the link's data register empty and receive ISRs for the
+		 *  rest of each frame, and the USB general and endpoint interrupts.
+		 */
+		#define BUDGET_PARTS_ISR             3
+
+		/** Parts given to the main loop tasks outside the sample path: the jitter buffer controller, underrun
+		 *  concealment, the microphone and feedback endpoints, the clock trim, the link and LUFA's USB tasks.
+		 */
+		#define BUDGET_PARTS_TASKS           2
+
+		/** Parts given to the downmix matrix and to moving each frame from the endpoint into the sample ring. */
+		#define BUDGET_PARTS_MIX             4
+
+		/** Parts given to the DSP chain. */
+		#define BUDGET_PARTS_DSP             5
+
+		/** Parts given to the level meter. */
+		#define BUDGET_PARTS_LEVEL           2
+
+		/** Cycles the given number of parts comes to for each frame at the given sample rate.
+		 *
+		 *  \param[in] Parts  Number of parts of the budget.
+		 *  \param[in] Rate   Sample rate in Hz.
+		 */
+		#define BUDGET_CYCLES(Parts, Rate)   ((((F_CPU) / BUDGET_PARTS) * (Parts)) / (Rate))
+
+		/** Cycles the given number of parts comes to in each 1ms USB frame, whatever the sample rate.
+		 *
+		 *  \param[in] Parts  Number of parts of the budget.
+		 */
+		#define BUDGET_CYCLES_PER_MS(Parts)  ((((F_CPU) / 1000) / BUDGET_PARTS) * (Parts))
+
+	/* Preprocessor Checks: */
+		#if ((BUDGET_PARTS_ISR + BUDGET_PARTS_TASKS + BUDGET_PARTS_MIX + BUDGET_PARTS_DSP + BUDGET_PARTS_LEVEL) > BUDGET_PARTS)
+			#error The shares of the cycle budget add up to more than the CPU.
+		#endif
+
+#endif
@@ -0,0 +1,188 @@
+/** \file
+ *
+ *  Sample clock driver. Timer 0 generates the sample rate interrupt from the system clock, while Timer 1
+ *  free-runs at the system clock rate so that each USB start of frame can be timestamped. Over each window
+ *  of \ref CLOCK_WINDOW_FRAMES frames the timestamps give the drift of the crystal against the host's 1ms
+ *  frame rate, which is always available as a diagnostic.
+ *
+ *  With \c SAMPLE_CLOCK_SOF_SYNC defined, the measured drift also trims the sample period, which is then
+ *  held in 16.16 fixed point and dithered between whole timer ticks by \ref Clock_Tick(), so that the samples
+ *  are consumed at exactly the rate the host sends them on an adaptive stream.
+ */
+
+#define  INCLUDE_FROM_CLOCK_C
+#include "Clock.h"
+
+/** Indicates if the last measurement window was valid, so that \ref Clock_DriftCentiPPM is current. */
+bool    Clock_Locked;
+
+/** Drift of the system clock against the USB frame rate in hundredths of a ppm, positive when fast. */
+int32_t Clock_DriftCentiPPM;
+
+/** Nominal 16.16 fixed point sample period in timer ticks for the current sample rate. */
+static int32_t  Clock_NominalPeriod;
+
+/** Current sample rate in Hz. */
+static uint32_t Clock_SampleRate;
+
+/** Starts Timer 1 free-running at the system clock rate, to timestamp each USB start of frame. */
+void Clock_Init(void)
+{
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);
+}
+
+/** Sets the sample clock to the given sample rate, discarding any trim measured for the previous rate.
+ *
+ *  \param[in] SampleRate  New sample rate in Hz.
+ */
+void Clock_SetRate(const uint32_t SampleRate)
+{
+	uint32_t Whole     = (CLOCK_TIMER_HZ / SampleRate);
+	uint32_t Remainder = (CLOCK_TIMER_HZ % SampleRate);
+
+	Clock_SampleRate    = SampleRate;
+	Clock_NominalPeriod = ((Whole << 16) | ((Remainder << 16) / SampleRate));
+	Clock_Locked        = false;
+	Clock_DriftCentiPPM = 0;
+
+	Clock_SetPeriod(Clock_NominalPeriod);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		/* Restart the measurement from the next start of frame */
+		AudioArena.Clock.WindowFrames = 0;
+		AudioArena.Clock.WindowReady  = false;
+	}
+}
+
+/** Starts the sample timer at the current sample rate, with a full sample period before the first interrupt.
+ *  Does nothing if the timer is already running.
+ */
+void Clock_Start(void)
+{
+	if (Clock_IsRunning())
+	  return;
+
+	AudioArena.Clock.Phase = 0;
+
+	TCNT0   = 0;
+	TIFR0   = (1 << OCF0A);
+	TIMSK0  = (1 << OCIE0A);
+	TCCR0A  = (1 << WGM01);  // CTC mode
+	TCCR0B  = (1 << CS01);   // Fcpu/8 speed
+}
+
+/** Stops the sample timer. */
+void Clock_Stop(void)
+{
+	TCCR0B  = 0;
+}
+
+/** Adds the time since the previous USB start of frame to the measurement window. This must be called from the
+ *  main loop, with the timestamp the library USB Start of Frame event took.
+ *
+ *  \param[in] Count        Timer 1 count at the start of frame, read on entry to the event.
+ *  \param[in] Consecutive  Boolean \c true if the previous start of frame was the one before this, \c false if
+ *                          any were taken in between without being passed on.
+ */
+void Clock_StartOfFrame(const uint16_t Count,
+                        const bool Consecutive)
+{
+	uint16_t FrameCount = (Count - AudioArena.Clock.LastCount);
+
+	/* The sample ISR timestamps its trace events against this, so it must never see half of it updated */
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		AudioArena.Clock.LastCount = Count;
+	}
+
+	/* Start a new window on the first frame, or after a missed start of frame */
+	if (!(AudioArena.Clock.WindowFrames) || !(Consecutive) || (FrameCount < (CLOCK_FRAME_COUNTS - CLOCK_MAX_FRAME_ERROR)) ||
+	    (FrameCount > (CLOCK_FRAME_COUNTS + CLOCK_MAX_FRAME_ERROR)))
+	{
+		AudioArena.Clock.WindowCounts = 0;
+		AudioArena.Clock.WindowFrames = 1;
+		return;
+	}
+
+	AudioArena.Clock.WindowCounts += FrameCount;
+
+	if (AudioArena.Clock.WindowFrames++ == CLOCK_WINDOW_FRAMES)
+	{
+		AudioArena.Clock.WindowTotal  = AudioArena.Clock.WindowCounts;
+		AudioArena.Clock.WindowReady  = true;
+		AudioArena.Clock.WindowCounts = 0;
+		AudioArena.Clock.WindowFrames = 1;
+	}
+}
+
+/** Processes a completed measurement window, updating the drift diagnostic and, in the start of frame sync
+ *  mode, trimming the sample period. This should be called from the main loop.
+ */
+void Clock_Task(void)
+{
+	uint32_t WindowTotal;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!(AudioArena.Clock.WindowReady))
+		  return;
+
+		WindowTotal = AudioArena.Clock.WindowTotal;
+		AudioArena.Clock.WindowReady = false;
+	}
+
+	int32_t Error = (int32_t)(WindowTotal - CLOCK_WINDOW_COUNTS);
+
+	if ((Error > (int32_t)CLOCK_MAX_WINDOW_ERROR) || (Error < -(int32_t)CLOCK_MAX_WINDOW_ERROR))
+	{
+		Clock_Locked = false;
+		return;
+	}
+
+	Clock_Locked        = true;
+	Clock_DriftCentiPPM = ((Error * 100000L) / (int32_t)(CLOCK_WINDOW_COUNTS / 1000));
+
+	#if defined(SAMPLE_CLOCK_SOF_SYNC)
+	/* A fast crystal fits more timer ticks into each of the host's sample periods, so lengthen the period */
+	Clock_SetPeriod(Clock_NominalPeriod + ((Error * (int32_t)CLOCK_PERIOD_SCALE) / (int32_t)Clock_SampleRate));
+	#endif
+}
+
+/** Computes the rate at which the sample timer consumes samples, measured against the host's frames, for the
+ *  explicit feedback endpoint of an asynchronous stream. Without the start of frame sync the timer runs from
+ *  the nearest whole number of ticks and from the crystal, so both are corrected for with the measured drift.
+ *
+ *  \return Samples per USB frame, in the 10.14 fixed point format of full speed feedback.
+ */
+uint32_t Clock_GetFeedback(void)
+{
+	#if defined(SAMPLE_CLOCK_SOF_SYNC)
+	return ((Clock_SampleRate << 14) / 1000);
+	#else
+	uint32_t Ticks    = ((Clock_NominalPeriod + 0x8000) >> 16);
+	int32_t  Feedback = ((((uint32_t)CLOCK_TIMER_HZ / 1000) << 14) / Ticks);
+
+	/* A fast crystal also plays the samples out faster in the host's time */
+	return (Feedback + ((Feedback * (Clock_DriftCentiPPM / 100)) / 1000000L));
+	#endif
+}
+
+/** Sets the sample period of Timer 0.
+ *
+ *  \param[in] Period  Sample period in timer ticks, in 16.16 fixed point.
+ */
+static void Clock_SetPeriod(const int32_t Period)
+{
+	#if defined(SAMPLE_CLOCK_SOF_SYNC)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		AudioArena.Clock.PeriodWhole    = (Period >> 16);
+		AudioArena.Clock.PeriodFraction = (Period & 0xFFFF);
+	}
+	#else
+	/* Without the fractional period the nearest whole number of ticks is used, as the clock is not trimmed */
+	OCR0A = (((Period + 0x8000) >> 16) - 1);
+	#endif
+}
@@ -0,0 +1,95 @@
+/** \file
+ *
+ *  Header file for Clock.c.
+ */
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Arena.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Tick rate of the sample timer (Timer 0), which runs from the system clock divided by 8. */
+		#define CLOCK_TIMER_HZ               (F_CPU / 8)
+
+		/** Number of USB frames (of 1ms each) over which the system clock is measured against the host. */
+		#define CLOCK_WINDOW_FRAMES          1024
+
+		/** Number of Timer 1 counts (system clock cycles) in a 1ms USB frame, for a perfect system clock. */
+		#define CLOCK_FRAME_COUNTS           (F_CPU / 1000)
+
+		/** Number of Timer 1 counts in a measurement window, for a perfect system clock. */
+		#define CLOCK_WINDOW_COUNTS          ((uint32_t)CLOCK_FRAME_COUNTS * CLOCK_WINDOW_FRAMES)
+
+		/** Largest error in Timer 1 counts for a single frame to be accepted as a measurement; anything further
+		 *  out means a start of frame was missed, such as around a suspend.
+		 */
+		#define CLOCK_MAX_FRAME_ERROR        (CLOCK_FRAME_COUNTS / 100)
+
+		/** Largest error in Timer 1 counts for a whole window, 1000 ppm, for it to be used to trim the clock. */
+		#define CLOCK_MAX_WINDOW_ERROR       (CLOCK_WINDOW_COUNTS / 1000)
+
+		/** Change in the 16.16 fixed point sample period for each Timer 1 count of window error, multiplied by
+		 *  the sample rate. Derived from the period being the measured window counts, divided by the timer
+		 *  prescaler and by the number of samples in the window.
+		 */
+		#define CLOCK_PERIOD_SCALE           ((65536UL * 1000) / (8 * CLOCK_WINDOW_FRAMES))
+
+	/* Enums: */
+		/** Enum for the sample clock synchronisation modes, as reported in \c ClockStatus_t. */
+		enum Clock_SyncModes_t
+		{
+			CLOCK_SYNC_FreeRunning = 0, /**< Sample clock derived from the crystal alone */
+			CLOCK_SYNC_SOF         = 1, /**< Sample clock trimmed against the USB start of frame rate */
+		};
+
+	/* External Variables: */
+		extern bool    Clock_Locked;
+		extern int32_t Clock_DriftCentiPPM;
+
+	/* Inline Functions: */
+		/** Determines if the sample timer is running.
+		 *
+		 *  \return Boolean \c true if the sample timer is running, \c false otherwise
+		 */
+		static inline bool Clock_IsRunning(void)
+		{
+			return (TCCR0B != 0);
+		}
+
+		#if defined(SAMPLE_CLOCK_SOF_SYNC) || defined(__DOXYGEN__)
+		/** Sets the length of the next sample period from the fractional period, carrying the fraction over into
+		 *  a one tick longer period whenever it overflows, so the average period matches the trimmed sample rate.
+		 *  This must be called from the sample ISR, at the start of each period.
+		 */
+		static inline void Clock_Tick(void)
+		{
+			uint16_t Phase = (AudioArena.Clock.Phase + AudioArena.Clock.PeriodFraction);
+
+			OCR0A = ((AudioArena.Clock.PeriodWhole - 1) + (Phase < AudioArena.Clock.Phase));
+			AudioArena.Clock.Phase = Phase;
+		}
+		#endif
+
+	/* Function Prototypes: */
+		void Clock_Init(void);
+		void Clock_SetRate(const uint32_t SampleRate);
+		void Clock_Start(void);
+		void Clock_Stop(void);
+		void Clock_StartOfFrame(const uint16_t Count,
+		                        const bool Consecutive);
+		void Clock_Task(void);
+		uint32_t Clock_GetFeedback(void);
+
+		#if defined(INCLUDE_FROM_CLOCK_C)
+			static void Clock_SetPeriod(const int32_t Period);
+		#endif
+
+#endif
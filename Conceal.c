@@ -0,0 +1,93 @@
+/** \file
+ *
+ *  Underrun concealment. When the sample ring runs dry, the sample ISR would otherwise send nothing, and the
+ *  receiver would hold the last sample it was sent until the ring has refilled; the step from that sample to
+ *  wherever the stream resumes is heard as a click. Instead the sample ISR fades the last frame played down to
+ *  midscale over \ref CONCEAL_FADE_MS, and once playback resumes crossfades from wherever the fade had got to
+ *  back into the stream over the same time. Both blends share one weight, which steps down to zero over the
+ *  fade; playback also starts with a crossfade from midscale, so a stream opens without a click too.
+ *
+ *  The fade and the crossfade run in the C sample ISR. The hand-written ISR in SampleISR.S leaves the frames of
+ *  a crossfade to it, as the single byte frame flag is held clear until the crossfade is over. Both are bypassed
+ *  for the speaker stream's 8-bit mono alternate setting, whose bytes must reach the link as the host sent them.
+ */
+
+#include "Conceal.h"
+
+/** Number of underruns concealed since the device was reset. */
+volatile uint16_t Conceal_Events;
+
+/** Set while the stream's samples must reach the link as sent, so underruns are neither faded nor crossfaded. */
+bool Conceal_Bypass;
+
+/** Sets the step of the fade weight for a new sample rate, so that fades last \ref CONCEAL_FADE_MS at any rate.
+ *
+ *  \param[in] SampleRate  New sample rate in Hz.
+ */
+void Conceal_SetRate(const uint32_t SampleRate)
+{
+	uint32_t Step = ((CONCEAL_WEIGHT_FULL * 1000UL) / (SampleRate * CONCEAL_FADE_MS));
+
+	AudioArena.Conceal.Step = (Step ? Step : 1);
+}
+
+/** Abandons any fade in progress, for a new stream or link layout. */
+void Conceal_Reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		AudioArena.Conceal.Level[0] = 0;
+		AudioArena.Conceal.Level[1] = 0;
+		AudioArena.Conceal.Weight   = 0;
+	}
+}
+
+/** Sets whether underruns are concealed, for a new link layout; this must follow \ref Conceal_Reset(). While
+ *  bypassed an underrun is still counted, but the receiver is left holding the last sample, and playback resumes
+ *  straight into the stream.
+ *
+ *  \param[in] Bypass  Boolean \c true if the stream's samples must reach the link unchanged.
+ */
+void Conceal_SetBypass(const bool Bypass)
+{
+	Conceal_Bypass = Bypass;
+}
+
+/** Starts the crossfade back into the stream, from the level the fade to midscale has reached. This must be
+ *  called from the main loop just before the ring is marked as primed. Does nothing while bypassed.
+ */
+void Conceal_Resume(void)
+{
+	if (Conceal_Bypass)
+	  return;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uint8_t Weight = AudioArena.Conceal.Weight;
+
+		AudioArena.Conceal.Level[0] = Conceal_Blend(0, AudioArena.Conceal.Level[0], Weight);
+		AudioArena.Conceal.Level[1] = Conceal_Blend(0, AudioArena.Conceal.Level[1], Weight);
+		AudioArena.Conceal.Weight   = CONCEAL_WEIGHT_FULL;
+
+		/* Hold the hand-written sample ISR off the crossfade's frames */
+		#if defined(SAMPLE_ISR_ASM)
+		SAMPLE_FLAGS &= ~(1 << SAMPLE_FLAG_BYTE_FRAMES);
+		#endif
+	}
+}
+
+/** Retrieves the number of underruns concealed since the device was reset.
+ *
+ *  \return Number of underruns concealed, saturating at \c UINT16_MAX.
+ */
+uint16_t Conceal_GetEvents(void)
+{
+	uint16_t Events;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Events = Conceal_Events;
+	}
+
+	return Events;
+}
@@ -0,0 +1,147 @@
+/** \file
+ *
+ *  Header file for Conceal.c.
+ */
+
+#ifndef _CONCEAL_H_
+#define _CONCEAL_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Arena.h"
+		#include "Link.h"
+		#include "SampleRing.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Weight of the concealment's starting level in the output at the start of a fade, in 1/256ths. */
+		#define CONCEAL_WEIGHT_FULL          255
+
+		/** Length in milliseconds of the fade to midscale after an underrun, and of the crossfade back into the
+		 *  stream when playback resumes. Short enough not to be heard as a dropout of its own, long enough that
+		 *  the step it replaces is no longer heard as a click.
+		 */
+		#define CONCEAL_FADE_MS              4
+
+	/* External Variables: */
+		extern volatile uint16_t Conceal_Events;
+		extern bool              Conceal_Bypass;
+
+	/* Inline Functions: */
+		/** Blends a sample with the concealment's level for one channel.
+		 *
+		 *  \param[in] Target  Sample the blend ends on: midscale while fading out, the stream once it resumes.
+		 *  \param[in] Level   Level the blend starts from.
+		 *  \param[in] Weight  Weight of \p Level in the result, in 1/256ths.
+		 *
+		 *  \return Blended sample.
+		 */
+		static inline int16_t Conceal_Blend(const int16_t Target,
+		                                    const int16_t Level,
+		                                    const uint8_t Weight)
+		{
+			return (Target + (int16_t)((((int32_t)Level - Target) * Weight) >> 8));
+		}
+
+		/** Takes the next weight of a fade or crossfade in progress, one step closer to zero.
+		 *
+		 *  \return Weight of the concealment's level in this frame.
+		 */
+		static inline uint8_t Conceal_NextWeight(void)
+		{
+			uint8_t Weight = AudioArena.Conceal.Weight;
+			uint8_t Step   = AudioArena.Conceal.Step;
+
+			Weight = (Weight > Step) ? (Weight - Step) : 0;
+			AudioArena.Conceal.Weight = Weight;
+
+			return Weight;
+		}
+
+		/** Starts the fade to midscale from the last frame played, as the sample ISR detects an underrun. The
+		 *  frame is still in the ring just behind its tail, as the ring has run dry. The underrun is only counted
+		 *  while the concealment is bypassed. This must be called from the sample ISR.
+		 *
+		 *  \param[in] FrameEntries  Number of ring entries in each frame.
+		 */
+		static inline void Conceal_Start(const uint8_t FrameEntries)
+		{
+			if (Conceal_Events != UINT16_MAX)
+			  Conceal_Events++;
+
+			if (Conceal_Bypass)
+			  return;
+
+			uint8_t Tail  = SampleRing_GetTail();
+			int16_t Left  = AudioArena.SampleRing.Data[(uint8_t)(Tail - FrameEntries) & SAMPLE_RING_MASK];
+			int16_t Right = (FrameEntries == 2) ? AudioArena.SampleRing.Data[(uint8_t)(Tail - 1) & SAMPLE_RING_MASK] : Left;
+
+			/* A crossfade still in progress means the last frame played was not quite the ring entry */
+			if (AudioArena.Conceal.Weight)
+			{
+				Left  = Conceal_Blend(Left,  AudioArena.Conceal.Level[0], AudioArena.Conceal.Weight);
+				Right = Conceal_Blend(Right, AudioArena.Conceal.Level[1], AudioArena.Conceal.Weight);
+			}
+
+			AudioArena.Conceal.Level[0] = Left;
+			AudioArena.Conceal.Level[1] = Right;
+			AudioArena.Conceal.Weight   = CONCEAL_WEIGHT_FULL;
+		}
+
+		/** Produces the next frame of the fade to midscale while the ring refills. This must be called from the
+		 *  sample ISR, while the ring is not primed.
+		 *
+		 *  \param[out] Left   Left, or mono, sample of the frame.
+		 *  \param[out] Right  Right sample of the frame.
+		 *
+		 *  \return Boolean \c true if a frame was produced, \c false if the fade is over and nothing need be sent
+		 */
+		static inline bool Conceal_Fade(int16_t* const Left,
+		                                int16_t* const Right)
+		{
+			if (!(AudioArena.Conceal.Weight))
+			  return false;
+
+			uint8_t Weight = Conceal_NextWeight();
+
+			*Left  = Conceal_Blend(0, AudioArena.Conceal.Level[0], Weight);
+			*Right = Conceal_Blend(0, AudioArena.Conceal.Level[1], Weight);
+			return true;
+		}
+
+		/** Crossfades a frame from the stream with the level the concealment had reached when playback resumed,
+		 *  for the first frames after it resumes. Once the crossfade is over, byte frames are handed back to the
+		 *  hand-written sample ISR. This must be called from the sample ISR, on every frame played.
+		 *
+		 *  \param[in,out] Left   Left, or mono, sample of the frame.
+		 *  \param[in,out] Right  Right sample of the frame.
+		 */
+		static inline void Conceal_Crossfade(int16_t* const Left,
+		                                     int16_t* const Right)
+		{
+			if (!(AudioArena.Conceal.Weight))
+			  return;
+
+			uint8_t Weight = Conceal_NextWeight();
+
+			*Left  = Conceal_Blend(*Left,  AudioArena.Conceal.Level[0], Weight);
+			*Right = Conceal_Blend(*Right, AudioArena.Conceal.Level[1], Weight);
+
+			#if defined(SAMPLE_ISR_ASM)
+			if (!(Weight) && !(Link_Format))
+			  SAMPLE_FLAGS |= (1 << SAMPLE_FLAG_BYTE_FRAMES);
+			#endif
+		}
+
+	/* Function Prototypes: */
+		void     Conceal_SetRate(const uint32_t SampleRate);
+		void     Conceal_Reset(void);
+		void     Conceal_SetBypass(const bool Bypass);
+		void     Conceal_Resume(void);
+		uint16_t Conceal_GetEvents(void);
+
+#endif
@@ -46,5 +46,36 @@
 	// #define AUDIO_OUT_STEREO
 	#define AUDIO_OUT_MONO
 //	#define AUDIO_OUT_PORTC
+	#define PORTC_DAC_BITS            12
+
+	#define LINK_BAUD                 LINK_BAUD_2M
+	#define LINK_FORMAT               LINK_FORMAT_16BIT
+
+	#define SAMPLE_RING_SIZE          64
+	#define SAMPLE_RING_DEPTH         0
+
+	#define MIC_RING_SIZE             16
+
+	#define AUDIO_ARENA_SIZE          160
+
+	#define AUDIO_MAX_SAMPLE_RATE     8000
+
+	#if !defined(DSP_STAGES)
+		#define DSP_STAGES            (DSP_STAGE_DC_BLOCK | DSP_STAGE_BIQUAD1 | DSP_STAGE_LIMITER)
+	#endif
+	#define DSP_BIQUAD1               {20626, -2777, 3605, 2206, 2864}
+	#define DSP_BIQUAD2               {16384, 0, 0, 0, 0}
+	#define DSP_LIMITER_THRESHOLD     29204
+
+//	#define AUDIO_CLASS_2
+
+//	#define VENDOR_STREAM
+
+//	#define SAMPLE_CLOCK_SOF_SYNC
+
+//	#define TRACE_EVENTS              16
+//	#define EMISSION_HISTOGRAM_BINS   16
+
+//	#define LEVEL_METER               10
 
 #endif
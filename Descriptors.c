@@ -47,12 +47,15 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor =
 	.Header                 = {.Size = sizeof(USB_Descriptor_Device_t), .Type = DTYPE_Device},
 
 	.USBSpecification       = VERSION_BCD(2,0,0),
+	#if defined(AUDIO_CLASS_2)
+	.Class                  = USB_CSCP_IADDeviceClass,
+	.SubClass               = USB_CSCP_IADDeviceSubclass,
+	.Protocol               = USB_CSCP_IADDeviceProtocol,
+	#else
 	.Class                  = USB_CSCP_NoDeviceClass,
 	.SubClass               = USB_CSCP_NoDeviceSubclass,
 	.Protocol               = USB_CSCP_NoDeviceProtocol,
-	// .Class                  = USB_CSCP_IADDeviceClass,
-	// .SubClass               = USB_CSCP_IADDeviceSubclass,
-	// .Protocol               = USB_CSCP_IADDeviceProtocol,
+	#endif
 
 	.Endpoint0Size          = FIXED_CONTROL_ENDPOINT_SIZE,
 
@@ -72,6 +75,7 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor =
  *  and endpoints. The descriptor is read out by the USB host during the enumeration process when selecting
  *  a configuration so that the host may correctly communicate with the USB device.
  */
+#if defined(AUDIO_CLASS_2)
 const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 {
 	.Config =
@@ -79,8 +83,533 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.Header                   = {.Size = sizeof(USB_Descriptor_Configuration_Header_t), .Type = DTYPE_Configuration},
 
 			.TotalConfigurationSize   = sizeof(USB_Descriptor_Configuration_t),
+			.TotalInterfaces          = DEVICE_TOTAL_INTERFACES,
+
+			.ConfigurationNumber      = 1,
+			.ConfigurationStrIndex    = NO_DESCRIPTOR,
+
+			.ConfigAttributes         = (USB_CONFIG_ATTR_RESERVED | USB_CONFIG_ATTR_SELFPOWERED),
+
+			.MaxPowerConsumption      = USB_CONFIG_POWER_MA(100)
+		},
+
+	.Audio_IAD =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_Association_t), .Type = DTYPE_InterfaceAssociation},
+
+			.FirstInterfaceIndex      = INTERFACE_ID_AudioControl,
 			.TotalInterfaces          = 3,
 
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = 0x00,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.IADStrIndex              = NO_DESCRIPTOR
+		},
+
+	.Audio_ControlInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioControl,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 0,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_ControlSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_ControlInterface_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Interface_AC_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_Header,
+
+			.ADCSpecification         = VERSION_BCD(2,0,0),
+			.Category                 = AUDIO2_CATEGORY_IOBox,
+			.TotalLength              = (sizeof(USB_Audio2_Descriptor_Interface_AC_t) +
+			                             sizeof(USB_Audio2_Descriptor_ClockSource_t) +
+			                             sizeof(USB_Audio2_Descriptor_InputTerminal_t) +
+			                             sizeof(USB_Audio2_Descriptor_MixerUnit_t) +
+			                             sizeof(USB_Audio2_Descriptor_OutputTerminal_t) +
+			                             sizeof(USB_Audio2_Descriptor_InputTerminal_t) +
+			                             sizeof(USB_Audio2_Descriptor_OutputTerminal_t)),
+
+			.Controls                 = 0
+		},
+
+	.Audio_ClockSource =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_ClockSource_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO2_DSUBTYPE_ClockSource,
+
+			.ClockID                  = AUDIO2_CLOCK_SOURCE_ID,
+			#if defined(SAMPLE_CLOCK_SOF_SYNC)
+			.Attributes               = 0x07, // Internal programmable clock, synchronized to the start of frame
+			#else
+			.Attributes               = 0x03, // Internal programmable clock
+			#endif
+			.Controls                 = 0x07, // Host programmable frequency, read only validity
+
+			.AssociatedTerminal       = 0x00,
+			.ClockStrIndex            = NO_DESCRIPTOR
+		},
+
+	.Audio_InputTerminal =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_InputTerminal_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_InputTerminal,
+
+			.TerminalID               = 0x1,
+			.TerminalType             = (AUDIO_TERMINAL_STREAMING),
+			.AssociatedOutputTerminal = 0x2,
+			.ClockSourceID            = AUDIO2_CLOCK_SOURCE_ID,
+
+			.TotalChannels            = AUDIO_IN_CHANNELS,
+			.ChannelConfig            = AUDIO_IN_CHANNEL_CONFIG,
+			.ChannelStrIndex          = NO_DESCRIPTOR,
+
+			.Controls                 = 0,
+			.TerminalStrIndex         = NO_DESCRIPTOR
+		},
+
+	.Audio_MixerUnit =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_MixerUnit_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_Mixer,
+
+			.UnitID                   = AUDIO_MIXER_UNIT_ID,
+			.TotalInputPins           = 1,
+			.SourceID                 = 0x01,
+
+			.TotalChannels            = MIX_OUTPUTS,
+			.ChannelConfig            = (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT),
+			.ChannelStrIndex          = NO_DESCRIPTOR,
+
+			.MixerControls            = AUDIO_MIXER_CONTROLS,
+			.Controls                 = 0,
+			.MixerStrIndex            = NO_DESCRIPTOR
+		},
+
+	.Audio_OutputTerminal =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_OutputTerminal_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_OutputTerminal,
+
+			.TerminalID               = 0x2,
+			.TerminalType             = 0x402,
+			.AssociatedInputTerminal  = 0x1,
+			.SourceID                 = AUDIO_MIXER_UNIT_ID,
+			.ClockSourceID            = AUDIO2_CLOCK_SOURCE_ID,
+
+			.Controls                 = 0,
+			.TerminalStrIndex         = NO_DESCRIPTOR
+		},
+
+	.Audio_InputTerminal2 =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_InputTerminal_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_InputTerminal,
+
+			.TerminalID               = 0x03,
+			.TerminalType             = (AUDIO_TERMINAL_IN_MIC),
+			.AssociatedOutputTerminal = 0x04,
+			.ClockSourceID            = AUDIO2_CLOCK_SOURCE_ID,
+
+			.TotalChannels            = 1,
+			.ChannelConfig            = 0,
+			.ChannelStrIndex          = NO_DESCRIPTOR,
+
+			.Controls                 = 0,
+			.TerminalStrIndex         = NO_DESCRIPTOR
+		},
+
+	.Audio_OutputTerminal2 =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_OutputTerminal_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_OutputTerminal,
+
+			.TerminalID               = 0x04,
+			.TerminalType             = (AUDIO_TERMINAL_STREAMING),
+			.AssociatedInputTerminal  = 0x00,
+			.SourceID                 = 0x03,
+			.ClockSourceID            = AUDIO2_CLOCK_SOURCE_ID,
+
+			.Controls                 = 0,
+			.TerminalStrIndex         = NO_DESCRIPTOR
+		},
+
+	.Audio_Extra_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
+			.AlternateSetting         = SPEAKER_ALT_Idle,
+
+			.TotalEndpoints           = 0,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_Out_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
+			.AlternateSetting         = SPEAKER_ALT_PCM,
+
+			.TotalEndpoints           = 2,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_Out_StreamInterface_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Interface_AS_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_General,
+
+			.TerminalLink             = 0x01,
+			.Controls                 = 0,
+			.FormatType               = 0x01,
+			.Formats                  = ((AUDIO_IN_SUBFRAME_SIZE == 1) ? 0x00000002 : 0x00000001),
+
+			.TotalChannels            = AUDIO_IN_CHANNELS,
+			.ChannelConfig            = AUDIO_IN_CHANNEL_CONFIG,
+			.ChannelStrIndex          = NO_DESCRIPTOR
+		},
+
+	.Audio_AudioFormat =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Format_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
+
+			.FormatType               = 0x01,
+			.SubslotSize              = AUDIO_IN_SUBFRAME_SIZE,
+			.BitResolution            = (AUDIO_IN_SUBFRAME_SIZE * 8)
+		},
+
+	.Audio_Out_StreamEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = AUDIO_STREAM_OUT_EPADDR,
+			.Attributes               = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_ASYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = AUDIO_STREAM_OUT_EPSIZE,
+			.PollingIntervalMS        = 0x01
+		},
+
+	.Audio_Out_StreamEndpoint_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_StreamEndpoint_Spc_t), .Type = DTYPE_CSEndpoint},
+			.Subtype                  = AUDIO_DSUBTYPE_CSEndpoint_General,
+
+			.Attributes               = 0x00,
+			.Controls                 = 0x00,
+			.LockDelayUnits           = 0x00,
+			.LockDelay                = 0x0000
+		},
+
+	.Audio_Out_FeedbackEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = AUDIO_STREAM_FEEDBACK_EPADDR,
+			.Attributes               = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_FEEDBACK),
+			.EndpointSize             = AUDIO_STREAM_FEEDBACK_EPSIZE,
+			.PollingIntervalMS        = 0x01
+		},
+
+	.Audio_Out_PCM8_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
+			.AlternateSetting         = SPEAKER_ALT_PCM8,
+
+			.TotalEndpoints           = 2,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_Out_PCM8_StreamInterface_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Interface_AS_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_General,
+
+			.TerminalLink             = 0x01,
+			.Controls                 = 0,
+			.FormatType               = 0x01,
+			.Formats                  = 0x00000002,
+
+			.TotalChannels            = 1,
+			.ChannelConfig            = 0,
+			.ChannelStrIndex          = NO_DESCRIPTOR
+		},
+
+	.Audio_PCM8_AudioFormat =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Format_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
+
+			.FormatType               = 0x01,
+			.SubslotSize              = 0x01,
+			.BitResolution            = 8
+		},
+
+	.Audio_Out_PCM8_StreamEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = AUDIO_STREAM_OUT_EPADDR,
+			.Attributes               = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_ASYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = AUDIO_STREAM_OUT_PCM8_EPSIZE,
+			.PollingIntervalMS        = 0x01
+		},
+
+	.Audio_Out_PCM8_StreamEndpoint_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_StreamEndpoint_Spc_t), .Type = DTYPE_CSEndpoint},
+			.Subtype                  = AUDIO_DSUBTYPE_CSEndpoint_General,
+
+			.Attributes               = 0x00,
+			.Controls                 = 0x00,
+			.LockDelayUnits           = 0x00,
+			.LockDelay                = 0x0000
+		},
+
+	.Audio_Out_PCM8_FeedbackEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = AUDIO_STREAM_FEEDBACK_EPADDR,
+			.Attributes               = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_FEEDBACK),
+			.EndpointSize             = AUDIO_STREAM_FEEDBACK_EPSIZE,
+			.PollingIntervalMS        = 0x01
+		},
+
+	.Audio_Extra_StreamInterface2 =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioInStream,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 0,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_In_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioInStream,
+			.AlternateSetting         = 1,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO2_CSCP_IPVersion0200,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_In_StreamInterface_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Interface_AS_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_General,
+
+			.TerminalLink             = 0x04,
+			.Controls                 = 0,
+			.FormatType               = 0x01,
+			.Formats                  = 0x00000001,
+
+			.TotalChannels            = 1,
+			.ChannelConfig            = 0,
+			.ChannelStrIndex          = NO_DESCRIPTOR
+		},
+
+	.Audio_AudioFormat2 =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_Format_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
+
+			.FormatType               = 0x01,
+			.SubslotSize              = 0x02,
+			.BitResolution            = 16
+		},
+
+	.Audio_In_StreamEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = AUDIO_STREAM_IN_EPADDR,
+			.Attributes               = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_ASYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = AUDIO_STREAM_IN_EPSIZE,
+			.PollingIntervalMS        = 0x01
+		},
+
+	.Audio_In_StreamEndpoint_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio2_Descriptor_StreamEndpoint_Spc_t), .Type = DTYPE_CSEndpoint},
+			.Subtype                  = AUDIO_DSUBTYPE_CSEndpoint_General,
+
+			.Attributes               = 0x00,
+			.Controls                 = 0x00,
+			.LockDelayUnits           = 0x00,
+			.LockDelay                = 0x0000
+		},
+
+	#if defined(VENDOR_STREAM)
+	.Vendor_Extra_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_VendorStream,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 0,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = AUDIO_IN_CHANNELS,
+			.Protocol                 = AUDIO_IN_SUBFRAME_SIZE,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Vendor_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_VendorStream,
+			.AlternateSetting         = 1,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = AUDIO_IN_CHANNELS,
+			.Protocol                 = AUDIO_IN_SUBFRAME_SIZE,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Vendor_StreamEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = VENDOR_STREAM_EPADDR,
+			.Attributes               = (EP_TYPE_BULK | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = VENDOR_STREAM_EPSIZE,
+			.PollingIntervalMS        = 0x00
+		},
+	#endif
+
+	#if defined(LEVEL_METER)
+	.Level_MeterInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_LevelMeter,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = USB_CSCP_NoSpecificSubclass,
+			.Protocol                 = USB_CSCP_NoSpecificProtocol,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Level_MeterEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = LEVEL_METER_EPADDR,
+			.Attributes               = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = LEVEL_METER_EPSIZE,
+			.PollingIntervalMS        = LEVEL_METER_POLLING_MS
+		},
+	#endif
+};
+
+/** Sample rates of the Audio Class 2.0 clock source, returned for a RANGE request of its sampling frequency
+ *  control. Each standard rate up to \c AUDIO_MAX_SAMPLE_RATE is a subrange of its own, as hosts enumerate
+ *  every step of a continuous range. Only the rates the link can carry are offered; see
+ *  \ref Audio2_GetSampleRateCount().
+ */
+const USB_Audio2_SampleRateRanges_t PROGMEM Audio2_SampleRateRanges =
+{
+	.TotalSubRanges = AUDIO2_SAMPLE_RATES,
+	.SubRanges      =
+		{
+			{8000, 8000, 0},
+			#if (AUDIO_MAX_SAMPLE_RATE >= 11025)
+			{11025, 11025, 0},
+			#endif
+			#if (AUDIO_MAX_SAMPLE_RATE >= 16000)
+			{16000, 16000, 0},
+			#endif
+			#if (AUDIO_MAX_SAMPLE_RATE >= 22050)
+			{22050, 22050, 0},
+			#endif
+			#if (AUDIO_MAX_SAMPLE_RATE >= 32000)
+			{32000, 32000, 0},
+			#endif
+			#if (AUDIO_MAX_SAMPLE_RATE >= 44100)
+			{44100, 44100, 0},
+			#endif
+			#if (AUDIO_MAX_SAMPLE_RATE >= 48000)
+			{48000, 48000, 0},
+			#endif
+		}
+};
+
+/** Determines how many of the clock source's sample rates are offered to the host, which are the rates the link
+ *  can carry at the fastest baud rate its probe found clean, in its leanest format. The rates are in ascending
+ *  order, so these are always the first entries of \ref Audio2_SampleRateRanges; the lowest is always offered.
+ *
+ *  \return Number of subranges of \ref Audio2_SampleRateRanges offered to the host.
+ */
+uint8_t Audio2_GetSampleRateCount(void)
+{
+	uint8_t Count = AUDIO2_SAMPLE_RATES;
+
+	while ((Count > 1) && !(Link_FitsBandwidth(Link_MaxBaud, 0, pgm_read_dword(&Audio2_SampleRateRanges.SubRanges[Count - 1].Minimum))))
+	  Count--;
+
+	return Count;
+}
+#else
+const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
+{
+	.Config =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Configuration_Header_t), .Type = DTYPE_Configuration},
+
+			.TotalConfigurationSize   = sizeof(USB_Descriptor_Configuration_t),
+			.TotalInterfaces          = DEVICE_TOTAL_INTERFACES,
+
 			.ConfigurationNumber      = 1,
 			.ConfigurationStrIndex    = NO_DESCRIPTOR,
 
@@ -124,6 +653,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.ACSpecification          = VERSION_BCD(1,0,0),
 			.TotalLength              = (sizeof(USB_Audio_Descriptor_Interface_AC_2_t) +
 			                             sizeof(USB_Audio_Descriptor_InputTerminal_t) +
+			                             sizeof(USB_Audio_Descriptor_MixerUnit_t) +
 			                             sizeof(USB_Audio_Descriptor_OutputTerminal_t)
 										  +
 			                             sizeof(USB_Audio_Descriptor_InputTerminal_t) +
@@ -144,13 +674,30 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			// .TerminalType             = (AUDIO_TERMINAL_IN_MIC | AUDIO_TERMINAL_STREAMING),
 			.AssociatedOutputTerminal = 0x2,
 
-			.TotalChannels            = 2,
-			.ChannelConfig            = (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT),
+			.TotalChannels            = AUDIO_IN_CHANNELS,
+			.ChannelConfig            = AUDIO_IN_CHANNEL_CONFIG,
 
 			.ChannelStrIndex          = NO_DESCRIPTOR,
 			.TerminalStrIndex         = NO_DESCRIPTOR
 		},
 
+	.Audio_MixerUnit =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio_Descriptor_MixerUnit_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_Mixer,
+
+			.UnitID                   = AUDIO_MIXER_UNIT_ID,
+			.TotalInputPins           = 1,
+			.SourceID                 = 0x01,
+
+			.TotalChannels            = MIX_OUTPUTS,
+			.ChannelConfig            = (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT),
+			.ChannelStrIndex          = NO_DESCRIPTOR,
+
+			.Controls                 = AUDIO_MIXER_CONTROLS,
+			.MixerStrIndex            = NO_DESCRIPTOR
+		},
+
 	.Audio_OutputTerminal =
 		{
 			.Header                   = {.Size = sizeof(USB_Audio_Descriptor_OutputTerminal_t), .Type = DTYPE_CSInterface},
@@ -161,7 +708,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			// .TerminalType             = (AUDIO_TERMINAL_OUT_SPEAKER),
 			.AssociatedInputTerminal  = 0x1,
 
-			.SourceID                 = 0x01,
+			.SourceID                 = AUDIO_MIXER_UNIT_ID,
 
 			.TerminalStrIndex         = NO_DESCRIPTOR
 		},
@@ -203,7 +750,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
 
 			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
-			.AlternateSetting         = 0,
+			.AlternateSetting         = SPEAKER_ALT_Idle,
 
 			.TotalEndpoints           = 0,
 
@@ -219,7 +766,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
 
 			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
-			.AlternateSetting         = 1,
+			.AlternateSetting         = SPEAKER_ALT_PCM,
 
 			.TotalEndpoints           = 1,
 
@@ -238,7 +785,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.TerminalLink             = 0x01,
 
 			.FrameDelay               = 1,
-			.AudioFormat              = 0x0001
+			.AudioFormat              = ((AUDIO_IN_SUBFRAME_SIZE == 1) ? 0x0002 : 0x0001)
 		},
 		.Audio_AudioFormat =
 			{
@@ -248,17 +795,17 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 				.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
 
 				.FormatType               = 0x01,
-				.Channels                 = 0x02,
+				.Channels                 = AUDIO_IN_CHANNELS,
 
-				.SubFrameSize             = 0x02,
-				.BitResolution            = 16,
+				.SubFrameSize             = AUDIO_IN_SUBFRAME_SIZE,
+				.BitResolution            = (AUDIO_IN_SUBFRAME_SIZE * 8),
 
 				.TotalDiscreteSampleRates = (sizeof(ConfigurationDescriptor.Audio_AudioFormatSampleRates) / sizeof(USB_Audio_SampleFreq_t)),
 			},
 
 		.Audio_AudioFormatSampleRates =
 			{
-				AUDIO_SAMPLE_FREQ(8000),
+				AUDIO_SAMPLE_FREQ(AUDIO_MAX_SAMPLE_RATE),
 				// AUDIO_SAMPLE_FREQ(11025),
 				// AUDIO_SAMPLE_FREQ(22050),
 				// AUDIO_SAMPLE_FREQ(44100),
@@ -293,6 +840,81 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.LockDelay                = 0x0000
 		},
 
+	.Audio_Out_PCM8_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_AudioOutStream,
+			.AlternateSetting         = SPEAKER_ALT_PCM8,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = AUDIO_CSCP_AudioClass,
+			.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+			.Protocol                 = AUDIO_CSCP_StreamingProtocol,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Audio_Out_PCM8_StreamInterface_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio_Descriptor_Interface_AS_t), .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_General,
+
+			.TerminalLink             = 0x01,
+
+			.FrameDelay               = 1,
+			.AudioFormat              = 0x0002
+		},
+
+	.Audio_PCM8_AudioFormat =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio_Descriptor_Format_t) +
+			                                     sizeof(ConfigurationDescriptor.Audio_PCM8_AudioFormatSampleRates),
+			                             .Type = DTYPE_CSInterface},
+			.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
+
+			.FormatType               = 0x01,
+			.Channels                 = 0x01,
+
+			.SubFrameSize             = 0x01,
+			.BitResolution            = 8,
+
+			.TotalDiscreteSampleRates = (sizeof(ConfigurationDescriptor.Audio_PCM8_AudioFormatSampleRates) / sizeof(USB_Audio_SampleFreq_t)),
+		},
+
+	.Audio_PCM8_AudioFormatSampleRates =
+		{
+			AUDIO_SAMPLE_FREQ(AUDIO_MAX_SAMPLE_RATE),
+		},
+
+	.Audio_Out_PCM8_StreamEndpoint =
+		{
+			.Endpoint =
+				{
+					.Header              = {.Size = sizeof(USB_Audio_Descriptor_StreamEndpoint_Std_t), .Type = DTYPE_Endpoint},
+
+					.EndpointAddress     = AUDIO_STREAM_OUT_EPADDR,
+					.Attributes          = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_SYNC | ENDPOINT_USAGE_DATA),
+					.EndpointSize        = AUDIO_STREAM_OUT_PCM8_EPSIZE,
+					.PollingIntervalMS   = 0x01
+				},
+
+			.Refresh                  = 0,
+			.SyncEndpointNumber       = 0
+		},
+
+	.Audio_Out_PCM8_StreamEndpoint_SPC =
+		{
+			.Header                   = {.Size = sizeof(USB_Audio_Descriptor_StreamEndpoint_Spc_t), .Type = DTYPE_CSEndpoint},
+			.Subtype                  = AUDIO_DSUBTYPE_CSEndpoint_General,
+
+			.Attributes               = (AUDIO_EP_ACCEPTS_SMALL_PACKETS | AUDIO_EP_SAMPLE_FREQ_CONTROL),
+
+			.LockDelayUnits           = 0x00,
+			.LockDelay                = 0x0000
+		},
+
 
 
 
@@ -395,8 +1017,81 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 
 			.LockDelayUnits           = 0x00,
 			.LockDelay                = 0x0000
-		}
+		},
+
+	#if defined(VENDOR_STREAM)
+	.Vendor_Extra_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_VendorStream,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 0,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = AUDIO_IN_CHANNELS,
+			.Protocol                 = AUDIO_IN_SUBFRAME_SIZE,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Vendor_StreamInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_VendorStream,
+			.AlternateSetting         = 1,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = AUDIO_IN_CHANNELS,
+			.Protocol                 = AUDIO_IN_SUBFRAME_SIZE,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Vendor_StreamEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = VENDOR_STREAM_EPADDR,
+			.Attributes               = (EP_TYPE_BULK | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = VENDOR_STREAM_EPSIZE,
+			.PollingIntervalMS        = 0x00
+		},
+	#endif
+
+	#if defined(LEVEL_METER)
+	.Level_MeterInterface =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+			.InterfaceNumber          = INTERFACE_ID_LevelMeter,
+			.AlternateSetting         = 0,
+
+			.TotalEndpoints           = 1,
+
+			.Class                    = USB_CSCP_VendorSpecificClass,
+			.SubClass                 = USB_CSCP_NoSpecificSubclass,
+			.Protocol                 = USB_CSCP_NoSpecificProtocol,
+
+			.InterfaceStrIndex        = NO_DESCRIPTOR
+		},
+
+	.Level_MeterEndpoint =
+		{
+			.Header                   = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress          = LEVEL_METER_EPADDR,
+			.Attributes               = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize             = LEVEL_METER_EPSIZE,
+			.PollingIntervalMS        = LEVEL_METER_POLLING_MS
+		},
+	#endif
 };
+#endif
 
 /** Language descriptor structure. This descriptor, located in FLASH memory, is returned when the host requests
  *  the string descriptor with index 0 (the first index). It is actually an array of 16-bit integers, which indicate
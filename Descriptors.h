@@ -41,6 +41,10 @@
 
 		#include <avr/pgmspace.h>
 
+		#include "Level.h"
+		#include "Link.h"
+		#include "Mix.h"
+		#include "VendorProtocol.h"
 		#include "Config/AppConfig.h"
 
 	/* Macros: */
@@ -48,10 +52,113 @@
 		#define AUDIO_STREAM_OUT_EPADDR           (ENDPOINT_DIR_OUT | 3)
 		#define AUDIO_STREAM_IN_EPADDR           (ENDPOINT_DIR_IN | 4)
 
+		#if defined(AUDIO_CLASS_2)
+			/** Number of frames in each packet of the speaker stream, at the highest advertised sample rate. The
+			 *  asynchronous stream of Audio Class 2.0 carries a frame more than nominal whenever the feedback asks.
+			 */
+			#define AUDIO_STREAM_OUT_FRAMES       ((AUDIO_MAX_SAMPLE_RATE / 1000) + 1)
+		#else
+			#define AUDIO_STREAM_OUT_FRAMES       (AUDIO_MAX_SAMPLE_RATE / 1000)
+		#endif
+
+		#if (AUDIO_IN_CHANNELS > 4)
+			/** Size in bytes of each sample in the speaker stream. Five and six channel streams carry 8-bit
+			 *  samples, as a packet of 16-bit samples would not fit in the largest endpoint of the USB AVRs.
+			 */
+			#define AUDIO_IN_SUBFRAME_SIZE        1
+		#else
+			#define AUDIO_IN_SUBFRAME_SIZE        2
+		#endif
+
 		/** Endpoint size in bytes of the Audio isochronous streaming data endpoint. */
-		#define AUDIO_STREAM_OUT_EPSIZE           32
+		#define AUDIO_STREAM_OUT_EPSIZE           (AUDIO_IN_CHANNELS * AUDIO_IN_SUBFRAME_SIZE * AUDIO_STREAM_OUT_FRAMES)
 		#define AUDIO_STREAM_IN_EPSIZE           32
 
+		/** Endpoint size in bytes of the speaker endpoint in the 8-bit mono alternate setting, one byte per frame. */
+		#define AUDIO_STREAM_OUT_PCM8_EPSIZE      AUDIO_STREAM_OUT_FRAMES
+
+		/** Number of banks of the speaker endpoint. Endpoints over 32 bytes take 64 bytes of the endpoint RAM
+		 *  per bank, so those are single banked to leave room for the microphone endpoint.
+		 */
+		#define AUDIO_STREAM_OUT_BANKS            ((AUDIO_STREAM_OUT_EPSIZE > 32) ? 1 : 2)
+
+		/** Endpoint address, size and number of banks of the bulk endpoint of the vendor streaming interface. */
+		#define VENDOR_STREAM_EPADDR              (ENDPOINT_DIR_OUT | 2)
+		#define VENDOR_STREAM_EPSIZE              16
+		#define VENDOR_STREAM_BANKS               2
+
+		/** Endpoint address and size of the interrupt endpoint of the level meter interface, and its polling
+		 *  interval in milliseconds: the report period, or the longest interval a full speed endpoint may ask for.
+		 */
+		#define LEVEL_METER_EPADDR                (ENDPOINT_DIR_IN | 2)
+		#define LEVEL_METER_EPSIZE                32
+		#define LEVEL_METER_POLLING_MS            ((LEVEL_PERIOD_MS > 255) ? 255 : LEVEL_PERIOD_MS)
+
+		/** Number of interfaces in the configuration, with the vendor streaming interface or the level meter
+		 *  interface after the audio function.
+		 */
+		#if defined(VENDOR_STREAM) || defined(LEVEL_METER)
+			#define DEVICE_TOTAL_INTERFACES       4
+		#else
+			#define DEVICE_TOTAL_INTERFACES       3
+		#endif
+
+		/** Unit ID of the mixer unit holding the downmix matrix, between the speaker stream's terminals. */
+		#define AUDIO_MIXER_UNIT_ID               0x05
+
+		/** Endpoint address and size of the explicit feedback endpoint of the Audio Class 2.0 speaker stream. */
+		#define AUDIO_STREAM_FEEDBACK_EPADDR      (ENDPOINT_DIR_IN | 1)
+		#define AUDIO_STREAM_FEEDBACK_EPSIZE      3
+
+		/** Entity ID of the Audio Class 2.0 clock source, shared by both streams. */
+		#define AUDIO2_CLOCK_SOURCE_ID            0x06
+
+		/** Interface protocol, descriptor subtype, function category and request codes of Audio Class 2.0, which
+		 *  LUFA does not provide.
+		 */
+		#define AUDIO2_CSCP_IPVersion0200         0x20
+		#define AUDIO2_DSUBTYPE_ClockSource       0x0A
+		#define AUDIO2_CATEGORY_IOBox             0x08
+		#define AUDIO2_REQ_CUR                    0x01
+		#define AUDIO2_REQ_RANGE                  0x02
+
+		/** Control selectors of the Audio Class 2.0 clock source. */
+		#define AUDIO2_CS_SAM_FREQ_CONTROL        0x01
+		#define AUDIO2_CS_CLOCK_VALID_CONTROL     0x02
+
+		/** Number of standard sample rates the Audio Class 2.0 clock source offers, from 8kHz up to
+		 *  \c AUDIO_MAX_SAMPLE_RATE.
+		 */
+		#define AUDIO2_SAMPLE_RATES               (1 + (AUDIO_MAX_SAMPLE_RATE >= 11025) + (AUDIO_MAX_SAMPLE_RATE >= 16000) + \
+		                                           (AUDIO_MAX_SAMPLE_RATE >= 22050) + (AUDIO_MAX_SAMPLE_RATE >= 32000) + \
+		                                           (AUDIO_MAX_SAMPLE_RATE >= 44100) + (AUDIO_MAX_SAMPLE_RATE >= 48000))
+
+		/** Size in bytes of the mixer unit's bitmap of programmable crosspoints. */
+		#define AUDIO_MIXER_CONTROLS_SIZE         (((AUDIO_IN_CHANNELS * MIX_OUTPUTS) + 7) / 8)
+
+		#if (AUDIO_IN_CHANNELS == 1)
+			/** Spatial locations of the speaker stream channels, and the mixer unit's bitmap marking every
+			 *  crosspoint programmable, most significant bit first.
+			 */
+			#define AUDIO_IN_CHANNEL_CONFIG       0
+			#define AUDIO_MIXER_CONTROLS          {0xC0}
+		#elif (AUDIO_IN_CHANNELS == 2)
+			#define AUDIO_IN_CHANNEL_CONFIG       (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT)
+			#define AUDIO_MIXER_CONTROLS          {0xF0}
+		#elif (AUDIO_IN_CHANNELS == 4)
+			#define AUDIO_IN_CHANNEL_CONFIG       (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT | \
+			                                       AUDIO_CHANNEL_LEFT_SURROUND | AUDIO_CHANNEL_RIGHT_SURROUND)
+			#define AUDIO_MIXER_CONTROLS          {0xFF}
+		#elif (AUDIO_IN_CHANNELS == 5)
+			#define AUDIO_IN_CHANNEL_CONFIG       (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT | AUDIO_CHANNEL_CENTER_FRONT | \
+			                                       AUDIO_CHANNEL_LEFT_SURROUND | AUDIO_CHANNEL_RIGHT_SURROUND)
+			#define AUDIO_MIXER_CONTROLS          {0xFF, 0xC0}
+		#else
+			#define AUDIO_IN_CHANNEL_CONFIG       (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT | AUDIO_CHANNEL_CENTER_FRONT | \
+			                                       AUDIO_CHANNEL_LOW_FREQ_ENHANCE | AUDIO_CHANNEL_LEFT_SURROUND | AUDIO_CHANNEL_RIGHT_SURROUND)
+			#define AUDIO_MIXER_CONTROLS          {0xFF, 0xF0}
+		#endif
+
 				typedef struct
 				{
 					USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
@@ -70,8 +177,233 @@
 					uint8_t                 InterfaceNumber2; /**< Interface number of the associated Audio Streaming interface. */
 				} ATTR_PACKED USB_Audio_Descriptor_Interface_AC_2_t;
 
-				
+				/** Type define for an Audio class mixer unit descriptor with a single input pin, which LUFA
+				 *  does not provide as its size depends on the number of channels.
+				 */
+				typedef struct
+				{
+					USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+					uint8_t                 Subtype; /**< Sub type value used to distinguish between audio class-specific descriptors,
+					                                  *   must be \ref AUDIO_DSUBTYPE_CSInterface_Mixer.
+					                                  */
+
+					uint8_t                 UnitID; /**< ID value of this unit within the device. */
+					uint8_t                 TotalInputPins; /**< Number of input pins of the unit (must be 1). */
+					uint8_t                 SourceID; /**< ID of the unit or terminal connected to the input pin. */
+
+					uint8_t                 TotalChannels; /**< Total number of separate audio channels of the unit's output. */
+					uint16_t                ChannelConfig; /**< \c AUDIO_CHANNEL_* masks describing the output channels. */
+					uint8_t                 ChannelStrIndex; /**< Index of a string descriptor describing the output channels. */
+
+					uint8_t                 Controls[AUDIO_MIXER_CONTROLS_SIZE]; /**< Bitmap of programmable crosspoints. */
+					uint8_t                 MixerStrIndex; /**< Index of a string descriptor describing this unit. */
+				} ATTR_PACKED USB_Audio_Descriptor_MixerUnit_t;
+
+	/* Preprocessor Checks: */
+		#if defined(AUDIO_CLASS_2) && (AUDIO_STREAM_OUT_EPSIZE > 64)
+			#error The Audio Class 2.0 speaker endpoint would exceed 64 bytes, reduce AUDIO_IN_CHANNELS or AUDIO_MAX_SAMPLE_RATE.
+		#endif
+
+		#if defined(VENDOR_STREAM) && (VENDOR_STREAM_EPSIZE % (AUDIO_IN_CHANNELS * AUDIO_IN_SUBFRAME_SIZE))
+			#error Each packet of the vendor stream must hold whole frames, so VENDOR_STREAM needs 1, 2 or 4 AUDIO_IN_CHANNELS.
+		#endif
+
+		#if defined(VENDOR_STREAM) && defined(LEVEL_METER)
+			#error The vendor stream and the level meter both use endpoint 2, and the endpoint RAM has no room for a fifth endpoint.
+		#endif
+
 	/* Type Defines: */
+		#if defined(AUDIO_CLASS_2) || defined(__DOXYGEN__)
+		/** Type define for the Audio Class 2.0 class-specific audio control interface header. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_Header. */
+
+			uint16_t                ADCSpecification; /**< Binary Coded Decimal version of the specification, 2.00. */
+			uint8_t                 Category; /**< Primary use of the audio function, an \c AUDIO2_CATEGORY_* value. */
+			uint16_t                TotalLength; /**< Total length of the class-specific descriptors, including this one. */
+			uint8_t                 Controls; /**< Bitmap of the latency control. */
+		} ATTR_PACKED USB_Audio2_Descriptor_Interface_AC_t;
+
+		/** Type define for an Audio Class 2.0 clock source descriptor. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO2_DSUBTYPE_ClockSource. */
+
+			uint8_t                 ClockID; /**< ID value of this clock source within the device. */
+			uint8_t                 Attributes; /**< Clock type, and whether the clock is synchronized to the start of frame. */
+			uint8_t                 Controls; /**< Bitmaps of the frequency and validity controls. */
+			uint8_t                 AssociatedTerminal; /**< ID of the terminal the clock is derived from, if any. */
+			uint8_t                 ClockStrIndex; /**< Index of a string descriptor describing this clock. */
+		} ATTR_PACKED USB_Audio2_Descriptor_ClockSource_t;
+
+		/** Type define for an Audio Class 2.0 input terminal descriptor. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_InputTerminal. */
+
+			uint8_t                 TerminalID; /**< ID value of this terminal within the device. */
+			uint16_t                TerminalType; /**< Type of the terminal, an \c AUDIO_TERMINAL_* value. */
+			uint8_t                 AssociatedOutputTerminal; /**< ID of a paired output terminal, or zero. */
+			uint8_t                 ClockSourceID; /**< ID of the clock source of the terminal. */
+
+			uint8_t                 TotalChannels; /**< Total number of separate audio channels of the terminal. */
+			uint32_t                ChannelConfig; /**< \c AUDIO_CHANNEL_* masks describing the channels. */
+			uint8_t                 ChannelStrIndex; /**< Index of a string descriptor describing the channels. */
+
+			uint16_t                Controls; /**< Bitmaps of the terminal's controls. */
+			uint8_t                 TerminalStrIndex; /**< Index of a string descriptor describing this terminal. */
+		} ATTR_PACKED USB_Audio2_Descriptor_InputTerminal_t;
+
+		/** Type define for an Audio Class 2.0 output terminal descriptor. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_OutputTerminal. */
+
+			uint8_t                 TerminalID; /**< ID value of this terminal within the device. */
+			uint16_t                TerminalType; /**< Type of the terminal, an \c AUDIO_TERMINAL_* value. */
+			uint8_t                 AssociatedInputTerminal; /**< ID of a paired input terminal, or zero. */
+			uint8_t                 SourceID; /**< ID of the unit or terminal connected to the terminal's input. */
+			uint8_t                 ClockSourceID; /**< ID of the clock source of the terminal. */
+
+			uint16_t                Controls; /**< Bitmaps of the terminal's controls. */
+			uint8_t                 TerminalStrIndex; /**< Index of a string descriptor describing this terminal. */
+		} ATTR_PACKED USB_Audio2_Descriptor_OutputTerminal_t;
+
+		/** Type define for an Audio Class 2.0 mixer unit descriptor with a single input pin. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_Mixer. */
+
+			uint8_t                 UnitID; /**< ID value of this unit within the device. */
+			uint8_t                 TotalInputPins; /**< Number of input pins of the unit (must be 1). */
+			uint8_t                 SourceID; /**< ID of the unit or terminal connected to the input pin. */
+
+			uint8_t                 TotalChannels; /**< Total number of separate audio channels of the unit's output. */
+			uint32_t                ChannelConfig; /**< \c AUDIO_CHANNEL_* masks describing the output channels. */
+			uint8_t                 ChannelStrIndex; /**< Index of a string descriptor describing the output channels. */
+
+			uint8_t                 MixerControls[AUDIO_MIXER_CONTROLS_SIZE]; /**< Bitmap of programmable crosspoints. */
+			uint8_t                 Controls; /**< Bitmaps of the unit's other controls. */
+			uint8_t                 MixerStrIndex; /**< Index of a string descriptor describing this unit. */
+		} ATTR_PACKED USB_Audio2_Descriptor_MixerUnit_t;
+
+		/** Type define for an Audio Class 2.0 class-specific audio streaming interface descriptor. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_General. */
+
+			uint8_t                 TerminalLink; /**< ID of the terminal the interface is connected to. */
+			uint8_t                 Controls; /**< Bitmaps of the alternate setting controls. */
+			uint8_t                 FormatType; /**< Format type of the stream, 1 for type I. */
+			uint32_t                Formats; /**< Bitmap of the type I formats of the stream, bit 0 for PCM and bit 1 for PCM8. */
+
+			uint8_t                 TotalChannels; /**< Total number of separate audio channels of the stream. */
+			uint32_t                ChannelConfig; /**< \c AUDIO_CHANNEL_* masks describing the channels. */
+			uint8_t                 ChannelStrIndex; /**< Index of a string descriptor describing the channels. */
+		} ATTR_PACKED USB_Audio2_Descriptor_Interface_AS_t;
+
+		/** Type define for an Audio Class 2.0 type I format descriptor, which unlike its Audio Class 1.0 counterpart
+		 *  carries no sample rates; those are read from the clock source instead.
+		 */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSInterface_FormatType. */
+
+			uint8_t                 FormatType; /**< Format type, 1 for type I. */
+			uint8_t                 SubslotSize; /**< Size in bytes of each sample. */
+			uint8_t                 BitResolution; /**< Number of significant bits in each sample. */
+		} ATTR_PACKED USB_Audio2_Descriptor_Format_t;
+
+		/** Type define for an Audio Class 2.0 class-specific isochronous audio data endpoint descriptor. */
+		typedef struct
+		{
+			USB_Descriptor_Header_t Header; /**< Regular descriptor header containing the descriptor's type and length. */
+			uint8_t                 Subtype; /**< Must be \ref AUDIO_DSUBTYPE_CSEndpoint_General. */
+
+			uint8_t                 Attributes; /**< Whether packets must be of the maximum size. */
+			uint8_t                 Controls; /**< Bitmaps of the endpoint's controls. */
+			uint8_t                 LockDelayUnits; /**< Units of the \c LockDelay field. */
+			uint16_t                LockDelay; /**< Time the endpoint takes to lock to the clock. */
+		} ATTR_PACKED USB_Audio2_Descriptor_StreamEndpoint_Spc_t;
+
+		/** Type define for the reply to an Audio Class 2.0 RANGE request of the clock source's sampling frequency
+		 *  control, listing each rate as a subrange of its own.
+		 */
+		typedef struct
+		{
+			uint16_t TotalSubRanges; /**< Number of subranges which follow. */
+
+			struct
+			{
+				uint32_t Minimum; /**< Lowest sample rate of the subrange, in Hz. */
+				uint32_t Maximum; /**< Highest sample rate of the subrange, in Hz. */
+				uint32_t Resolution; /**< Step between the rates of the subrange, in Hz. */
+			} ATTR_PACKED SubRanges[AUDIO2_SAMPLE_RATES];
+		} ATTR_PACKED USB_Audio2_SampleRateRanges_t;
+
+		/** Type define for the device configuration descriptor structure in Audio Class 2.0 mode, where the
+		 *  interfaces are grouped by an interface association and the streams share a clock source. The speaker
+		 *  stream is asynchronous, with an explicit feedback endpoint to set the rate the host sends at.
+		 */
+		typedef struct
+		{
+			USB_Descriptor_Configuration_Header_t      Config;
+			USB_Descriptor_Interface_Association_t     Audio_IAD;
+
+			// Audio Control Interface
+			USB_Descriptor_Interface_t                 Audio_ControlInterface;
+			USB_Audio2_Descriptor_Interface_AC_t       Audio_ControlInterface_SPC;
+			USB_Audio2_Descriptor_ClockSource_t        Audio_ClockSource;
+			USB_Audio2_Descriptor_InputTerminal_t      Audio_InputTerminal;
+			USB_Audio2_Descriptor_MixerUnit_t          Audio_MixerUnit;
+			USB_Audio2_Descriptor_OutputTerminal_t     Audio_OutputTerminal;
+			USB_Audio2_Descriptor_InputTerminal_t      Audio_InputTerminal2;
+			USB_Audio2_Descriptor_OutputTerminal_t     Audio_OutputTerminal2;
+
+			// Audio Streaming Interface
+			USB_Descriptor_Interface_t                 Audio_Extra_StreamInterface;
+			USB_Descriptor_Interface_t                 Audio_Out_StreamInterface;
+			USB_Audio2_Descriptor_Interface_AS_t       Audio_Out_StreamInterface_SPC;
+			USB_Audio2_Descriptor_Format_t             Audio_AudioFormat;
+			USB_Descriptor_Endpoint_t                  Audio_Out_StreamEndpoint;
+			USB_Audio2_Descriptor_StreamEndpoint_Spc_t Audio_Out_StreamEndpoint_SPC;
+			USB_Descriptor_Endpoint_t                  Audio_Out_FeedbackEndpoint;
+			USB_Descriptor_Interface_t                 Audio_Out_PCM8_StreamInterface;
+			USB_Audio2_Descriptor_Interface_AS_t       Audio_Out_PCM8_StreamInterface_SPC;
+			USB_Audio2_Descriptor_Format_t             Audio_PCM8_AudioFormat;
+			USB_Descriptor_Endpoint_t                  Audio_Out_PCM8_StreamEndpoint;
+			USB_Audio2_Descriptor_StreamEndpoint_Spc_t Audio_Out_PCM8_StreamEndpoint_SPC;
+			USB_Descriptor_Endpoint_t                  Audio_Out_PCM8_FeedbackEndpoint;
+			USB_Descriptor_Interface_t                 Audio_Extra_StreamInterface2;
+			USB_Descriptor_Interface_t                 Audio_In_StreamInterface;
+			USB_Audio2_Descriptor_Interface_AS_t       Audio_In_StreamInterface_SPC;
+			USB_Audio2_Descriptor_Format_t             Audio_AudioFormat2;
+			USB_Descriptor_Endpoint_t                  Audio_In_StreamEndpoint;
+			USB_Audio2_Descriptor_StreamEndpoint_Spc_t Audio_In_StreamEndpoint_SPC;
+
+			#if defined(VENDOR_STREAM)
+			// Vendor Streaming Interface
+			USB_Descriptor_Interface_t                 Vendor_Extra_StreamInterface;
+			USB_Descriptor_Interface_t                 Vendor_StreamInterface;
+			USB_Descriptor_Endpoint_t                  Vendor_StreamEndpoint;
+			#endif
+
+			#if defined(LEVEL_METER)
+			// Level Meter Interface
+			USB_Descriptor_Interface_t                 Level_MeterInterface;
+			USB_Descriptor_Endpoint_t                  Level_MeterEndpoint;
+			#endif
+		} USB_Descriptor_Configuration_t;
+		#else
+
 		/** Type define for the device configuration descriptor structure. This must be defined in the
 		 *  application code, as the configuration descriptor contains several sub-descriptors which
 		 *  vary between devices, and which describe the device's usage to the host.
@@ -85,6 +417,7 @@
 			USB_Descriptor_Interface_t                Audio_ControlInterface;
 			USB_Audio_Descriptor_Interface_AC_2_t       Audio_ControlInterface_SPC;
 			USB_Audio_Descriptor_InputTerminal_t      Audio_InputTerminal;
+			USB_Audio_Descriptor_MixerUnit_t          Audio_MixerUnit;
 			USB_Audio_Descriptor_OutputTerminal_t     Audio_OutputTerminal;
 			USB_Audio_Descriptor_InputTerminal_t      Audio_InputTerminal2;
 			USB_Audio_Descriptor_OutputTerminal_t     Audio_OutputTerminal2;
@@ -97,6 +430,12 @@
 			USB_Audio_SampleFreq_t                    Audio_AudioFormatSampleRates[1];
 			USB_Audio_Descriptor_StreamEndpoint_Std_t Audio_Out_StreamEndpoint;
 			USB_Audio_Descriptor_StreamEndpoint_Spc_t Audio_Out_StreamEndpoint_SPC;
+			USB_Descriptor_Interface_t                Audio_Out_PCM8_StreamInterface;
+			USB_Audio_Descriptor_Interface_AS_t       Audio_Out_PCM8_StreamInterface_SPC;
+			USB_Audio_Descriptor_Format_t             Audio_PCM8_AudioFormat;
+			USB_Audio_SampleFreq_t                    Audio_PCM8_AudioFormatSampleRates[1];
+			USB_Audio_Descriptor_StreamEndpoint_Std_t Audio_Out_PCM8_StreamEndpoint;
+			USB_Audio_Descriptor_StreamEndpoint_Spc_t Audio_Out_PCM8_StreamEndpoint_SPC;
 			USB_Descriptor_Interface_t                Audio_Extra_StreamInterface2;
 			USB_Descriptor_Interface_t                Audio_In_StreamInterface;
 			USB_Audio_Descriptor_Interface_AS_t       Audio_In_StreamInterface_SPC;
@@ -104,7 +443,21 @@
 			USB_Audio_SampleFreq_t                    Audio_AudioFormatSampleRates2[1];
 			USB_Audio_Descriptor_StreamEndpoint_Std_t Audio_In_StreamEndpoint;
 			USB_Audio_Descriptor_StreamEndpoint_Spc_t Audio_In_StreamEndpoint_SPC;
+
+			#if defined(VENDOR_STREAM)
+			// Vendor Streaming Interface
+			USB_Descriptor_Interface_t                Vendor_Extra_StreamInterface;
+			USB_Descriptor_Interface_t                Vendor_StreamInterface;
+			USB_Descriptor_Endpoint_t                 Vendor_StreamEndpoint;
+			#endif
+
+			#if defined(LEVEL_METER)
+			// Level Meter Interface
+			USB_Descriptor_Interface_t                Level_MeterInterface;
+			USB_Descriptor_Endpoint_t                 Level_MeterEndpoint;
+			#endif
 		} USB_Descriptor_Configuration_t;
+		#endif
 
 		/** Enum for the device interface descriptor IDs within the device. Each interface descriptor
 		 *  should have a unique ID index associated with it, which can be used to refer to the
@@ -115,6 +468,8 @@
 			INTERFACE_ID_AudioControl = 0, /**< Audio control interface descriptor ID */
 			INTERFACE_ID_AudioOutStream  = 1, /**< Audio stream interface descriptor ID */
 			INTERFACE_ID_AudioInStream  = 2, /**< Audio stream interface descriptor ID */
+			INTERFACE_ID_VendorStream   = 3, /**< Vendor stream interface descriptor ID, with \c VENDOR_STREAM */
+			INTERFACE_ID_LevelMeter     = 3, /**< Level meter interface descriptor ID, with \c LEVEL_METER */
 		};
 
 		/** Enum for the device string descriptor IDs within the device. Each string descriptor should
@@ -128,10 +483,19 @@
 			STRING_ID_Product      = 2, /**< Product string ID */
 		};
 
+	/* External Variables: */
+		#if defined(AUDIO_CLASS_2)
+		extern const USB_Audio2_SampleRateRanges_t PROGMEM Audio2_SampleRateRanges;
+		#endif
+
 	/* Function Prototypes: */
 		uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
 		                                    const uint16_t wIndex,
 		                                    const void** const DescriptorAddress)
 		                                    ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(3);
 
+		#if defined(AUDIO_CLASS_2)
+		uint8_t Audio2_GetSampleRateCount(void);
+		#endif
+
 #endif
@@ -0,0 +1,225 @@
+/** \file
+ *
+ *  Fixed point processing chain, run on each frame between the downmix matrix and the sample ring so that it
+ *  sees the full 16-bit samples before the link or the DAC reduces them. The chain is a DC blocking high-pass,
+ *  up to two biquads to compensate for the response of the output stage, and a peak limiter without look-ahead
+ *  to keep the result off the rails. Stages left out of \c DSP_STAGES are not compiled in; the others can be
+ *  switched on and off at runtime through the settings, as long as the chain fits its cycle budget at the
+ *  current sample rate.
+ */
+
+#include "Dsp.h"
+
+#if (DSP_STAGES & DSP_STAGE_BIQUAD2)
+	#define DSP_BIQUADS 2
+#elif (DSP_STAGES & DSP_STAGE_BIQUAD1)
+	#define DSP_BIQUADS 1
+#endif
+
+/** Type define for the state of the chain for one channel. */
+typedef struct
+{
+	#if (DSP_STAGES & DSP_STAGE_DC_BLOCK)
+	int32_t  DCAccumulator; /**< Output of the DC blocker, with 8 fractional bits */
+	int16_t  DCPrevious; /**< Previous input of the DC blocker */
+	#endif
+	#if defined(DSP_BIQUADS)
+	int16_t  Biquad[DSP_BIQUADS][4]; /**< Previous two inputs and outputs of each biquad */
+	#endif
+	#if (DSP_STAGES & DSP_STAGE_LIMITER)
+	uint16_t LimiterGain; /**< Q1.15 limiter gain */
+	#endif
+} DspChannel_t;
+
+#if defined(DSP_BIQUADS)
+/** Q2.14 b0, b1, b2, a1 and a2 coefficients of each biquad. */
+static const int16_t PROGMEM Dsp_BiquadCoefficients[DSP_BIQUADS][5] =
+	{
+		DSP_BIQUAD1,
+		#if (DSP_BIQUADS == 2)
+		DSP_BIQUAD2,
+		#endif
+	};
+#endif
+
+/** Mask of \c DSP_STAGE_* flags of the stages currently running. */
+uint8_t Dsp_Stages;
+
+/** Number of channels in each frame. */
+static uint8_t      Dsp_Entries = 1;
+
+/** Current sample rate in Hz. */
+static uint32_t     Dsp_SampleRate = AUDIO_MAX_SAMPLE_RATE;
+
+/** State of the chain for each channel. */
+static DspChannel_t Dsp_Channels[MIX_OUTPUTS];
+
+/** Publishes the estimated cost of the compiled in chain, which Tools/ramreport.py reports after each build. */
+void Dsp_Init(void)
+{
+	#if defined(__AVR__)
+	__asm__ __volatile__ (".global __dsp_cycles_mono"   "\n\t" ".set __dsp_cycles_mono, %c0"   "\n\t"
+	                      ".global __dsp_cycles_stereo" "\n\t" ".set __dsp_cycles_stereo, %c1" "\n\t"
+	                      ".global __dsp_cycle_budget"  "\n\t" ".set __dsp_cycle_budget, %c2"
+	                      :
+	                      : "i" (DSP_CYCLES(DSP_STAGES)), "i" (DSP_CYCLES(DSP_STAGES) * 2),
+	                        "i" (DSP_CYCLE_BUDGET(AUDIO_MAX_SAMPLE_RATE)));
+	#endif
+
+	Dsp_Configure(DSP_STAGES, 1);
+}
+
+/** Sets the sample rate the cycle budget is checked against. The chain is not reconfigured until the next
+ *  call to \ref Dsp_Configure().
+ *
+ *  \param[in] SampleRate  New sample rate in Hz.
+ */
+void Dsp_SetRate(const uint32_t SampleRate)
+{
+	Dsp_SampleRate = SampleRate;
+}
+
+/** Determines if a chain fits the cycle budget at the current sample rate.
+ *
+ *  \param[in] Stages   Mask of \c DSP_STAGE_* flags.
+ *  \param[in] Entries  Number of channels in each frame.
+ *
+ *  \return Boolean \c true if the chain fits the budget, \c false otherwise
+ */
+bool Dsp_IsWithinBudget(const uint8_t Stages,
+                        const uint8_t Entries)
+{
+	return ((uint32_t)(DSP_CYCLES(Stages) * Entries) <= DSP_CYCLE_BUDGET(Dsp_SampleRate));
+}
+
+/** Reduces a chain to the stages which are compiled in and fit the budget at the current sample rate. If the
+ *  chain does not fit, the second biquad, the first biquad and the DC blocker are dropped in turn, keeping the
+ *  limiter for as long as possible.
+ *
+ *  \param[in] Stages   Mask of \c DSP_STAGE_* flags.
+ *  \param[in] Entries  Number of channels in each frame.
+ *
+ *  \return Mask of the \c DSP_STAGE_* flags kept
+ */
+uint8_t Dsp_FitStages(const uint8_t Stages,
+                      const uint8_t Entries)
+{
+	static const uint8_t DropOrder[] = {DSP_STAGE_BIQUAD2, DSP_STAGE_BIQUAD1, DSP_STAGE_DC_BLOCK, DSP_STAGE_LIMITER};
+
+	uint8_t Active = (Stages & DSP_STAGES);
+
+	for (uint8_t i = 0; (i < sizeof(DropOrder)) && !(Dsp_IsWithinBudget(Active, Entries)); i++)
+	  Active &= ~DropOrder[i];
+
+	return Active;
+}
+
+/** Selects the stages to run and the number of channels in each frame, and clears the state of the chain for
+ *  a new stream. The stages are reduced with \ref Dsp_FitStages() to those which fit.
+ *
+ *  \param[in] Stages   Mask of \c DSP_STAGE_* flags.
+ *  \param[in] Entries  Number of channels in each frame.
+ */
+void Dsp_Configure(const uint8_t Stages,
+                   const uint8_t Entries)
+{
+	uint8_t Active = Dsp_FitStages(Stages, Entries);
+
+	Dsp_Stages  = Active;
+	Dsp_Entries = Entries;
+
+	memset(Dsp_Channels, 0, sizeof(Dsp_Channels));
+
+	#if (DSP_STAGES & DSP_STAGE_LIMITER)
+	for (uint8_t Channel = 0; Channel < MIX_OUTPUTS; Channel++)
+	  Dsp_Channels[Channel].LimiterGain = DSP_LIMITER_UNITY;
+	#endif
+}
+
+/** Runs the enabled stages over one frame, in place.
+ *
+ *  \param[in,out] Frame  One sample for each channel of the frame.
+ */
+void Dsp_Process(int16_t* Frame)
+{
+	DspChannel_t* State  = Dsp_Channels;
+	#if (DSP_STAGES)
+	uint8_t       Stages = Dsp_Stages;
+	#endif
+
+	for (uint8_t Channel = 0; Channel < Dsp_Entries; Channel++)
+	{
+		int16_t Sample = *Frame;
+
+		#if (DSP_STAGES & DSP_STAGE_DC_BLOCK)
+		if (Stages & DSP_STAGE_DC_BLOCK)
+		{
+			/* y[n] = x[n] - x[n-1] + (1 - 2^-k) y[n-1], with the feedback done as a shift */
+			int32_t Accumulator = State->DCAccumulator;
+
+			Accumulator += (((int32_t)Sample - State->DCPrevious) * 256);
+			Accumulator -= (Accumulator >> DSP_DC_BLOCK_SHIFT);
+
+			State->DCAccumulator = Accumulator;
+			State->DCPrevious    = Sample;
+
+			Accumulator >>= 8;
+			Sample = MAX(MIN(Accumulator, INT16_MAX), INT16_MIN);
+		}
+		#endif
+
+		#if defined(DSP_BIQUADS)
+		for (uint8_t Biquad = 0; Biquad < DSP_BIQUADS; Biquad++)
+		{
+			if (!(Stages & (DSP_STAGE_BIQUAD1 << Biquad)))
+			  continue;
+
+			/* Direct form I, with the history held as x[n-1], x[n-2], y[n-1], y[n-2] */
+			int16_t*       History      = State->Biquad[Biquad];
+			const int16_t* Coefficients = Dsp_BiquadCoefficients[Biquad];
+
+			int32_t Sum = ((int32_t)Sample     * (int16_t)pgm_read_word(&Coefficients[0])) +
+			              ((int32_t)History[0] * (int16_t)pgm_read_word(&Coefficients[1])) +
+			              ((int32_t)History[1] * (int16_t)pgm_read_word(&Coefficients[2])) -
+			              ((int32_t)History[2] * (int16_t)pgm_read_word(&Coefficients[3])) -
+			              ((int32_t)History[3] * (int16_t)pgm_read_word(&Coefficients[4]));
+
+			Sum >>= DSP_BIQUAD_BITS;
+
+			History[1] = History[0];
+			History[0] = Sample;
+
+			Sample = MAX(MIN(Sum, INT16_MAX), INT16_MIN);
+
+			History[3] = History[2];
+			History[2] = Sample;
+		}
+		#endif
+
+		#if (DSP_STAGES & DSP_STAGE_LIMITER)
+		if (Stages & DSP_STAGE_LIMITER)
+		{
+			uint16_t Gain    = State->LimiterGain;
+			int16_t  Limited = (((int32_t)Sample * Gain) >> 15);
+
+			if ((Limited > DSP_LIMITER_THRESHOLD) || (Limited < -DSP_LIMITER_THRESHOLD))
+			{
+				/* With no look-ahead the first samples of a peak are clipped while the gain comes down */
+				Limited = (Limited > 0) ? DSP_LIMITER_THRESHOLD : -DSP_LIMITER_THRESHOLD;
+				Gain   -= (Gain >> DSP_LIMITER_ATTACK_SHIFT);
+			}
+			else
+			{
+				/* Rounded up, so that the gain always makes it back to unity */
+				Gain   += ((DSP_LIMITER_UNITY - Gain + (1 << DSP_LIMITER_RELEASE_SHIFT) - 1) >> DSP_LIMITER_RELEASE_SHIFT);
+			}
+
+			State->LimiterGain = Gain;
+			Sample = Limited;
+		}
+		#endif
+
+		*(Frame++) = Sample;
+		State++;
+	}
+}
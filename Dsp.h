@@ -0,0 +1,83 @@
+/** \file
+ *
+ *  Header file for Dsp.c.
+ */
+
+#ifndef _DSP_H_
+#define _DSP_H_
+
+	/* Includes: */
+		#include <avr/pgmspace.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+		#include <string.h>
+
+		#include "Budget.h"
+		#include "Mix.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Number of fractional bits in the fixed point biquad coefficients, so that each must be within +/-2. The
+		 *  magnitudes of a biquad's five coefficients must also add up to less than 4 (65536 as stored), as with
+		 *  full scale input and history each product reaches 32768 times its coefficient, and their sum must fit
+		 *  the 32-bit accumulator.
+		 */
+		#define DSP_BIQUAD_BITS              14
+
+		/** Feedback shift of the DC blocker, setting its corner to about 1/(2 pi 2^n) of the sample rate. */
+		#define DSP_DC_BLOCK_SHIFT           8
+
+		/** Shift of the limiter's gain towards the peak on each sample over the threshold, and back towards unity
+		 *  on every other sample, setting its attack and release times.
+		 */
+		#define DSP_LIMITER_ATTACK_SHIFT     2
+		#define DSP_LIMITER_RELEASE_SHIFT    10
+
+		/** Limiter gain of unity, in the Q1.15 format the gain is held in. */
+		#define DSP_LIMITER_UNITY            32768U
+
+		/** Worst case cost in cycles of each stage, and of the per-channel overhead, for one sample. None of these
+		 *  has been measured yet, so they are deliberately generous: a biquad alone makes five 16 by 16 bit
+		 *  multiplies into 32 bits through the library's __mulhisi3 at about 25 cycles each, five program memory
+		 *  loads, the history moves, a 32-bit shift and a clamp. "make dspbench" in Tools/IsrBench times the
+		 *  compiled chain under simavr and fails if it takes longer, and the figures here should be replaced with
+		 *  its results.
+		 */
+		#define DSP_CYCLES_CHANNEL           30
+		#define DSP_CYCLES_DC_BLOCK          80
+		#define DSP_CYCLES_BIQUAD            320
+		#define DSP_CYCLES_LIMITER           110
+
+		/** Estimated cost in cycles of running the given mask of \c DSP_STAGE_* flags on one channel of a frame. */
+		#define DSP_CYCLES(Stages)           (DSP_CYCLES_CHANNEL + \
+		                                      (((Stages) & DSP_STAGE_DC_BLOCK) ? DSP_CYCLES_DC_BLOCK : 0) + \
+		                                      (((Stages) & DSP_STAGE_BIQUAD1)  ? DSP_CYCLES_BIQUAD   : 0) + \
+		                                      (((Stages) & DSP_STAGE_BIQUAD2)  ? DSP_CYCLES_BIQUAD   : 0) + \
+		                                      (((Stages) & DSP_STAGE_LIMITER)  ? DSP_CYCLES_LIMITER  : 0))
+
+		/** Cycles the chain may take for each frame at the given sample rate, its share of the budget in Budget.h. */
+		#define DSP_CYCLE_BUDGET(Rate)       BUDGET_CYCLES(BUDGET_PARTS_DSP, (Rate))
+
+	/* Preprocessor Checks: */
+		#if (DSP_STAGES & ~DSP_STAGE_MASK)
+			#error DSP_STAGES may only contain DSP_STAGE_* flags.
+		#elif (DSP_CYCLES(DSP_STAGES) > DSP_CYCLE_BUDGET(AUDIO_MAX_SAMPLE_RATE))
+			#error The DSP_STAGES chain does not fit the cycle budget of a mono frame at AUDIO_MAX_SAMPLE_RATE.
+		#endif
+
+	/* External Variables: */
+		extern uint8_t Dsp_Stages;
+
+	/* Function Prototypes: */
+		void Dsp_Init(void);
+		void Dsp_SetRate(const uint32_t SampleRate);
+		void Dsp_Configure(const uint8_t Stages,
+		                   const uint8_t Entries);
+		uint8_t Dsp_FitStages(const uint8_t Stages,
+		                      const uint8_t Entries);
+		bool Dsp_IsWithinBudget(const uint8_t Stages,
+		                        const uint8_t Entries);
+		void Dsp_Process(int16_t* Frame);
+
+#endif
@@ -0,0 +1,83 @@
+/** \file
+ *
+ *  Sample emission histogram, measuring how far each interval between two samples sent to the output strays
+ *  from the nominal sample period. Any time the sample ISR spends waiting on another interrupt, or on code
+ *  running with interrupts disabled, shows up as a pair of intervals one longer and one shorter than nominal,
+ *  which is heard as noise on the output. Times are taken from the free-running Timer 1 of the sample clock,
+ *  and the histogram is read with \ref VENDOR_REQ_GetEmission ("audioctl emission").
+ *
+ *  The histogram is only compiled in when \c EMISSION_HISTOGRAM_BINS is defined, as it takes two bytes of SRAM
+ *  for each bin and a few dozen cycles of each sample ISR.
+ */
+
+#include "Emission.h"
+
+#if defined(EMISSION_HISTOGRAM_BINS)
+
+/** Emission histogram, holding its header followed by the count of each bin. */
+EmissionHistogram_t Emission_Histogram =
+	{
+		.Status =
+			{
+				.Bins      = EMISSION_HISTOGRAM_BINS,
+				.BinCycles = (1 << EMISSION_BIN_SHIFT),
+				.MinCycles = INT16_MAX,
+				.MaxCycles = INT16_MIN,
+			},
+	};
+
+/** Timer 1 count at the last sample emission. */
+uint16_t Emission_LastCount;
+
+/** Indicates if the last sample period ended with an emission, so that the next interval can be measured. */
+bool     Emission_Running;
+
+/** Indicates if the histogram is being sent to the host or cleared, and must not change. */
+volatile bool Emission_Frozen;
+
+/** Stops the histogram from changing, so that it can be sent to the host as it stands without a copy being
+ *  taken. Intervals ending until the next call to \ref Emission_Release() are left out of it.
+ */
+void Emission_Freeze(void)
+{
+	Emission_Frozen = true;
+}
+
+/** Lets the histogram change again once it has been sent, optionally emptying it first.
+ *
+ *  \param[in] Clear  Boolean \c true to empty the histogram.
+ */
+void Emission_Release(const bool Clear)
+{
+	if (Clear)
+	{
+		Emission_Histogram.Status.MinCycles = INT16_MAX;
+		Emission_Histogram.Status.MaxCycles = INT16_MIN;
+		memset(Emission_Histogram.Counts, 0, sizeof(Emission_Histogram.Counts));
+	}
+
+	Emission_Frozen = false;
+}
+
+#endif
+
+/** Sets the nominal sample period the intervals are measured against, and empties the histogram. Does nothing
+ *  if the histogram is not compiled in.
+ *
+ *  \param[in] SampleRate  New sample rate in Hz.
+ */
+void Emission_SetRate(const uint32_t SampleRate)
+{
+	#if defined(EMISSION_HISTOGRAM_BINS)
+	Emission_Freeze();
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		/* Timer 0 runs from the nearest whole number of ticks, or dithers around it with the start of frame sync */
+		Emission_Histogram.Status.NominalCycles = (((CLOCK_TIMER_HZ + (SampleRate / 2)) / SampleRate) * (F_CPU / CLOCK_TIMER_HZ));
+		Emission_Running = false;
+	}
+
+	Emission_Release(true);
+	#endif
+}
@@ -0,0 +1,105 @@
+/** \file
+ *
+ *  Header file for Emission.c.
+ */
+
+#ifndef _EMISSION_H_
+#define _EMISSION_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+		#include <string.h>
+
+		#include "Clock.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if defined(EMISSION_HISTOGRAM_BINS) && ((EMISSION_HISTOGRAM_BINS < 2) || (EMISSION_HISTOGRAM_BINS > 64))
+			#error EMISSION_HISTOGRAM_BINS must be between 2 and 64.
+		#elif defined(EMISSION_HISTOGRAM_BINS) && defined(SAMPLE_ISR_ASM)
+			#error The emission histogram is recorded by the C sample ISR, and cannot be used with SAMPLE_ISR_ASM.
+		#endif
+
+	/* Macros: */
+		/** Width of each histogram bin as a power of two of system clock cycles, one tick of the sample timer. */
+		#define EMISSION_BIN_SHIFT           3
+
+	#if defined(EMISSION_HISTOGRAM_BINS) || defined(__DOXYGEN__)
+		/* Type Defines: */
+			/** Type define for the emission histogram, laid out as the \ref VENDOR_REQ_GetEmission reply. */
+			typedef struct
+			{
+				EmissionStatus_t Status; /**< Histogram header */
+				uint16_t         Counts[EMISSION_HISTOGRAM_BINS]; /**< Number of intervals in each bin */
+			} __attribute__((packed)) EmissionHistogram_t;
+
+		/* External Variables: */
+			extern EmissionHistogram_t Emission_Histogram;
+			extern uint16_t            Emission_LastCount;
+			extern bool                Emission_Running;
+			extern volatile bool       Emission_Frozen;
+	#endif
+
+	/* Inline Functions: */
+		/** Counts the interval since the previous sample emission into the histogram. This must be called from the
+		 *  sample ISR, just before each sample is sent to the output.
+		 */
+		static inline void Emission_Record(void)
+		{
+			#if defined(EMISSION_HISTOGRAM_BINS)
+			uint16_t Count = TCNT1;
+			int16_t  Deviation = (int16_t)((uint16_t)(Count - Emission_LastCount) - Emission_Histogram.Status.NominalCycles);
+
+			Emission_LastCount = Count;
+
+			if (!(Emission_Running))
+			{
+				Emission_Running = true;
+				return;
+			}
+
+			/* The histogram is being sent to the host or cleared, so leave this interval out */
+			if (Emission_Frozen)
+			  return;
+
+			if (Deviation < Emission_Histogram.Status.MinCycles)
+			  Emission_Histogram.Status.MinCycles = Deviation;
+
+			if (Deviation > Emission_Histogram.Status.MaxCycles)
+			  Emission_Histogram.Status.MaxCycles = Deviation;
+
+			int16_t Bin = ((Deviation >> EMISSION_BIN_SHIFT) + (EMISSION_HISTOGRAM_BINS / 2));
+
+			if (Bin < 0)
+			  Bin = 0;
+			else if (Bin > (EMISSION_HISTOGRAM_BINS - 1))
+			  Bin = (EMISSION_HISTOGRAM_BINS - 1);
+
+			if (Emission_Histogram.Counts[Bin] != UINT16_MAX)
+			  Emission_Histogram.Counts[Bin]++;
+			#endif
+		}
+
+		/** Leaves the next interval out of the histogram, when a sample period passes without an emission. This
+		 *  must be called from the sample ISR.
+		 */
+		static inline void Emission_Restart(void)
+		{
+			#if defined(EMISSION_HISTOGRAM_BINS)
+			Emission_Running = false;
+			#endif
+		}
+
+	/* Function Prototypes: */
+		void Emission_SetRate(const uint32_t SampleRate);
+
+		#if defined(EMISSION_HISTOGRAM_BINS)
+			void Emission_Freeze(void);
+			void Emission_Release(const bool Clear);
+		#endif
+
+#endif
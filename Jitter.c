@@ -0,0 +1,199 @@
+/** \file
+ *
+ *  Jitter buffer depth controller, deciding how many frames the sample ring is filled to before playback starts.
+ *  With a fixed depth from the settings this only keeps the statistics. In adaptive mode (a depth setting of
+ *  zero) the target starts at \ref JITTER_MIN_DEPTH and grows by \ref JITTER_GROW_DEPTH after each underrun, so
+ *  that the ring refills deeper before playback resumes. After \ref JITTER_CLEAN_SECONDS of playback without an
+ *  underrun, the frames the ring never dropped below, beyond \ref JITTER_SHRINK_MARGIN, are taken out of the
+ *  stream one at a time by merging a frame into the next as their average, preferably while the signal is
+ *  quiet, and the target shrinks to match. Each host thus converges on the shallowest depth its scheduling
+ *  allows, which \ref VENDOR_REQ_GetBufferStatus reports.
+ */
+
+#include "Jitter.h"
+
+/** Number of frames the ring is filled to before playback starts or resumes. */
+uint8_t         Jitter_TargetDepth = JITTER_MIN_DEPTH;
+
+/** Indicates if the target depth adapts to the host, rather than being fixed by the settings. */
+static bool     Jitter_Adaptive = true;
+
+/** Number of ring entries in each frame. */
+static uint8_t  Jitter_FrameEntries = 1;
+
+/** Deepest target the ring can hold, leaving room for a packet at the current sample rate. */
+static uint8_t  Jitter_MaxDepth;
+
+/** Current sample rate in Hz, for the clean period and the latency report. */
+static uint32_t Jitter_SampleRate;
+
+/** Indicates if playback was running at the last observation, so that an underrun can be detected. */
+static bool     Jitter_Playing;
+
+/** Fewest frames seen in the ring during playback in the current clean period. */
+static uint8_t  Jitter_LowWater = UINT8_MAX;
+
+/** Frames played in the current clean period. */
+static uint32_t Jitter_CleanFrames;
+
+/** Number of frames still to be taken out of the stream, and frames passed since the last was taken out. */
+static uint8_t  Jitter_MergesPending;
+static uint16_t Jitter_MergeWait;
+
+/** Frame being merged into the next one, if \ref Jitter_CarryValid is set. */
+static int16_t  Jitter_Carry[MIX_OUTPUTS];
+static bool     Jitter_CarryValid;
+
+/** Number of underruns and merged frames since the device was reset. */
+static uint16_t Jitter_Underruns;
+static uint16_t Jitter_Merges;
+
+/** Prepares the controller for a new stream or link layout. The adaptive target carries over from the previous
+ *  stream, so that a host does not have to go through the same underruns each time it opens the stream.
+ *
+ *  \param[in] FrameEntries  Number of ring entries in each frame.
+ *  \param[in] Depth         Fixed depth in frames from the settings, or zero for the adaptive controller.
+ *  \param[in] SampleRate    Sample rate of the stream in Hz.
+ */
+void Jitter_Reset(const uint8_t FrameEntries,
+                  const uint8_t Depth,
+                  const uint32_t SampleRate)
+{
+	/* The deepest target still leaves room for a whole packet on top of it, and at least one frame when the ring
+	 * cannot even hold a packet, as with stereo frames at a rate beyond AUDIO_MAX_SAMPLE_RATE */
+	int16_t MaxDepth = ((int16_t)(SAMPLE_RING_SIZE / FrameEntries) - (int16_t)((SampleRate + 999) / 1000));
+
+	Jitter_FrameEntries = FrameEntries;
+	Jitter_MaxDepth     = MAX(MaxDepth, 1);
+	Jitter_SampleRate   = SampleRate;
+
+	if (Depth)
+	  Jitter_TargetDepth = Depth;
+	else if (!(Jitter_Adaptive))
+	  Jitter_TargetDepth = JITTER_MIN_DEPTH;
+
+	Jitter_Adaptive    = !(Depth);
+	Jitter_TargetDepth = MIN(Jitter_TargetDepth, Jitter_MaxDepth);
+
+	Jitter_Playing      = false;
+	Jitter_LowWater     = UINT8_MAX;
+	Jitter_CleanFrames  = 0;
+	Jitter_MergesPending = 0;
+	Jitter_CarryValid    = false;
+}
+
+/** Samples the ring fill level, and detects the underruns the sample ISR signals by clearing the primed flag.
+ *  This must be called from the main loop before the ring is refilled from the streaming endpoint.
+ */
+void Jitter_Observe(void)
+{
+	if (!(Jitter_Playing))
+	  return;
+
+	if (!(SampleRing_IsPrimed()))
+	{
+		Jitter_Playing = false;
+		Jitter_Underruns++;
+
+		if (Jitter_Adaptive)
+		  Jitter_TargetDepth = MIN((Jitter_TargetDepth + JITTER_GROW_DEPTH), Jitter_MaxDepth);
+
+		/* A merge now would only make the next underrun sooner */
+		Jitter_LowWater      = UINT8_MAX;
+		Jitter_CleanFrames   = 0;
+		Jitter_MergesPending = 0;
+		return;
+	}
+
+	Jitter_LowWater = MIN(Jitter_LowWater, (SampleRing_Count() / Jitter_FrameEntries));
+}
+
+/** Marks the start of playback, once the ring has been filled to \ref Jitter_TargetDepth. */
+void Jitter_Started(void)
+{
+	Jitter_Playing = true;
+}
+
+/** Marks the end of playback when the stream closes, so that emptying the ring is not taken for an underrun. */
+void Jitter_Stop(void)
+{
+	Jitter_Playing    = false;
+	Jitter_CarryValid = false;
+}
+
+/** Passes a frame on its way into the ring, merging it into the next one when the controller is taking a frame
+ *  out of the stream.
+ *
+ *  \param[in,out] Frame  One sample for each channel of the frame, replaced by the merged frame if needed.
+ *
+ *  \return Boolean \c true if the frame should be added to the ring, \c false if it is being merged
+ */
+bool Jitter_Process(int16_t* Frame)
+{
+	if (Jitter_CarryValid)
+	{
+		for (uint8_t Channel = 0; Channel < Jitter_FrameEntries; Channel++)
+		  Frame[Channel] = (((int32_t)Frame[Channel] + Jitter_Carry[Channel]) >> 1);
+
+		Jitter_CarryValid = false;
+		return true;
+	}
+
+	if (Jitter_MergesPending && (++Jitter_MergeWait >= JITTER_MERGE_SPACING))
+	{
+		bool Quiet = true;
+
+		for (uint8_t Channel = 0; Channel < Jitter_FrameEntries; Channel++)
+		{
+			if ((Frame[Channel] > JITTER_QUIET_LEVEL) || (Frame[Channel] < -JITTER_QUIET_LEVEL))
+			  Quiet = false;
+		}
+
+		if (Quiet || (Jitter_MergeWait >= JITTER_MERGE_TIMEOUT))
+		{
+			for (uint8_t Channel = 0; Channel < Jitter_FrameEntries; Channel++)
+			  Jitter_Carry[Channel] = Frame[Channel];
+
+			Jitter_CarryValid = true;
+			Jitter_MergeWait  = 0;
+			Jitter_MergesPending--;
+			Jitter_Merges++;
+			return false;
+		}
+	}
+
+	if (Jitter_Adaptive && Jitter_Playing && (++Jitter_CleanFrames >= (Jitter_SampleRate * JITTER_CLEAN_SECONDS)))
+	{
+		/* Take out what the ring kept in hand all through the clean period, beyond the margin */
+		if ((Jitter_LowWater != UINT8_MAX) && (Jitter_LowWater > JITTER_SHRINK_MARGIN) && !(Jitter_MergesPending))
+		{
+			uint8_t Excess = (Jitter_LowWater - JITTER_SHRINK_MARGIN);
+
+			Jitter_TargetDepth   = MAX((Jitter_TargetDepth - Excess), JITTER_MIN_DEPTH);
+			Jitter_MergesPending = Excess;
+			Jitter_MergeWait     = 0;
+		}
+
+		Jitter_LowWater    = UINT8_MAX;
+		Jitter_CleanFrames = 0;
+	}
+
+	return true;
+}
+
+/** Fills in the state of the controller and the ring for \ref VENDOR_REQ_GetBufferStatus.
+ *
+ *  \param[out] Status  Status structure to fill.
+ */
+void Jitter_GetStatus(BufferStatus_t* const Status)
+{
+	uint8_t Depth = (SampleRing_Count() / Jitter_FrameEntries);
+
+	Status->Adaptive    = Jitter_Adaptive;
+	Status->TargetDepth = Jitter_TargetDepth;
+	Status->Depth       = Depth;
+	Status->LowWater    = ((Jitter_LowWater == UINT8_MAX) ? Depth : Jitter_LowWater);
+	Status->Underruns   = Jitter_Underruns;
+	Status->Merges      = Jitter_Merges;
+	Status->LatencyUS   = (Jitter_SampleRate ? (((uint32_t)Depth * 1000000UL) / Jitter_SampleRate) : 0);
+}
@@ -0,0 +1,64 @@
+/** \file
+ *
+ *  Header file for Jitter.c.
+ */
+
+#ifndef _JITTER_H_
+#define _JITTER_H_
+
+	/* Includes: */
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include <LUFA/Common/Common.h>
+
+		#include "Mix.h"
+		#include "SampleRing.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if (SAMPLE_RING_SIZE <= ((AUDIO_MAX_SAMPLE_RATE + 999) / 1000))
+			#error SAMPLE_RING_SIZE must hold more than a packet of mono frames at AUDIO_MAX_SAMPLE_RATE.
+		#endif
+
+	/* Macros: */
+		/** Depth in frames the adaptive controller starts from, and never shrinks below. */
+		#define JITTER_MIN_DEPTH             2
+
+		/** Frames added to the adaptive target depth after each underrun. */
+		#define JITTER_GROW_DEPTH            4
+
+		/** Seconds of playback without an underrun after which the adaptive controller tries a shallower depth. */
+		#define JITTER_CLEAN_SECONDS         10
+
+		/** Frames kept in hand when shrinking the ring: after a clean period, the frames the ring never dropped
+		 *  below beyond these are taken out of the stream.
+		 */
+		#define JITTER_SHRINK_MARGIN         2
+
+		/** Largest sample magnitude, on every channel, of a frame the controller may merge into the next, about
+		 *  -24dBFS. Quiet passages and zero crossings hide the merge best.
+		 */
+		#define JITTER_QUIET_LEVEL           2048
+
+		/** Fewest frames between two merges, so that each is heard, if at all, as a single isolated click. */
+		#define JITTER_MERGE_SPACING         256
+
+		/** Frames to wait for a quiet frame to merge, before merging the next one regardless. */
+		#define JITTER_MERGE_TIMEOUT         1024
+
+	/* External Variables: */
+		extern uint8_t Jitter_TargetDepth;
+
+	/* Function Prototypes: */
+		void Jitter_Reset(const uint8_t FrameEntries,
+		                  const uint8_t Depth,
+		                  const uint32_t SampleRate);
+		void Jitter_Observe(void);
+		void Jitter_Started(void);
+		void Jitter_Stop(void);
+		bool Jitter_Process(int16_t* Frame);
+		void Jitter_GetStatus(BufferStatus_t* const Status);
+
+#endif
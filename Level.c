@@ -0,0 +1,177 @@
+/** \file
+ *
+ *  Level meter, keeping the peak and RMS level and a count of clipped samples of each channel sent to the link,
+ *  both as the full 16-bit samples out of the processing chain and as the samples the output reduces them to:
+ *  the bytes of an 8-bit link, or the 8 or 12 bits the R-2R ladder of \c AUDIO_OUT_PORTC is driven with. The totals are gathered from the main loop as each frame goes into the sample ring, and are reported to
+ *  the host at \c LEVEL_METER times a second on an interrupt endpoint ("audioctl levels").
+ *
+ *  The meter is only compiled in when \c LEVEL_METER is defined. It is given its share of the time between two
+ *  frames in Budget.h; at sample rates where metering every frame would not fit that, only every second, fourth
+ *  or eighth frame is measured. The RMS level of a steady signal is unchanged, but short peaks and clips between the
+ *  frames measured are missed.
+ */
+
+#include "Level.h"
+
+#if defined(LEVEL_METER)
+
+/** Running totals of each channel since the last report. */
+LevelAccumulator_t Level_Channels[LEVEL_REPORT_CHANNELS];
+
+/** Number of frames measured since the last report. */
+uint16_t Level_Frames;
+
+/** Number of channels in each frame. */
+uint8_t  Level_Entries = 1;
+
+/** Number of frames sent for each frame measured, and the frames left until the next is measured. */
+uint8_t  Level_Stride = 1;
+uint8_t  Level_Countdown = 1;
+
+/** Resolution in bits of the samples the output reduces the frames to, or 16 if it takes them in full. */
+uint8_t  Level_Bits = 16;
+
+/** Current sample rate in Hz. */
+static uint32_t Level_SampleRate = AUDIO_MAX_SAMPLE_RATE;
+
+/** Number of reports sent, placed in the next one. */
+static uint8_t  Level_Sequence;
+
+/** Computes the integer square root of a value, rounded down.
+ *
+ *  \param[in] Value  Value to take the square root of.
+ *
+ *  \return Square root of the value
+ */
+static uint16_t Level_SquareRoot(uint32_t Value)
+{
+	uint32_t Root = 0;
+	uint32_t Bit  = (1UL << 30);
+
+	while (Bit > Value)
+	  Bit >>= 2;
+
+	while (Bit)
+	{
+		if (Value >= (Root + Bit))
+		{
+			Value -= (Root + Bit);
+			Root   = ((Root >> 1) + Bit);
+		}
+		else
+		{
+			Root >>= 1;
+		}
+
+		Bit >>= 2;
+	}
+
+	return Root;
+}
+
+/** Computes the RMS level of a channel from its sum of squares. The mean square always fits 32 bits, so the
+ *  48-bit sum is divided by the number of samples 16 bits at a time, each step only needing a 32-bit division.
+ *
+ *  \param[in] SumLow   Lower 32 bits of the sum of squares.
+ *  \param[in] SumHigh  Upper bits of the sum of squares.
+ *  \param[in] Frames   Number of samples in the sum.
+ *
+ *  \return RMS level of the samples
+ */
+static uint16_t Level_GetRMS(const uint32_t SumLow,
+                             const uint16_t SumHigh,
+                             const uint16_t Frames)
+{
+	if (!(Frames))
+	  return 0;
+
+	uint32_t Dividend = (((uint32_t)(SumHigh % Frames) << 16) | (SumLow >> 16));
+	uint32_t Mean     = ((Dividend / Frames) << 16);
+
+	Dividend = (((Dividend % Frames) << 16) | (SumLow & 0xFFFF));
+	Mean    |= (Dividend / Frames);
+
+	return Level_SquareRoot(Mean);
+}
+
+/** Fills a report with the levels of each channel since the last report, and starts the totals over for the
+ *  next. This must be called from the main loop, as the totals are gathered there without any locking.
+ *
+ *  \param[out] Report  Level report for the host.
+ */
+void Level_GetReport(LevelReport_t* const Report)
+{
+	memset(Report, 0, sizeof(LevelReport_t));
+
+	Report->Sequence = Level_Sequence++;
+	Report->Flags    = (((Level_Entries == 2) ? LEVEL_FLAG_STEREO : 0) | ((Level_Bits < 16) ? LEVEL_FLAG_REDUCED : 0));
+	Report->Bits     = Level_Bits;
+	Report->Stride   = Level_Stride;
+	Report->Frames   = Level_Frames;
+
+	for (uint8_t Channel = 0; Channel < Level_Entries; Channel++)
+	{
+		LevelAccumulator_t* Accumulator = &Level_Channels[Channel];
+		LevelChannel_t*     Levels      = &Report->Channels[Channel];
+
+		Levels->Peak      = Accumulator->Peak;
+		Levels->RMS       = Level_GetRMS(Accumulator->SumLow, Accumulator->SumHigh, Level_Frames);
+		Levels->Clips     = Accumulator->Clips;
+		Levels->LinkPeak  = Accumulator->LinkPeak;
+		Levels->LinkRMS   = Level_GetRMS(Accumulator->LinkSumLow, Accumulator->LinkSumHigh, Level_Frames);
+		Levels->LinkClips = Accumulator->LinkClips;
+	}
+
+	memset(Level_Channels, 0, sizeof(Level_Channels));
+	Level_Frames = 0;
+}
+
+#endif
+
+/** Publishes the estimated cost of metering a stereo frame, which "make levelbench" in Tools/IsrBench checks. */
+void Level_Init(void)
+{
+	#if defined(LEVEL_METER) && defined(__AVR__)
+	__asm__ __volatile__ (".global __level_cycles_stereo" "\n\t" ".set __level_cycles_stereo, %c0"
+	                      :
+	                      : "i" (LEVEL_CYCLES_CHANNEL * 2));
+	#endif
+}
+
+/** Sets the sample rate the cycle budget is checked against. The stride is not changed until the next call to
+ *  \ref Level_Configure().
+ *
+ *  \param[in] SampleRate  New sample rate in Hz.
+ */
+void Level_SetRate(const uint32_t SampleRate)
+{
+	#if defined(LEVEL_METER)
+	Level_SampleRate = SampleRate;
+	#endif
+}
+
+/** Sets the layout of the frames sent to the output, and starts the totals over for a new stream. The stride is
+ *  the smallest that fits the meter's budget at the current sample rate, up to \ref LEVEL_MAX_STRIDE. Does
+ *  nothing if the meter is not compiled in.
+ *
+ *  \param[in] Entries  Number of channels in each frame.
+ *  \param[in] Bits     Resolution in bits the output reduces the samples to, from 2 to 16.
+ */
+void Level_Configure(const uint8_t Entries,
+                     const uint8_t Bits)
+{
+	#if defined(LEVEL_METER)
+	uint8_t Stride = 1;
+
+	while ((Stride < LEVEL_MAX_STRIDE) && ((uint32_t)(LEVEL_CYCLES_CHANNEL * Entries) > (LEVEL_CYCLE_BUDGET(Level_SampleRate) * Stride)))
+	  Stride <<= 1;
+
+	Level_Entries   = Entries;
+	Level_Bits      = Bits;
+	Level_Stride    = Stride;
+	Level_Countdown = Stride;
+
+	memset(Level_Channels, 0, sizeof(Level_Channels));
+	Level_Frames = 0;
+	#endif
+}
@@ -0,0 +1,140 @@
+/** \file
+ *
+ *  Header file for Level.c.
+ */
+
+#ifndef _LEVEL_H_
+#define _LEVEL_H_
+
+	/* Includes: */
+		#include <stdbool.h>
+		#include <stdint.h>
+		#include <string.h>
+
+		#include "Budget.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if defined(LEVEL_METER) && ((LEVEL_METER < 1) || (LEVEL_METER > 100))
+			#error LEVEL_METER must be a report rate between 1 and 100 Hz.
+		#endif
+
+	/* Macros: */
+		/** Estimated worst case cost in cycles of metering one channel of a frame, both before and after the
+		 *  reduction to the output's resolution. This is counted from the instructions of \ref Level_Process(), not
+		 *  yet measured, and allows for the reduction's shift taking a loop of eight steps: "make levelbench" in
+		 *  Tools/IsrBench times the compiled code under simavr and fails if it takes longer, and the figure here
+		 *  should be replaced with its result.
+		 */
+		#define LEVEL_CYCLES_CHANNEL         160
+
+		/** Cycles the meter may take for each frame at the given sample rate, its share of the budget in Budget.h. */
+		#define LEVEL_CYCLE_BUDGET(Rate)     BUDGET_CYCLES(BUDGET_PARTS_LEVEL, (Rate))
+
+		/** Largest number of frames the meter steps over for each frame it measures, to stay within its budget at
+		 *  high sample rates.
+		 */
+		#define LEVEL_MAX_STRIDE             8
+
+		/** Time in milliseconds between two level reports. */
+		#define LEVEL_PERIOD_MS              (1000 / LEVEL_METER)
+
+	#if defined(LEVEL_METER) || defined(__DOXYGEN__)
+		/* Type Defines: */
+			/** Type define for the running totals of one channel since the last report. */
+			typedef struct
+			{
+				uint32_t SumLow; /**< Lower 32 bits of the sum of the squares of the 16-bit samples */
+				uint16_t SumHigh; /**< Carries out of \c SumLow */
+				uint16_t Peak; /**< Largest magnitude of the 16-bit samples */
+				uint16_t Clips; /**< Number of 16-bit samples at either rail, saturating */
+				uint32_t LinkSumLow; /**< Lower 32 bits of the sum of the squares of the reduced samples */
+				uint16_t LinkSumHigh; /**< Carries out of \c LinkSumLow */
+				uint16_t LinkPeak; /**< Largest magnitude of the reduced samples */
+				uint16_t LinkClips; /**< Number of reduced samples at either rail, saturating */
+			} LevelAccumulator_t;
+
+		/* External Variables: */
+			extern LevelAccumulator_t Level_Channels[LEVEL_REPORT_CHANNELS];
+			extern uint16_t           Level_Frames;
+			extern uint8_t            Level_Entries;
+			extern uint8_t            Level_Stride;
+			extern uint8_t            Level_Countdown;
+			extern uint8_t            Level_Bits;
+	#endif
+
+	/* Inline Functions: */
+		/** Meters a frame on its way into the sample ring, after the downmix matrix, the processing chain and the
+		 *  jitter buffer controller, and again as the 8-bit link or the R-2R ladder will reduce it. Only one frame in each
+		 *  \ref Level_Stride is measured, as set by \ref Level_Configure() to fit the meter's cycle budget.
+		 *
+		 *  \param[in] Frame  Frame of signed 16-bit samples, one for each channel the link carries.
+		 */
+		static inline void Level_Process(const int16_t* Frame)
+		{
+			#if defined(LEVEL_METER)
+			if (--Level_Countdown)
+			  return;
+
+			Level_Countdown = Level_Stride;
+
+			if (Level_Frames == UINT16_MAX)
+			  return;
+
+			Level_Frames++;
+
+			for (uint8_t Channel = 0; Channel < Level_Entries; Channel++)
+			{
+				LevelAccumulator_t* Accumulator = &Level_Channels[Channel];
+
+				int16_t  Sample    = Frame[Channel];
+				uint16_t Magnitude = (Sample < 0) ? (0U - (uint16_t)Sample) : (uint16_t)Sample;
+				uint32_t Sum       = (Accumulator->SumLow + (uint32_t)((int32_t)Sample * Sample));
+
+				if (Sum < Accumulator->SumLow)
+				  Accumulator->SumHigh++;
+
+				Accumulator->SumLow = Sum;
+
+				if (Magnitude > Accumulator->Peak)
+				  Accumulator->Peak = Magnitude;
+
+				if (((Sample == INT16_MAX) || (Sample == INT16_MIN)) && (Accumulator->Clips != UINT16_MAX))
+				  Accumulator->Clips++;
+
+				if (Level_Bits == 16)
+				  continue;
+
+				/* The link sends the upper byte of each sample, and the ladder is driven from its upper bits, which
+				 * is the sample shifted down and truncated */
+				int16_t  Reduced       = (Sample >> (16 - Level_Bits));
+				int16_t  ReducedMax    = ((1 << (Level_Bits - 1)) - 1);
+				uint16_t LinkMagnitude = (Reduced < 0) ? (0U - (uint16_t)Reduced) : (uint16_t)Reduced;
+				uint32_t LinkSum       = (Accumulator->LinkSumLow + (uint32_t)((int32_t)Reduced * Reduced));
+
+				if (LinkSum < Accumulator->LinkSumLow)
+				  Accumulator->LinkSumHigh++;
+
+				Accumulator->LinkSumLow = LinkSum;
+
+				if (LinkMagnitude > Accumulator->LinkPeak)
+				  Accumulator->LinkPeak = LinkMagnitude;
+
+				if (((Reduced == ReducedMax) || (Reduced == (-ReducedMax - 1))) && (Accumulator->LinkClips != UINT16_MAX))
+				  Accumulator->LinkClips++;
+			}
+			#endif
+		}
+
+	/* Function Prototypes: */
+		void Level_Init(void);
+		void Level_SetRate(const uint32_t SampleRate);
+		void Level_Configure(const uint8_t Entries,
+		                     const uint8_t Bits);
+
+		#if defined(LEVEL_METER)
+			void Level_GetReport(LevelReport_t* const Report);
+		#endif
+
+#endif
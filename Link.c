@@ -0,0 +1,699 @@
+/** \file
+ *
+ *  Serial link driver for the ATMEGA16U2, sending audio samples to the ATMEGA328 receiver over USART1. The
+ *  link starts in the base mode, and can be negotiated up to a faster baud rate and a wider sample format
+ *  when the receiver supports it. See LinkProtocol.h for a description of the wire format.
+ *
+ *  The fastest rate the link may be negotiated to is not taken on trust: when the device starts, and again
+ *  whenever the receiver comes out of reset, each rate is probed from the fastest down with a pseudo-random
+ *  pattern which the receiver echoes back. The first rate to come back clean through a short burst and then a
+ *  long confirmation burst caps the requested rate from then on, so a board or cable which cannot run at the
+ *  requested rate falls back to one it can before any audio is lost. Like the handshake, the bursts are stepped
+ *  from the main loop rather than waited out.
+ */
+
+#define  INCLUDE_FROM_LINK_C
+#include "Link.h"
+
+/** Indicates if the link is configured and samples may be sent; cleared while a handshake is in progress. */
+volatile bool Link_Ready;
+
+/** Indicates if the receiver accepted the last handshake, rather than the link falling back to the base mode. */
+bool Link_Negotiated;
+
+/** Current \ref Link_Bauds_t code the USART is running at. */
+uint8_t Link_Baud;
+
+/** Current mask of \c LINK_FORMAT_* flags samples are sent with. */
+uint8_t Link_Format;
+
+/** Fastest \ref Link_Bauds_t code the link may be negotiated to, as found by the last probe. */
+uint8_t Link_MaxBaud = LINK_BAUD_2M;
+
+/** Outcome of the last probe, a value from \ref LinkProbeResults_t. */
+uint8_t Link_ProbeResult;
+
+/** Bit errors counted at the last rate to fail the probe. */
+uint16_t Link_ProbeErrors;
+
+/** Number of sample frames dropped because the USART was still busy with the previous one, saturating. */
+volatile uint16_t Link_Drops;
+
+/** Set when the receiver has come out of reset, so the next negotiation probes the link again. */
+static bool Link_ProbePending;
+
+/** Set by the receive ISR on a framing error while capturing, as the receiver has reset and is talking at the
+ *  base rate.
+ */
+static volatile bool Link_ReceiverReset;
+
+/** High byte of the captured sample being received, and whether it has been received. */
+static uint8_t Link_CaptureHigh;
+static bool    Link_CaptureAligned;
+
+/** Current step of the link state machine, a value from \ref Link_States_t, and the job it is carrying out, a
+ *  value from \ref Link_Jobs_t.
+ */
+static uint8_t Link_State;
+static uint8_t Link_Job;
+
+/** Set when a negotiation has been asked for, and the mode it was asked with. */
+static bool     Link_NegotiationPending;
+static uint8_t  Link_RequestedBaud;
+static uint8_t  Link_RequestedFormat;
+static uint32_t Link_RequestedRate;
+
+/** Handshake being sent: its config byte, the mode switched to once it is accepted, the attempt and the number of
+ *  its bytes sent so far, and the receiver's reply to the current attempt.
+ */
+static uint8_t Link_Config;
+static uint8_t Link_ConfigBaud;
+static uint8_t Link_ConfigFormat;
+static uint8_t Link_Attempt;
+static uint8_t Link_SyncSent;
+static int16_t Link_Reply;
+
+/** Rate being probed. */
+static int8_t  Link_ProbeBaud;
+
+/** Burst of the test pattern being sent: its length, the characters sent and echoed so far, the state of the
+ *  pattern generators for each, and the bit errors counted in the echo.
+ */
+static uint16_t Link_BurstBytes;
+static uint16_t Link_BurstSent;
+static uint16_t Link_BurstReceived;
+static uint16_t Link_BurstSendPattern;
+static uint16_t Link_BurstEchoPattern;
+static uint16_t Link_BurstErrors;
+
+/** System clock cycles spent in the current state, and the Timer 1 count they were last brought up to date at. */
+static uint32_t Link_StateCycles;
+static uint16_t Link_LastCount;
+
+/** Set when a negotiation asked for with \ref Link_Negotiate() has finished, until \ref Link_Task() reports it. */
+static bool     Link_Finished;
+
+/** Initializes the link in the base mode, so that samples can be sent to a receiver which never negotiates, and
+ *  starts probing the rates the receiver can be reached at. The probe is carried out by \ref Link_Task() from
+ *  the main loop, which must not be called before Timer 1 is running.
+ */
+void Link_Init(void)
+{
+	Link_Configure(LINK_BASE_BAUD, 0);
+	Link_StartProbe(LINK_BAUD_2M);
+}
+
+/** Asks for the given link mode to be negotiated with the receiver. The link stops carrying samples straight
+ *  away, and the handshake is carried out by \ref Link_Task(), which reports when it has finished; a probe in
+ *  progress is finished first. The requested baud rate is capped at the fastest rate the last probe found clean,
+ *  probing again first if the receiver has reset since. If the requested format cannot keep up with the given
+ *  sample rate at that baud rate it is reduced to one that can; if the receiver does not answer the handshake the
+ *  link falls back to the base mode.
+ *
+ *  \param[in] Baud        Requested \ref Link_Bauds_t code.
+ *  \param[in] Format      Requested mask of \c LINK_FORMAT_* flags.
+ *  \param[in] SampleRate  Sample rate in Hz the link will have to carry.
+ */
+void Link_Negotiate(const uint8_t Baud,
+                    const uint8_t Format,
+                    const uint32_t SampleRate)
+{
+	Link_Ready              = false;
+	Link_NegotiationPending = true;
+	Link_RequestedBaud      = Baud;
+	Link_RequestedFormat    = Format;
+	Link_RequestedRate      = SampleRate;
+
+	/* Anything but a probe is abandoned, as the handshake starts over with a break of its own */
+	if (Link_Job != LINK_JOB_Probe)
+	  Link_State = LINK_STATE_Idle;
+}
+
+/** Steps the link state machine, sending the handshake and timing the receiver's reply without ever waiting on
+ *  the link. This must be called from the main loop, at least every few milliseconds so that Timer 1 is never
+ *  wrapped around in between; a longer gap only makes the timeouts longer.
+ *
+ *  \return Boolean \c true if a negotiation asked for with \ref Link_Negotiate() has just finished, \c false
+ *          otherwise
+ */
+bool Link_Task(void)
+{
+	uint16_t Count = TCNT1;
+
+	Link_StateCycles += (uint16_t)(Count - Link_LastCount);
+	Link_LastCount    = Count;
+
+	switch (Link_State)
+	{
+		case LINK_STATE_Idle:
+			if (!(Link_NegotiationPending))
+			  break;
+
+			if (Link_ProbePending)
+			  Link_StartProbe(LINK_BAUD_2M);
+			else
+			  Link_StartNegotiation();
+
+			break;
+		case LINK_STATE_Break:
+			if (Link_StateCycles < LINK_US_TO_CYCLES(LINK_BREAK_US))
+			  break;
+
+			/* Return the line to idle for a while, so the receiver can reconfigure before the handshake starts */
+			PORTD |= LINK_TX_PIN_MASK;
+			Link_SetState(LINK_STATE_BreakIdle);
+			break;
+		case LINK_STATE_BreakIdle:
+			if (Link_StateCycles < LINK_US_TO_CYCLES(LINK_BREAK_US))
+			  break;
+
+			Link_BreakSent();
+			break;
+		case LINK_STATE_SendSync:
+			/* Discard anything the receiver sent before the handshake, such as its reset announcement */
+			if (!(Link_SyncSent))
+			{
+				while (Serial_IsCharReceived())
+				  Serial_ReceiveByte();
+			}
+
+			uint8_t Handshake[] = {LINK_SYNC1, LINK_SYNC2, Link_Config, (uint8_t)~Link_Config};
+
+			while ((Link_SyncSent < sizeof(Handshake)) && (UCSR1A & (1 << UDRE1)))
+			  UDR1 = Handshake[Link_SyncSent++];
+
+			if (Link_SyncSent == sizeof(Handshake))
+			  Link_SetState(LINK_STATE_WaitAck);
+
+			break;
+		case LINK_STATE_WaitAck:
+			if (Serial_IsCharReceived())
+			{
+				Link_Reply = (uint8_t)Serial_ReceiveByte();
+
+				if (Link_Reply == LINK_ACK)
+				  Link_SetState(LINK_STATE_WaitConfig);
+				else
+				  Link_RetryHandshake();
+			}
+			else if (Link_StateCycles >= LINK_US_TO_CYCLES(LINK_HANDSHAKE_TIMEOUT_MS * 1000UL))
+			{
+				Link_RetryHandshake();
+			}
+
+			break;
+		case LINK_STATE_WaitConfig:
+			if (Serial_IsCharReceived())
+			{
+				if ((uint8_t)Serial_ReceiveByte() == Link_Config)
+				{
+					/* Give the receiver time to switch over once its acknowledgement has been sent */
+					Link_SetState(LINK_STATE_Settle);
+					break;
+				}
+
+				Link_Reply = -1;
+				Link_RetryHandshake();
+			}
+			else if (Link_StateCycles >= LINK_US_TO_CYCLES(LINK_HANDSHAKE_TIMEOUT_MS * 1000UL))
+			{
+				Link_Reply = -1;
+				Link_RetryHandshake();
+			}
+
+			break;
+		case LINK_STATE_Settle:
+			if (Link_StateCycles < LINK_US_TO_CYCLES(LINK_SETTLE_US))
+			  break;
+
+			Link_Configure(Link_ConfigBaud, Link_ConfigFormat);
+			Link_HandshakeDone(LINK_ACK);
+			break;
+		case LINK_STATE_Probe:
+			Link_ProbeStep();
+			break;
+	}
+
+	bool Finished = Link_Finished;
+	Link_Finished = false;
+
+	return Finished;
+}
+
+/** Determines if the given link mode has enough bandwidth to carry a stream at the given sample rate. A
+ *  margin of 1/8 of the link bandwidth is kept free, so that the sample ISR never has to wait on the USART.
+ *
+ *  \param[in] Baud        \ref Link_Bauds_t code of the link.
+ *  \param[in] Format      Mask of \c LINK_FORMAT_* flags.
+ *  \param[in] SampleRate  Sample rate in Hz.
+ *
+ *  \return Boolean \c true if the link mode can carry the stream, \c false otherwise
+ */
+bool Link_FitsBandwidth(const uint8_t Baud,
+                        const uint8_t Format,
+                        const uint32_t SampleRate)
+{
+	uint8_t FrameBytes = Link_BytesPerFrame(Format);
+
+	/* Multi-byte frames are sent as 9-bit characters, for a total of 11 bits per byte including start and stop */
+	uint8_t FrameBits  = FrameBytes * ((FrameBytes > 1) ? 11 : 10);
+
+	return ((SampleRate * FrameBits) <= (LINK_BAUD_RATE(Baud) - (LINK_BAUD_RATE(Baud) / 8)));
+}
+
+/** Checks if the receiver has spoken since the last handshake. Outside of capture the receiver only sends data
+ *  during the handshake or when it has just come out of reset, so in that case the link must be negotiated
+ *  again. While capturing, the receive ISR takes every byte and flags the framing errors of a reset instead.
+ *
+ *  \return Boolean \c true if the link needs to be renegotiated, \c false otherwise
+ */
+bool Link_IsRenegotiationNeeded(void)
+{
+	bool ReceiverReset = false;
+
+	/* The receiver's replies belong to the handshake while one is in progress */
+	if (Link_State != LINK_STATE_Idle)
+	  return false;
+
+	if (Link_Format & LINK_FORMAT_CAPTURE)
+	{
+		ReceiverReset      = Link_ReceiverReset;
+		Link_ReceiverReset = false;
+	}
+	else
+	{
+		while (Serial_IsCharReceived())
+		{
+			/* In the base mode only the explicit reset announcement counts, any other mode is never spoken by the receiver */
+			if ((Serial_ReceiveByte() == LINK_HELLO) || (Link_Baud != LINK_BASE_BAUD) || Link_Format)
+			  ReceiverReset = true;
+		}
+	}
+
+	/* The receiver may have come back on another board or cable, so its rates are probed again */
+	if (ReceiverReset)
+	  Link_ProbePending = true;
+
+	return ReceiverReset;
+}
+
+/** Quiesces the link while no stream is open. A break returns the receiver to the base mode, which mutes its
+ *  output until samples arrive again, and the transmitter is left disabled until the link is next negotiated.
+ *  Any negotiation asked for is abandoned; a probe in progress is left to finish.
+ */
+void Link_Stop(void)
+{
+	Link_Ready              = false;
+	Link_NegotiationPending = false;
+
+	if ((Link_Job == LINK_JOB_Probe) && (Link_State != LINK_STATE_Idle))
+	  return;
+
+	Link_Job = LINK_JOB_Stop;
+	Link_SendBreak();
+}
+
+/** Reconfigures USART1 for the given link mode.
+ *
+ *  \param[in] Baud    \ref Link_Bauds_t code to run the USART at.
+ *  \param[in] Format  Mask of \c LINK_FORMAT_* flags, which determine the character size.
+ */
+static void Link_Configure(const uint8_t Baud,
+                           const uint8_t Format)
+{
+	UCSR1B = 0;
+	AudioArena.LinkTx.Count = 0;
+
+	UBRR1  = LINK_UBRR_2X(Baud);
+	UCSR1A = (1 << U2X1);
+	UCSR1C = ((1 << UCSZ11) | (1 << UCSZ10));
+	UCSR1B = ((1 << TXEN1) | (1 << RXEN1) | ((Link_BytesPerFrame(Format) > 1) ? (1 << UCSZ12) : 0));
+
+	Link_Baud   = Baud;
+	Link_Format = Format;
+
+	/* Captured samples are taken from the receive interrupt, everything else is polled from the main loop */
+	Link_ReceiverReset  = false;
+	Link_CaptureAligned = false;
+
+	if (Format & LINK_FORMAT_CAPTURE)
+	  UCSR1B |= (1 << RXCIE1);
+}
+
+
+/** Reads the number of sample frames dropped because the USART was still busy with the previous one.
+ *
+ *  \return Number of frames dropped since the device started, saturating
+ */
+uint16_t Link_GetDrops(void)
+{
+	uint16_t Drops;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Drops = Link_Drops;
+	}
+
+	return Drops;
+}
+
+/** Moves the link state machine to the given state, and starts timing it.
+ *
+ *  \param[in] State  New state, a value from \ref Link_States_t.
+ */
+static void Link_SetState(const uint8_t State)
+{
+	Link_State       = State;
+	Link_StateCycles = 0;
+	Link_LastCount   = TCNT1;
+}
+
+/** Starts the negotiation asked for with \ref Link_Negotiate(), reducing the requested mode to one the link and
+ *  the sample rate allow.
+ */
+static void Link_StartNegotiation(void)
+{
+	uint8_t Baud   = Link_RequestedBaud;
+	uint8_t Format = Link_RequestedFormat;
+
+	Link_NegotiationPending = false;
+
+	/* Never ask for a faster rate than the probe found the link to carry */
+	if (Baud > Link_MaxBaud)
+	  Baud = Link_MaxBaud;
+
+	/* Fall back to 8-bit samples and then to mono if the requested format won't fit in the link bandwidth */
+	if (!(Link_FitsBandwidth(Baud, Format, Link_RequestedRate)))
+	  Format &= ~LINK_FORMAT_16BIT;
+
+	if (!(Link_FitsBandwidth(Baud, Format, Link_RequestedRate)))
+	  Format &= ~LINK_FORMAT_STEREO;
+
+	/* Captured samples come back as 9-bit characters, which single byte frames leave the USART without */
+	if (Link_BytesPerFrame(Format) == 1)
+	  Format &= ~LINK_FORMAT_CAPTURE;
+
+	Link_StartHandshake(LINK_JOB_Negotiate, LINK_CONFIG(Baud, Format), Baud, Format);
+}
+
+/** Starts probing the link at the given rate, and on down from there until a rate comes back clean.
+ *
+ *  \param[in] Baud  \ref Link_Bauds_t code of the first rate to probe.
+ */
+static void Link_StartProbe(const int8_t Baud)
+{
+	if (Baud == LINK_BAUD_2M)
+	{
+		Link_ProbePending = false;
+		Link_ProbeErrors  = 0;
+	}
+
+	/* Probe with 9-bit characters, the longest the link carries and so the least tolerant of a clock mismatch */
+	Link_ProbeBaud = Baud;
+	Link_StartHandshake(LINK_JOB_Probe, LINK_CONFIG(Baud, LINK_CONFIG_PROBE), Baud, LINK_FORMAT_16BIT);
+}
+
+/** Starts a handshake, which forces the receiver back to the base mode with a break, whatever mode it is currently
+ *  in, and then sends it the given config until it is acknowledged or the attempts run out.
+ *
+ *  \param[in] Job     Job the handshake is part of, a value from \ref Link_Jobs_t.
+ *  \param[in] Config  Handshake config byte, built with \ref LINK_CONFIG().
+ *  \param[in] Baud    \ref Link_Bauds_t code to switch to once the handshake is accepted.
+ *  \param[in] Format  Mask of \c LINK_FORMAT_* flags to switch to once the handshake is accepted.
+ */
+static void Link_StartHandshake(const uint8_t Job,
+                                const uint8_t Config,
+                                const uint8_t Baud,
+                                const uint8_t Format)
+{
+	Link_Ready        = false;
+	Link_Job          = Job;
+	Link_Config       = Config;
+	Link_ConfigBaud   = Baud;
+	Link_ConfigFormat = Format;
+	Link_Attempt      = 0;
+
+	Link_SendBreak();
+}
+
+/** Starts a break on the link, by holding the TX line low for longer than a full character. The receiver sees
+ *  this as a framing error with a zero data byte, which it treats as a request to return to the base mode.
+ */
+static void Link_SendBreak(void)
+{
+	UCSR1B &= ~(1 << TXEN1);
+
+	DDRD   |=  LINK_TX_PIN_MASK;
+	PORTD  &= ~LINK_TX_PIN_MASK;
+
+	Link_SetState(LINK_STATE_Break);
+}
+
+/** Carries on with the current job once a break has been sent and the line has been idle for a while. */
+static void Link_BreakSent(void)
+{
+	switch (Link_Job)
+	{
+		case LINK_JOB_Stop:
+			/* The transmitter is left disabled until the link is next negotiated */
+			Link_SetState(LINK_STATE_Idle);
+			break;
+		case LINK_JOB_Reset:
+			Link_Configure(LINK_BASE_BAUD, 0);
+			Link_Ready = true;
+			Link_SetState(LINK_STATE_Idle);
+			break;
+		default:
+			Link_Configure(LINK_BASE_BAUD, 0);
+			Link_Reply    = -1;
+			Link_SyncSent = 0;
+			Link_SetState(LINK_STATE_SendSync);
+			break;
+	}
+}
+
+/** Sends the handshake again after an attempt went unanswered or was answered wrongly, or gives up once the
+ *  attempts have run out.
+ */
+static void Link_RetryHandshake(void)
+{
+	if (++Link_Attempt < LINK_HANDSHAKE_ATTEMPTS)
+	{
+		Link_SyncSent = 0;
+		Link_SetState(LINK_STATE_SendSync);
+		return;
+	}
+
+	/* An acknowledgement with the wrong config echoed is no answer at all */
+	Link_HandshakeDone((Link_Reply == LINK_ACK) ? -1 : Link_Reply);
+}
+
+/** Carries on with the current job once its handshake has been accepted, or has failed. The link is in the mode
+ *  of the handshake if it was accepted, and in the base mode otherwise.
+ *
+ *  \param[in] Reply  \ref LINK_ACK if the receiver accepted the handshake, otherwise the first byte of its last
+ *                    reply, or -1 if it did not answer.
+ */
+static void Link_HandshakeDone(const int16_t Reply)
+{
+	if (Link_Job == LINK_JOB_Negotiate)
+	{
+		Link_Negotiated = (Reply == LINK_ACK);
+		Link_Ready      = true;
+		Link_Finished   = true;
+		Link_SetState(LINK_STATE_Idle);
+		return;
+	}
+
+	if (Reply == LINK_ACK)
+	{
+		/* At each rate a short burst of the test pattern weeds out rates which fail outright */
+		Link_StartBurst(LINK_PROBE_BYTES);
+		return;
+	}
+
+	/* A missing receiver is not looked for again at every stream start, which would only repeat the handshake
+	 * timeouts; the probe runs again once a receiver announces itself coming out of reset */
+	if (Link_ProbeBaud == LINK_BAUD_2M)
+	{
+		Link_ProbeResult = (Reply == LINK_NAK) ? LINK_PROBE_Unsupported : LINK_PROBE_NoReceiver;
+		Link_MaxBaud     = LINK_BAUD_2M;
+	}
+	else
+	{
+		/* The handshake is sent at the base rate whatever is being probed, so a receiver which stops answering
+		 * part way through is in trouble of its own; run at the slowest rate until it resets */
+		Link_MaxBaud     = LINK_BAUD_250K;
+	}
+
+	/* Return the receiver to the base mode, in case it is still listening at the rate being probed */
+	Link_Job = LINK_JOB_Reset;
+	Link_SendBreak();
+}
+
+/** Carries on with the probe once a burst of the test pattern has been sent and its echo checked. The first rate
+ *  to pass the short burst must then pass a confirmation burst sixteen times longer, so that the rate kept has a
+ *  margin on its error rate rather than having just scraped through.
+ *
+ *  \param[in] Errors  Number of bit errors counted in the echo of the burst.
+ */
+static void Link_BurstDone(const uint16_t Errors)
+{
+	if (!(Errors) && (Link_BurstBytes == LINK_PROBE_BYTES))
+	{
+		Link_StartBurst(LINK_PROBE_CONFIRM_BYTES);
+		return;
+	}
+
+	Link_MaxBaud = Link_ProbeBaud;
+
+	if (Errors)
+	{
+		Link_ProbeResult = LINK_PROBE_Failed;
+		Link_ProbeErrors = Errors;
+
+		if (Link_ProbeBaud > LINK_BAUD_250K)
+		{
+			Link_StartProbe(Link_ProbeBaud - 1);
+			return;
+		}
+	}
+	else
+	{
+		Link_ProbeResult = LINK_PROBE_Clean;
+	}
+
+	/* Return the receiver from its echo loop to the base mode */
+	Link_Job = LINK_JOB_Reset;
+	Link_SendBreak();
+}
+
+/** Starts sending a burst of the test pattern to the receiver while it echoes the link. The burst is carried out
+ *  by \ref Link_ProbeStep() from the main loop, a few characters at a time.
+ *
+ *  \param[in] Bytes  Number of characters in the burst.
+ */
+static void Link_StartBurst(const uint16_t Bytes)
+{
+	Link_BurstBytes       = Bytes;
+	Link_BurstSent        = 0;
+	Link_BurstReceived    = 0;
+	Link_BurstSendPattern = LINK_PROBE_SEED;
+	Link_BurstEchoPattern = LINK_PROBE_SEED;
+	Link_BurstErrors      = 0;
+
+	while (Serial_IsCharReceived())
+	  Serial_ReceiveByte();
+
+	Link_SetState(LINK_STATE_Probe);
+}
+
+/** Sends what it can of the current burst of the test pattern without waiting on the USART, and counts the bits
+ *  of the echo which differ from what was sent. Only \ref LINK_PROBE_WINDOW characters are ever in flight, so
+ *  neither end's receiver can be overrun however long the main loop takes between two steps. The echo is read
+ *  before the timeout is checked, so only a character which has not come back within
+ *  \ref LINK_PROBE_TIMEOUT_US of the last one counts as lost, along with the rest of the burst, as a character
+ *  with every bit wrong.
+ */
+static void Link_ProbeStep(void)
+{
+	while (UCSR1A & (1 << RXC1))
+	{
+		/* The ninth bit must be read before the data register, as reading UDR1 advances the receive FIFO */
+		uint16_t Echo = ((UCSR1B & (1 << RXB81)) ? 0x0100 : 0);
+		Echo |= UDR1;
+
+		Link_BurstEchoPattern = Link_NextPattern(Link_BurstEchoPattern);
+
+		for (uint16_t Difference = ((Echo ^ Link_BurstEchoPattern) & 0x01FF); Difference; Difference &= (Difference - 1))
+		  Link_BurstErrors++;
+
+		Link_BurstReceived++;
+		Link_StateCycles = 0;
+	}
+
+	if (Link_BurstReceived >= Link_BurstBytes)
+	{
+		Link_BurstDone(Link_BurstErrors);
+		return;
+	}
+
+	if ((Link_BurstSent > Link_BurstReceived) && (Link_StateCycles >= LINK_US_TO_CYCLES(LINK_PROBE_TIMEOUT_US)))
+	{
+		Link_BurstDone(Link_BurstErrors + ((Link_BurstBytes - Link_BurstReceived) * 9));
+		return;
+	}
+
+	while ((Link_BurstSent < Link_BurstBytes) && ((Link_BurstSent - Link_BurstReceived) < LINK_PROBE_WINDOW) &&
+	       (UCSR1A & (1 << UDRE1)))
+	{
+		Link_BurstSendPattern = Link_NextPattern(Link_BurstSendPattern);
+
+		if (Link_BurstSendPattern & 0x0100)
+		  UCSR1B |= (1 << TXB81);
+		else
+		  UCSR1B &= ~(1 << TXB81);
+
+		/* The echo of a character is timed from when it was sent if nothing was in flight before it */
+		if (Link_BurstSent == Link_BurstReceived)
+		  Link_StateCycles = 0;
+
+		UDR1 = Link_BurstSendPattern;
+		Link_BurstSent++;
+	}
+}
+
+/** Advances the test pattern of a probe burst, a 16-bit xorshift generator whose lower nine bits are sent as each
+ *  character. Both the pattern sent and the one its echo is checked against are stepped with this.
+ *
+ *  \param[in] Pattern  Current state of the generator, never zero.
+ *
+ *  \return Next state of the generator.
+ */
+static uint16_t Link_NextPattern(uint16_t Pattern)
+{
+	Pattern ^= (Pattern << 7);
+	Pattern ^= (Pattern >> 9);
+	Pattern ^= (Pattern << 8);
+
+	return Pattern;
+}
+
+/** ISR to send the remaining bytes of the current sample frame, each time the USART is ready for the next one. */
+ISR(USART1_UDRE_vect, ISR_BLOCK)
+{
+	UCSR1B &= ~(1 << TXB81);
+	UDR1    = AudioArena.LinkTx.Queue[AudioArena.LinkTx.Index++];
+
+	if (AudioArena.LinkTx.Index == AudioArena.LinkTx.Count)
+	{
+		UCSR1B &= ~(1 << UDRIE1);
+		AudioArena.LinkTx.Count = 0;
+	}
+}
+
+/** ISR to collect the microphone samples the receiver sends back while capturing, into the microphone ring. */
+ISR(USART1_RX_vect, ISR_BLOCK)
+{
+	/* The status and ninth bit must be read before the data register, as reading UDR1 advances the receive FIFO */
+	uint8_t Status     = UCSR1A;
+	bool    FrameStart = (UCSR1B & (1 << RXB81));
+	uint8_t Data       = UDR1;
+
+	if (Status & (1 << FE1))
+	{
+		Link_ReceiverReset = true;
+		return;
+	}
+
+	if (FrameStart)
+	{
+		Link_CaptureHigh    = Data;
+		Link_CaptureAligned = true;
+	}
+	else if (Link_CaptureAligned)
+	{
+		MicRing_Push((int16_t)((((uint16_t)Link_CaptureHigh << 8) | Data) ^ 0x8000));
+		Link_CaptureAligned = false;
+	}
+}
@@ -0,0 +1,194 @@
+/** \file
+ *
+ *  Header file for Link.c.
+ */
+
+#ifndef _LINK_H_
+#define _LINK_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <avr/interrupt.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+
+		#include "Arena.h"
+		#include "LinkProtocol.h"
+		#include "MicRing.h"
+		#include "Trace.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+		#include <LUFA/Drivers/Peripheral/Serial.h>
+
+	/* Macros: */
+		/** Number of handshakes attempted before the link falls back to the base mode. */
+		#define LINK_HANDSHAKE_ATTEMPTS      3
+
+		/** Time in milliseconds to wait for each byte of the receiver's handshake reply. */
+		#define LINK_HANDSHAKE_TIMEOUT_MS    10
+
+		/** Number of characters in the burst of the test pattern sent at each rate probed. */
+		#define LINK_PROBE_BYTES             256
+
+		/** Number of characters in the burst which confirms the first rate to pass the probe; at 9 bits each, no
+		 *  errors over it puts the rate's bit error rate well below one in ten thousand.
+		 */
+		#define LINK_PROBE_CONFIRM_BYTES     4096
+
+		/** Most characters of the test pattern in flight at once, before their echo has come back. */
+		#define LINK_PROBE_WINDOW            2
+
+		/** Time in microseconds without an echo after which the rest of a probe burst is counted as lost. */
+		#define LINK_PROBE_TIMEOUT_US        500
+
+		/** Starting state of the test pattern generator. */
+		#define LINK_PROBE_SEED              0xACE1
+
+		/** Time in microseconds the receiver is given to switch to a new mode once it has accepted a handshake. */
+		#define LINK_SETTLE_US               50
+
+		/** Pin mask of the USART TX line on PORTD, driven manually to generate a break. */
+		#define LINK_TX_PIN_MASK             (1 << 3)
+
+		/** Converts a time in microseconds to system clock cycles, the unit Timer 1 counts the link's timeouts in.
+		 *
+		 *  \param[in] Us  Time in microseconds.
+		 */
+		#define LINK_US_TO_CYCLES(Us)        ((uint32_t)(F_CPU / 1000000UL) * (Us))
+
+	/* Enums: */
+		/** Enum for the steps of the link state machine, which is stepped by \ref Link_Task() from the main loop. */
+		enum Link_States_t
+		{
+			LINK_STATE_Idle       = 0, /**< Nothing in progress, waiting for a negotiation to be asked for */
+			LINK_STATE_Break      = 1, /**< Holding the TX line low to return the receiver to the base mode */
+			LINK_STATE_BreakIdle  = 2, /**< Holding the TX line idle after a break, while the receiver reconfigures */
+			LINK_STATE_SendSync   = 3, /**< Sending the handshake bytes as the USART is ready for each */
+			LINK_STATE_WaitAck    = 4, /**< Waiting for the receiver's answer to the handshake */
+			LINK_STATE_WaitConfig = 5, /**< Waiting for the receiver to echo the config it acknowledged */
+			LINK_STATE_Settle     = 6, /**< Giving the receiver time to switch to the accepted mode */
+			LINK_STATE_Probe      = 7, /**< Sending a burst of the test pattern and checking the receiver's echo */
+		};
+
+		/** Enum for the jobs the link state machine carries out. */
+		enum Link_Jobs_t
+		{
+			LINK_JOB_Stop      = 0, /**< Break to mute the receiver, leaving the transmitter disabled */
+			LINK_JOB_Reset     = 1, /**< Break to return the receiver to the base mode after a probe */
+			LINK_JOB_Probe     = 2, /**< Probe the rates the receiver can be reached at */
+			LINK_JOB_Negotiate = 3, /**< Negotiate the mode asked for with \ref Link_Negotiate() */
+		};
+
+	/* External Variables: */
+		extern volatile bool Link_Ready;
+		extern bool          Link_Negotiated;
+		extern uint8_t       Link_Baud;
+		extern uint8_t       Link_Format;
+		extern uint8_t       Link_MaxBaud;
+		extern uint8_t       Link_ProbeResult;
+		extern uint16_t      Link_ProbeErrors;
+		extern volatile uint16_t Link_Drops;
+
+	/* Inline Functions: */
+		/** Determines the number of bytes sent over the link for each sample frame.
+		 *
+		 *  \param[in] Format  Mask of \c LINK_FORMAT_* flags.
+		 *
+		 *  \return Number of bytes in each sample frame.
+		 */
+		static inline uint8_t Link_BytesPerFrame(const uint8_t Format)
+		{
+			uint8_t FrameBytes = (Format & LINK_FORMAT_16BIT) ? 2 : 1;
+
+			return (Format & LINK_FORMAT_STEREO) ? (FrameBytes * 2) : FrameBytes;
+		}
+
+		/** Sends a single sample frame over the link in the negotiated format. The first byte is written to the
+		 *  USART directly, and the rest of the frame is sent from the USART data register empty interrupt. This never
+		 *  waits on the USART: if the link is still busy with the previous frame the frame is dropped and counted in
+		 *  \ref Link_Drops, and while the link is being renegotiated it is dropped silently.
+		 *
+		 *  \param[in] LeftSample   Signed 16-bit left sample, or the mono sample in mono formats.
+		 *  \param[in] RightSample  Signed 16-bit right sample, ignored in mono formats.
+		 */
+		static inline void Link_SendFrame(const int16_t LeftSample,
+		                                  const int16_t RightSample)
+		{
+			uint16_t LeftLinkSample  = ((uint16_t)LeftSample  ^ 0x8000);
+			uint16_t RightLinkSample = ((uint16_t)RightSample ^ 0x8000);
+
+			if (!(Link_Ready))
+			  return;
+
+			if (AudioArena.LinkTx.Count || !(UCSR1A & (1 << UDRE1)))
+			{
+				if (Link_Drops != UINT16_MAX)
+				  Link_Drops++;
+
+				Trace_Record(TRACE_EVENT_LinkDrop, Link_Format);
+				return;
+			}
+
+			if (!(Link_Format))
+			{
+				UDR1 = (LeftLinkSample >> 8);
+				return;
+			}
+
+			uint8_t TxCount = 0;
+
+			if (Link_Format & LINK_FORMAT_16BIT)
+			  AudioArena.LinkTx.Queue[TxCount++] = (LeftLinkSample & 0xFF);
+
+			if (Link_Format & LINK_FORMAT_STEREO)
+			{
+				AudioArena.LinkTx.Queue[TxCount++] = (RightLinkSample >> 8);
+
+				if (Link_Format & LINK_FORMAT_16BIT)
+				  AudioArena.LinkTx.Queue[TxCount++] = (RightLinkSample & 0xFF);
+			}
+
+			/* Mark the first byte as the start of the frame, the interrupt clears the marker for the rest */
+			UCSR1B |= (1 << TXB81);
+			UDR1    = (LeftLinkSample >> 8);
+
+			AudioArena.LinkTx.Index = 0;
+			AudioArena.LinkTx.Count = TxCount;
+			UCSR1B |= (1 << UDRIE1);
+		}
+
+	/* Function Prototypes: */
+		void Link_Init(void);
+		void Link_Negotiate(const uint8_t Baud,
+		                    const uint8_t Format,
+		                    const uint32_t SampleRate);
+		bool Link_Task(void);
+		bool Link_FitsBandwidth(const uint8_t Baud,
+		                        const uint8_t Format,
+		                        const uint32_t SampleRate) ATTR_CONST;
+		bool Link_IsRenegotiationNeeded(void);
+		void Link_Stop(void);
+		uint16_t Link_GetDrops(void);
+
+		#if defined(INCLUDE_FROM_LINK_C)
+			static void Link_Configure(const uint8_t Baud,
+			                           const uint8_t Format);
+			static void Link_SetState(const uint8_t State);
+			static void Link_StartNegotiation(void);
+			static void Link_StartProbe(const int8_t Baud);
+			static void Link_StartHandshake(const uint8_t Job,
+			                                const uint8_t Config,
+			                                const uint8_t Baud,
+			                                const uint8_t Format);
+			static void Link_SendBreak(void);
+			static void Link_BreakSent(void);
+			static void Link_RetryHandshake(void);
+			static void Link_HandshakeDone(const int16_t Reply);
+			static void Link_BurstDone(const uint16_t Errors);
+			static void Link_StartBurst(const uint16_t Bytes);
+			static void Link_ProbeStep(void);
+			static uint16_t Link_NextPattern(uint16_t Pattern);
+		#endif
+
+#endif
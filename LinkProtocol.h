@@ -0,0 +1,107 @@
+/** \file
+ *
+ *  Definitions shared by the ATMEGA16U2 firmware and the ATMEGA328 receiver firmware, describing the
+ *  serial link used to carry audio samples between the two microcontrollers.
+ *
+ *  Both ends start at \ref LINK_BASE_BAUD in 8N1 mode, where every byte is an unsigned 8-bit mono sample.
+ *  To negotiate a faster link, the ATMEGA16U2 sends a break condition (the TX line held low for longer
+ *  than a full character) followed by the handshake sequence \ref LINK_SYNC1, \ref LINK_SYNC2, config,
+ *  ~config at the base rate, where config is built with \ref LINK_CONFIG(). The receiver replies with
+ *  \ref LINK_ACK and the accepted config byte, after which both ends switch to the negotiated mode.
+ *
+ *  Samples are sent offset-binary (signed sample XOR 0x8000), most significant byte first, with the left
+ *  sample ahead of the right sample in stereo formats. When a sample frame is a single byte it is sent as a
+ *  plain 8N1 character; otherwise every byte of the frame is sent as a 9-bit character, with the ninth bit
+ *  set on the first byte of the frame only so that the receiver can realign itself after a dropped byte.
+ *
+ *  With \ref LINK_FORMAT_CAPTURE the receiver also answers every frame it receives with one 16-bit microphone
+ *  sample, sent back the same way as a 16-bit mono frame: offset-binary, most significant byte first, as two
+ *  9-bit characters with the ninth bit set on the first. The forward frames are the capture's sample clock, and
+ *  a framing error in the return direction means the receiver has reset and is talking at the base rate.
+ *
+ *  A handshake whose config carries \ref LINK_CONFIG_PROBE instead of format flags asks the receiver to test the
+ *  given baud rate rather than stream at it. Once acknowledged both ends switch to that rate with 9-bit characters,
+ *  the longest the link ever carries, and the receiver echoes every character it receives, ninth bit included,
+ *  until the next break. The ATMEGA16U2 sends a pseudo-random pattern and counts the bits which come back wrong,
+ *  so each rate is tested in both directions at once. Receivers which predate probing reject the handshake.
+ */
+
+#ifndef _LINK_PROTOCOL_H_
+#define _LINK_PROTOCOL_H_
+
+	/* Macros: */
+		/** \ref Link_Bauds_t code of the baud rate both ends of the link start at, and fall back to when
+		 *  negotiation fails.
+		 */
+		#define LINK_BASE_BAUD            LINK_BAUD_500K
+
+		/** Baud rate in bits per second of the given \ref Link_Bauds_t code. */
+		#define LINK_BAUD_RATE(Code)      (250000UL << (Code))
+
+		/** USART UBRR register value for the given \ref Link_Bauds_t code, when running in double speed mode. */
+		#define LINK_UBRR_2X(Code)        (((F_CPU / 8) / LINK_BAUD_RATE(Code)) - 1)
+
+		/** Link format flag, indicating full 16-bit samples instead of the upper 8 bits only. */
+		#define LINK_FORMAT_16BIT         (1 << 0)
+
+		/** Link format flag, indicating separate left and right samples instead of a single mono mix. */
+		#define LINK_FORMAT_STEREO        (1 << 1)
+
+		/** Link format flag, asking the receiver to capture its microphone input and send one sample back for
+		 *  each frame. Only valid in formats with multi-byte frames, as the samples come back as 9-bit characters.
+		 */
+		#define LINK_FORMAT_CAPTURE       (1 << 2)
+
+		/** Mask of all link format flags understood by this version of the protocol. */
+		#define LINK_FORMAT_MASK          (LINK_FORMAT_16BIT | LINK_FORMAT_STEREO | LINK_FORMAT_CAPTURE)
+
+		/** Largest number of bytes in a sample frame, a 16-bit stereo frame. */
+		#define LINK_MAX_FRAME_BYTES      4
+
+		/** Builds a handshake config byte from a \ref Link_Bauds_t code and a mask of \c LINK_FORMAT_* flags. */
+		#define LINK_CONFIG(Baud, Format) (((Baud) << 4) | (Format))
+
+		/** Extracts the \ref Link_Bauds_t code from a handshake config byte. */
+		#define LINK_CONFIG_BAUD(Config)  ((Config) >> 4)
+
+		/** Handshake config flag, sent in place of the format flags, asking the receiver to echo a test pattern at the
+		 *  given baud rate instead of streaming samples.
+		 */
+		#define LINK_CONFIG_PROBE         (1 << 3)
+
+		/** Extracts the \c LINK_FORMAT_* flags from a handshake config byte. */
+		#define LINK_CONFIG_FORMAT(Config) ((Config) & 0x0F)
+
+		/** First byte of the handshake sequence. */
+		#define LINK_SYNC1                0xA5
+
+		/** Second byte of the handshake sequence. */
+		#define LINK_SYNC2                0x5A
+
+		/** Byte sent by the receiver to accept a handshake, followed by the accepted config byte. */
+		#define LINK_ACK                  0x06
+
+		/** Byte sent by the receiver to reject a handshake it does not support. */
+		#define LINK_NAK                  0x15
+
+		/** Byte sent by the receiver at the base rate when it comes out of reset, to request a new handshake. */
+		#define LINK_HELLO                0x3C
+
+		/** Duration in microseconds the TX line is held low to signal a break. This must be longer than a
+		 *  full character at the slowest baud rate either end can be running at.
+		 */
+		#define LINK_BREAK_US             250
+
+	/* Enums: */
+		/** Enum for the baud rates the link can be negotiated to. All of these divide exactly from a
+		 *  16MHz clock in double speed mode, giving 0% baud rate error.
+		 */
+		enum Link_Bauds_t
+		{
+			LINK_BAUD_250K = 0, /**< 250 kbaud */
+			LINK_BAUD_500K = 1, /**< 500 kbaud, the base rate of the link */
+			LINK_BAUD_1M   = 2, /**< 1 Mbaud */
+			LINK_BAUD_2M   = 3, /**< 2 Mbaud, the fastest rate supported by the USART at 16MHz */
+		};
+
+#endif
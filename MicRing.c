@@ -0,0 +1,17 @@
+/** \file
+ *
+ *  Ring buffer of microphone samples between the link receive ISR, which fills it as the ATMEGA328 sends back
+ *  each captured sample, and the main loop, which drains it into the microphone stream once per USB frame.
+ *  As with the sample ring, the head index is only written by the ISR and the tail index only by the main loop.
+ */
+
+#include "MicRing.h"
+
+/** Captured microphone samples waiting to be sent to the host. */
+MicRing_t MicRing;
+
+/** Empties the ring, when the link is renegotiated. This must only be called from the main loop. */
+void MicRing_Reset(void)
+{
+	MicRing.Tail = MicRing.Head;
+}
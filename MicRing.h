@@ -0,0 +1,83 @@
+/** \file
+ *
+ *  Header file for MicRing.c.
+ */
+
+#ifndef _MIC_RING_H_
+#define _MIC_RING_H_
+
+	/* Includes: */
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if ((MIC_RING_SIZE & (MIC_RING_SIZE - 1)) || (MIC_RING_SIZE > 128))
+			#error MIC_RING_SIZE must be a power of two no larger than 128.
+		#endif
+
+	/* Macros: */
+		/** Mask applied to the free running ring indexes to find the entry they refer to. */
+		#define MIC_RING_MASK             (MIC_RING_SIZE - 1)
+
+	/* Type Defines: */
+		/** Type define for the ring of captured microphone samples. */
+		typedef struct
+		{
+			int16_t          Data[MIC_RING_SIZE]; /**< Signed 16-bit microphone samples */
+			volatile uint8_t Head; /**< Free running index of the next entry to write, only written by the link receive ISR */
+			volatile uint8_t Tail; /**< Free running index of the next entry to read, only written by the main loop */
+			uint8_t          Overruns; /**< Number of samples dropped as the ring was full, wrapping at 255 */
+		} MicRing_t;
+
+	/* External Variables: */
+		extern MicRing_t MicRing;
+
+	/* Inline Functions: */
+		/** Retrieves the number of samples currently held in the ring.
+		 *
+		 *  \return Number of samples waiting to be sent to the host.
+		 */
+		static inline uint8_t MicRing_Count(void)
+		{
+			return (uint8_t)(MicRing.Head - MicRing.Tail);
+		}
+
+		/** Adds a captured sample to the ring, dropping it if the host has stopped reading. This must only be
+		 *  called from the link receive ISR.
+		 *
+		 *  \param[in] Sample  Signed 16-bit sample to add.
+		 */
+		static inline void MicRing_Push(const int16_t Sample)
+		{
+			uint8_t Head = MicRing.Head;
+
+			if ((uint8_t)(Head - MicRing.Tail) == MIC_RING_SIZE)
+			{
+				MicRing.Overruns++;
+				return;
+			}
+
+			MicRing.Data[Head & MIC_RING_MASK] = Sample;
+			MicRing.Head = (Head + 1);
+		}
+
+		/** Removes the oldest sample from the ring. This must only be called from the main loop, and only when
+		 *  the ring is not empty.
+		 *
+		 *  \return Signed 16-bit sample removed from the ring.
+		 */
+		static inline int16_t MicRing_Pop(void)
+		{
+			uint8_t Tail   = MicRing.Tail;
+			int16_t Sample = MicRing.Data[Tail & MIC_RING_MASK];
+
+			MicRing.Tail = (Tail + 1);
+			return Sample;
+		}
+
+	/* Function Prototypes: */
+		void MicRing_Reset(void);
+
+#endif
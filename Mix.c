@@ -0,0 +1,175 @@
+/** \file
+ *
+ *  Fixed point downmix matrix, which folds the \c AUDIO_IN_CHANNELS channels of the speaker stream into the
+ *  channels carried by the link. Each crosspoint of the matrix has a gain in whole dB, which the host sets
+ *  through the programmable controls of the mixer unit in the audio control interface; the gains are turned
+ *  into linear Q1.14 coefficients whenever they or the link layout change, so that the per-frame work is only
+ *  a multiply and accumulate for each crosspoint in use.
+ */
+
+#define  INCLUDE_FROM_MIX_C
+#include "Mix.h"
+
+/** Linear Q1.14 gain for each whole dB from \ref MIX_GAIN_MIN_DB to \ref MIX_GAIN_MAX_DB. */
+static const int16_t PROGMEM Mix_GainTable[] =
+	{
+		   16,    18,    21,    23,    26,    29,    33,    37,    41,    46,
+		   52,    58,    65,    73,    82,    92,   103,   116,   130,   146,
+		  164,   184,   206,   231,   260,   291,   327,   367,   412,   462,
+		  518,   581,   652,   732,   821,   921,  1034,  1160,  1301,  1460,
+		 1638,  1838,  2063,  2314,  2597,  2914,  3269,  3668,  4115,  4618,
+		 5181,  5813,  6523,  7318,  8211,  9213, 10338, 11599, 13014, 14602,
+		16384, 18383, 20626, 23143, 25967, 29135, 32690,
+	};
+
+/** Default crosspoint gains in dB, folding the surround channels into the front pair at levels that cannot
+ *  clip. The stream channels are in the order of the bits of the input terminal's channel configuration.
+ */
+static const int8_t PROGMEM Mix_DefaultGains[AUDIO_IN_CHANNELS][MIX_OUTPUTS] =
+	{
+		#define S MIX_GAIN_SILENT
+		#if (AUDIO_IN_CHANNELS == 1)
+		{  0,   0}, // Mono
+		#elif (AUDIO_IN_CHANNELS == 2)
+		{  0,   S}, // Left
+		{  S,   0}, // Right
+		#elif (AUDIO_IN_CHANNELS == 4)
+		{ -6,   S}, // Left
+		{  S,  -6}, // Right
+		{ -6,   S}, // Left Surround
+		{  S,  -6}, // Right Surround
+		#else
+		{ -8,   S}, // Left
+		{  S,  -8}, // Right
+		{-11, -11}, // Center
+		#if (AUDIO_IN_CHANNELS == 6)
+		{  S,   S}, // Low Frequency Effects
+		#endif
+		{-11,   S}, // Left Surround
+		{  S, -11}, // Right Surround
+		#endif
+		#undef S
+	};
+
+/** Crosspoint gains in whole dB, as set by the host. */
+static int8_t  Mix_Gains[AUDIO_IN_CHANNELS][MIX_OUTPUTS];
+
+/** Q1.14 coefficients for each output channel of the current link layout. */
+static int16_t Mix_Coefficients[MIX_OUTPUTS][AUDIO_IN_CHANNELS];
+
+/** Number of output channels in the current link layout. */
+static uint8_t Mix_Outputs = 1;
+
+/** Restores the default crosspoint gains. */
+void Mix_Init(void)
+{
+	memcpy_P(Mix_Gains, Mix_DefaultGains, sizeof(Mix_Gains));
+	Mix_UpdateCoefficients();
+}
+
+/** Sets the number of output channels the matrix produces for each frame, to match the link.
+ *
+ *  \param[in] Outputs  Number of entries in each frame of the sample ring, 1 for mono or 2 for stereo.
+ */
+void Mix_SetLayout(const uint8_t Outputs)
+{
+	Mix_Outputs = Outputs;
+	Mix_UpdateCoefficients();
+}
+
+/** Sets the gain of a matrix crosspoint.
+ *
+ *  \param[in] Input      Zero based input channel.
+ *  \param[in] Output     Zero based output channel.
+ *  \param[in] GainDB256  Gain in 1/256 dB, rounded to the nearest whole dB and limited to the supported range,
+ *                        or \ref MIX_GAIN_SILENT_DB256 to silence the crosspoint.
+ */
+void Mix_SetGain(const uint8_t Input,
+                 const uint8_t Output,
+                 const int16_t GainDB256)
+{
+	int8_t Gain;
+
+	if (GainDB256 == MIX_GAIN_SILENT_DB256)
+	  Gain = MIX_GAIN_SILENT;
+	else
+	  Gain = MAX(MIN((((int32_t)GainDB256 + 128) >> 8), MIX_GAIN_MAX_DB), MIX_GAIN_MIN_DB);
+
+	Mix_Gains[Input][Output] = Gain;
+	Mix_UpdateCoefficients();
+}
+
+/** Retrieves the gain of a matrix crosspoint.
+ *
+ *  \param[in] Input   Zero based input channel.
+ *  \param[in] Output  Zero based output channel.
+ *
+ *  \return Gain in 1/256 dB, or \ref MIX_GAIN_SILENT_DB256 if the crosspoint is silent.
+ */
+int16_t Mix_GetGain(const uint8_t Input,
+                    const uint8_t Output)
+{
+	int8_t Gain = Mix_Gains[Input][Output];
+
+	return (Gain == MIX_GAIN_SILENT) ? MIX_GAIN_SILENT_DB256 : (Gain * 256);
+}
+
+/** Mixes one frame of the speaker stream down to the link layout.
+ *
+ *  \param[in]  Input   One sample for each of the \c AUDIO_IN_CHANNELS stream channels.
+ *  \param[out] Output  Location to store one sample for each output channel of the current layout.
+ */
+void Mix_Process(const int16_t* const Input,
+                 int16_t* Output)
+{
+	const int16_t* Coefficient = &Mix_Coefficients[0][0];
+
+	for (uint8_t OutputChannel = 0; OutputChannel < Mix_Outputs; OutputChannel++)
+	{
+		int32_t Sum = 0;
+
+		for (uint8_t InputChannel = 0; InputChannel < AUDIO_IN_CHANNELS; InputChannel++)
+		{
+			/* Most crosspoints of a downmix are silent, and skipping them is cheaper than the multiply */
+			if (*Coefficient)
+			  Sum += ((int32_t)Input[InputChannel] * *Coefficient);
+
+			Coefficient++;
+		}
+
+		Sum >>= MIX_COEFFICIENT_BITS;
+
+		*(Output++) = MAX(MIN(Sum, INT16_MAX), INT16_MIN);
+	}
+}
+
+/** Converts the crosspoint gains into the coefficients of the current layout. A mono layout has a single row
+ *  of coefficients, averaging those of the left and right outputs.
+ */
+static void Mix_UpdateCoefficients(void)
+{
+	for (uint8_t InputChannel = 0; InputChannel < AUDIO_IN_CHANNELS; InputChannel++)
+	{
+		int16_t Coefficients[MIX_OUTPUTS];
+
+		for (uint8_t OutputChannel = 0; OutputChannel < MIX_OUTPUTS; OutputChannel++)
+		{
+			int8_t Gain = Mix_Gains[InputChannel][OutputChannel];
+
+			if (Gain == MIX_GAIN_SILENT)
+			  Coefficients[OutputChannel] = 0;
+			else
+			  Coefficients[OutputChannel] = pgm_read_word(&Mix_GainTable[Gain - MIX_GAIN_MIN_DB]);
+		}
+
+		if (Mix_Outputs == 1)
+		{
+			Mix_Coefficients[0][InputChannel] = (((int32_t)Coefficients[0] + Coefficients[1]) >> 1);
+		}
+		else
+		{
+			Mix_Coefficients[0][InputChannel] = Coefficients[0];
+			Mix_Coefficients[1][InputChannel] = Coefficients[1];
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/** \file
+ *
+ *  Header file for Mix.c.
+ */
+
+#ifndef _MIX_H_
+#define _MIX_H_
+
+	/* Includes: */
+		#include <avr/pgmspace.h>
+		#include <stdint.h>
+
+		#include <LUFA/Common/Common.h>
+
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if !defined(AUDIO_IN_CHANNELS)
+			#error AUDIO_IN_CHANNELS must be defined to the number of channels in the speaker stream.
+		#elif ((AUDIO_IN_CHANNELS < 1) || (AUDIO_IN_CHANNELS > 6) || (AUDIO_IN_CHANNELS == 3))
+			#error AUDIO_IN_CHANNELS must be 1, 2, 4, 5 or 6.
+		#endif
+
+	/* Macros: */
+		/** Number of output channels of the downmix matrix, the left and right channels of a stereo link. A mono
+		 *  link carries the average of the two.
+		 */
+		#define MIX_OUTPUTS                2
+
+		/** Number of fractional bits in the fixed point matrix coefficients, so that unity gain is 1 << 14. */
+		#define MIX_COEFFICIENT_BITS       14
+
+		/** Lowest gain of a matrix crosspoint short of silence, in whole dB. */
+		#define MIX_GAIN_MIN_DB            -60
+
+		/** Highest gain of a matrix crosspoint, in whole dB. */
+		#define MIX_GAIN_MAX_DB            6
+
+		/** Stored gain of a silent matrix crosspoint. */
+		#define MIX_GAIN_SILENT            INT8_MIN
+
+		/** Gain of a silent matrix crosspoint, in the 1/256 dB units of the audio class mixer controls. */
+		#define MIX_GAIN_SILENT_DB256      INT16_MIN
+
+	/* Function Prototypes: */
+		void    Mix_Init(void);
+		void    Mix_SetLayout(const uint8_t Outputs);
+		void    Mix_SetGain(const uint8_t Input,
+		                    const uint8_t Output,
+		                    const int16_t GainDB256);
+		int16_t Mix_GetGain(const uint8_t Input,
+		                    const uint8_t Output);
+		void    Mix_Process(const int16_t* const Input,
+		                    int16_t* Output);
+
+		#if defined(INCLUDE_FROM_MIX_C)
+			static void Mix_UpdateCoefficients(void);
+		#endif
+
+#endif
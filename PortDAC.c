@@ -0,0 +1,18 @@
+/** \file
+ *
+ *  Parallel R-2R ladder DAC output for the AUDIO_OUT_PORTC mode, driven directly by the ATMEGA16U2 in place
+ *  of the serial link to the ATMEGA328. The four most significant bits of each sample are output on PC4 to
+ *  PC7, and the next 4 or 8 bits (see \c PORTC_DAC_BITS) on the upper or all pins of PORTB.
+ */
+
+#define  INCLUDE_FROM_PORTDAC_C
+#include "PortDAC.h"
+
+/** Configures the ladder pins as outputs, and sets the ladder to midscale (silence). */
+void PortDAC_Init(void)
+{
+	DDRB |= PORT_DAC_PORTB_MASK;
+	DDRC |= PORT_DAC_PORTC_MASK;
+
+	PortDAC_Output(0);
+}
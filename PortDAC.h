@@ -0,0 +1,58 @@
+/** \file
+ *
+ *  Header file for PortDAC.c.
+ */
+
+#ifndef _PORT_DAC_H_
+#define _PORT_DAC_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <stdint.h>
+
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if !defined(PORTC_DAC_BITS)
+			#define PORTC_DAC_BITS           8
+		#elif ((PORTC_DAC_BITS != 8) && (PORTC_DAC_BITS != 12))
+			#error PORTC_DAC_BITS must be 8 or 12.
+		#endif
+
+	/* Macros: */
+		/** Pins of PORTC carrying the four most significant bits of each sample. PC0 and PC1 are the crystal and
+		 *  reset pins, so PC4 to PC7 are the only run of free PORTC pins wide enough for a nibble.
+		 */
+		#define PORT_DAC_PORTC_MASK          0xF0
+
+		#if (PORTC_DAC_BITS == 12) || defined(__DOXYGEN__)
+			/** Pins of PORTB carrying the sample bits below those on PORTC. In 12-bit mode all of PORTB is used,
+			 *  including the ICSP pins; in 8-bit mode only PB4 to PB7, which are brought out on the JP2 header.
+			 */
+			#define PORT_DAC_PORTB_MASK      0xFF
+		#else
+			#define PORT_DAC_PORTB_MASK      0xF0
+		#endif
+
+	/* Inline Functions: */
+		/** Drives a sample onto the R-2R ladder. The PORTB bits are written first, so the short glitch between
+		 *  the two port writes is in the less significant bits.
+		 *
+		 *  \param[in] Sample  Signed 16-bit sample to output, truncated to \c PORTC_DAC_BITS bits.
+		 */
+		static inline void PortDAC_Output(const int16_t Sample)
+		{
+			uint16_t Value = ((uint16_t)Sample ^ 0x8000);
+
+			#if (PORTC_DAC_BITS == 12)
+			PORTB = (uint8_t)(Value >> 4);
+			#else
+			PORTB = ((PORTB & ~PORT_DAC_PORTB_MASK) | ((uint8_t)(Value >> 4) & PORT_DAC_PORTB_MASK));
+			#endif
+			PORTC = ((PORTC & ~PORT_DAC_PORTC_MASK) | ((uint8_t)(Value >> 8) & PORT_DAC_PORTC_MASK));
+		}
+
+	/* Function Prototypes: */
+		void PortDAC_Init(void);
+
+#endif
@@ -0,0 +1,353 @@
+/** \file
+ *
+ *  Microphone capture for the ATMEGA328 receiver. This is experimental: the ADC is clocked above its range for
+ *  full accuracy (see \ref CAPTURE_ADC_PRESCALER) and the resolution of the captured stream has not been measured. While the link is negotiated with \ref LINK_FORMAT_CAPTURE,
+ *  the receiver answers every sample frame from the ATMEGA16U2 with one 16-bit sample of the ADC input, so
+ *  the forward stream is the capture's sample clock.
+ *
+ *  The ADC is oversampled and decimated by a first order CIC, the average of a fixed number of conversions for
+ *  each output sample, which gains half a bit of resolution for each doubling of the conversions as long as
+ *  the input carries about an LSB of noise to dither it. Starting the conversions from the main loop as each
+ *  frame arrives would let the arrival jitter of the frames into the sampling instants, which at a few
+ *  microseconds costs more than the oversampling gains; instead the conversions are triggered by timer 0, and
+ *  the timer's period is phase locked to the incoming frames. The loop filters out the arrival jitter, so the
+ *  input is sampled at evenly spaced instants at the average frame rate.
+ *
+ *  At the start of each capture the frame period is measured over \ref CAPTURE_MEASURE_FRAMES frames, and the
+ *  number of conversions for each output sample is set to as many as fit in it. Each output sample is then
+ *  sent on the frame after it completes, half a frame period after its last conversion.
+ */
+
+#define  INCLUDE_FROM_CAPTURE_C
+#include "Capture.h"
+
+/** Reciprocals of each number of conversions, scaled so that the average of the 10-bit conversions comes out
+ *  as a 16-bit sample: entry n - 1 holds 2^(6 + \ref CAPTURE_RECIPROCAL_BITS) / n.
+ */
+static const uint16_t PROGMEM Capture_Reciprocals[CAPTURE_MAX_CONVERSIONS] =
+	{
+		32768, 16384, 10923,  8192,  6554,  5461,  4681,  4096,
+		 3641,  3277,  2979,  2731,  2521,  2341,  2185,  2048,
+	};
+
+/** Current state of the capture engine, a value from \ref Capture_States_t. */
+static uint8_t           Capture_State;
+
+/** Number of conversions decimated into each output sample. */
+static uint8_t           Capture_Conversions;
+
+/** Measured and current period of the conversions, in 8.8 fixed point timer 0 ticks. */
+static uint16_t          Capture_NominalPeriod;
+static volatile uint16_t Capture_Period;
+
+/** Fraction of a tick carried between conversion periods by the timer 0 ISR. */
+static uint8_t           Capture_PeriodFraction;
+
+/** Number of conversions of the current output sample which have been triggered, wrapping at the count. */
+static volatile uint8_t  Capture_Slot;
+
+/** Length of a frame in timer 0 ticks, and the point in each output sample's conversions the frames are locked
+ *  to, in ticks from the trigger of its first conversion.
+ */
+static uint16_t          Capture_FrameTicks;
+static uint16_t          Capture_TargetPhase;
+
+/** Integrated phase error of the lock, in timer 0 ticks. */
+static int16_t           Capture_Integrator;
+
+/** Sum of the conversions of the output sample in progress, and the number of them summed so far. */
+static uint16_t          Capture_Sum;
+static uint8_t           Capture_Count;
+
+/** Sum of the conversions of the last complete output sample, and whether it has still to be sent. */
+static volatile uint16_t Capture_Window;
+static volatile bool     Capture_WindowReady;
+
+/** Frames timed so far, the time of the first, and the overflow count extending timer 0, while measuring. */
+static uint8_t           Capture_MeasuredFrames;
+static uint16_t          Capture_MeasureStart;
+static uint8_t           Capture_Overflows;
+
+/** Last sample sent, repeated if a frame arrives before the next one is complete. */
+static uint16_t          Capture_LastSample;
+
+/** Low byte of the last sample, and whether it is still waiting for the USART. */
+static uint8_t           Capture_PendingLow;
+static bool              Capture_LowPending;
+
+/** Starts a capture, timing the incoming frames on timer 0. Samples of silence are sent until the conversions
+ *  are locked to the frames. The microphone input is converted against AVcc, and must be biased to half the
+ *  supply so that silence comes out as a zero sample.
+ */
+void Capture_Start(void)
+{
+	Capture_LastSample     = 0x8000;
+	Capture_LowPending     = false;
+	Capture_MeasuredFrames = 0;
+	Capture_Overflows      = 0;
+
+	/* Timer 0 free-running at Fcpu/8 while measuring, for a 16-bit time in half microseconds */
+	TIMSK0 = 0;
+	TCCR0A = 0;
+	TCCR0B = (1 << CS01);
+	TIFR0  = ((1 << OCF0A) | (1 << TOV0));
+
+	/* The first conversion after the ADC is enabled takes 25 ADC clocks rather than 13, so get it out of the way
+	 * now; otherwise it would overrun the second trigger, and the count of conversions would fall out of step
+	 * with the count of triggers */
+	DIDR0  = (1 << CAPTURE_ADC_CHANNEL);
+	ADMUX  = ((1 << REFS0) | CAPTURE_ADC_CHANNEL);
+	ADCSRA = ((1 << ADEN) | (1 << ADSC) | CAPTURE_ADC_PRESCALER);
+
+	Capture_State = CAPTURE_STATE_Measuring;
+	sei();
+}
+
+/** Stops the ADC and timer 0, when the link returns to the base mode. */
+void Capture_Stop(void)
+{
+	ADCSRA = 0;
+	TIMSK0 = 0;
+	TCCR0B = 0;
+
+	Capture_State = CAPTURE_STATE_Off;
+}
+
+/** Processes the end of a received sample frame: times it while measuring, or corrects the lock with it once
+ *  locked, and sends the last complete output sample back over the link.
+ */
+void Capture_Frame(void)
+{
+	if (Capture_State == CAPTURE_STATE_Off)
+	  return;
+
+	if (Capture_State == CAPTURE_STATE_Measuring)
+	{
+		uint16_t Now = Capture_MeasureTime();
+
+		if (!(Capture_MeasuredFrames))
+		  Capture_MeasureStart = Now;
+
+		if (Capture_MeasuredFrames++ == CAPTURE_MEASURE_FRAMES)
+		  Capture_Lock(Now - Capture_MeasureStart);
+	}
+	else
+	{
+		Capture_Track();
+	}
+
+	Capture_Send();
+}
+
+/** Sends the low byte of the last sample once the USART can take it, and extends timer 0 while measuring. The
+ *  ninth bit is only changed while the transmit buffer is empty, so the high byte ahead of it keeps its frame
+ *  start marker.
+ */
+void Capture_Task(void)
+{
+	if (Capture_State == CAPTURE_STATE_Measuring)
+	  Capture_MeasureTime();
+
+	if (!(Capture_LowPending) || !(UCSR0A & (1 << UDRE0)))
+	  return;
+
+	UCSR0B &= ~(1 << TXB80);
+	UDR0    = Capture_PendingLow;
+
+	Capture_LowPending = false;
+}
+
+/** Reads the time while measuring the frame period, extending timer 0 to 16 bits. This must be called at
+ *  least once for each overflow of the timer, every 128 microseconds.
+ *
+ *  \return Time in timer 0 ticks of half a microsecond.
+ */
+static uint16_t Capture_MeasureTime(void)
+{
+	uint8_t Count = TCNT0;
+
+	/* If the timer has overflowed since the last call, the count may have been read either side of it */
+	if (TIFR0 & (1 << TOV0))
+	{
+		TIFR0 = (1 << TOV0);
+		Capture_Overflows++;
+		Count = TCNT0;
+	}
+
+	return (((uint16_t)Capture_Overflows << 8) | Count);
+}
+
+/** Sets up the conversions for the measured frame period, and starts them on timer 0. Conversions are as far
+ *  apart as they can be while still fitting as many as possible in a frame; when a single conversion is all
+ *  that fits, timer 0 runs at Fcpu/8 so that its period can be longer than 256 cycles.
+ *
+ *  \param[in] Ticks  Time taken by \ref CAPTURE_MEASURE_FRAMES frames, in ticks of 8 cycles.
+ */
+static void Capture_Lock(const uint16_t Ticks)
+{
+	uint16_t FrameCycles = (Ticks / (CAPTURE_MEASURE_FRAMES / 8));
+	uint8_t  Conversions = (FrameCycles / CAPTURE_CONVERSION_CYCLES);
+	uint8_t  Prescale    = 1;
+
+	if (!(Conversions))
+	  Conversions = 1;
+	else if (Conversions > CAPTURE_MAX_CONVERSIONS)
+	  Conversions = CAPTURE_MAX_CONVERSIONS;
+
+	/* Conversion period in 8.8 fixed point cycles, (Ticks * 8 * 256) / (CAPTURE_MEASURE_FRAMES * Conversions) */
+	uint32_t Period = (((uint32_t)Ticks << (11 - 6)) / Conversions);
+
+	if (Period > UINT16_MAX)
+	{
+		Period  >>= 3;
+		Prescale  = 8;
+	}
+
+	Capture_Conversions   = Conversions;
+	Capture_NominalPeriod = Period;
+	Capture_Period        = Period;
+	Capture_FrameTicks    = (((uint32_t)Period * Conversions) >> 8);
+
+	/* Lock the frames to half a frame after the last conversion of each output sample has been summed */
+	uint16_t Complete = (((Conversions - 1) * (Period >> 8)) + ((CAPTURE_CONVERSION_CYCLES + Prescale - 1) / Prescale));
+
+	Capture_TargetPhase = ((Complete + (Capture_FrameTicks / 2)) % Capture_FrameTicks);
+
+	Capture_Integrator     = 0;
+	Capture_PeriodFraction = (Period & 0xFF);
+	Capture_Slot           = 0;
+	Capture_Sum            = 0;
+	Capture_Count          = 0;
+	Capture_WindowReady    = false;
+
+	/* Timer 0 in CTC mode, with each compare match triggering a conversion of the microphone input */
+	TCCR0B = 0;
+	TCNT0  = 0;
+	TCCR0A = (1 << WGM01);
+	OCR0A  = ((Period >> 8) - 1);
+	TIFR0  = ((1 << OCF0A) | (1 << TOV0));
+	TIMSK0 = (1 << OCIE0A);
+
+	ADCSRB = ((1 << ADTS1) | (1 << ADTS0));
+	ADCSRA = ((1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADIF) | CAPTURE_ADC_PRESCALER);
+
+	TCCR0B = ((Prescale == 8) ? (1 << CS01) : (1 << CS00));
+
+	Capture_State = CAPTURE_STATE_Locked;
+}
+
+/** Measures the phase of the conversions against the end of a received frame, and corrects the conversion
+ *  period with a proportional and integral loop filter to hold the frames at the target phase.
+ */
+static void Capture_Track(void)
+{
+	uint8_t Count;
+	uint8_t Triggers;
+	bool    Pending;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Count    = TCNT0;
+		Triggers = Capture_Slot;
+		Pending  = (TIFR0 & (1 << OCF0A));
+
+		/* A compare match which has not been serviced yet has already started the next conversion period */
+		if (Pending)
+		  Count = TCNT0;
+	}
+
+	if (!(Triggers))
+	  Triggers = Capture_Conversions;
+
+	if (Pending)
+	  Triggers = ((Triggers == Capture_Conversions) ? 1 : (Triggers + 1));
+
+	int16_t Phase = (((Triggers - 1) * (uint8_t)(Capture_NominalPeriod >> 8)) + Count);
+	int16_t Error = (Phase - Capture_TargetPhase);
+
+	if (Error >= (int16_t)(Capture_FrameTicks / 2))
+	  Error -= Capture_FrameTicks;
+	else if (Error < -(int16_t)(Capture_FrameTicks / 2))
+	  Error += Capture_FrameTicks;
+
+	/* A frame arriving late in the conversions means they are running fast, so the period is lengthened */
+	Capture_Integrator += Error;
+
+	if (Capture_Integrator > CAPTURE_LOCK_INTEGRAL_LIMIT)
+	  Capture_Integrator = CAPTURE_LOCK_INTEGRAL_LIMIT;
+	else if (Capture_Integrator < -CAPTURE_LOCK_INTEGRAL_LIMIT)
+	  Capture_Integrator = -CAPTURE_LOCK_INTEGRAL_LIMIT;
+
+	uint16_t Period = (Capture_NominalPeriod + (Capture_Integrator >> CAPTURE_LOCK_INTEGRAL_SHIFT) + Error);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Capture_Period = Period;
+	}
+}
+
+/** Sends the last complete output sample back over the link as two 9-bit characters, most significant byte
+ *  first and marked as the start of the frame. The previous sample is repeated if no new one has completed.
+ *  If the USART is still busy with the last sample the new one is dropped, which the ATMEGA16U2 sees as a
+ *  short frame.
+ */
+static void Capture_Send(void)
+{
+	uint16_t Window = 0;
+	bool     Ready;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Ready = Capture_WindowReady;
+
+		if (Ready)
+		{
+			Window              = Capture_Window;
+			Capture_WindowReady = false;
+		}
+	}
+
+	if (Ready)
+	  Capture_LastSample = (((uint32_t)Window * pgm_read_word(&Capture_Reciprocals[Capture_Conversions - 1])) >> CAPTURE_RECIPROCAL_BITS);
+
+	if (Capture_LowPending || !(UCSR0A & (1 << UDRE0)))
+	  return;
+
+	UCSR0B |= (1 << TXB80);
+	UDR0    = (Capture_LastSample >> 8);
+
+	Capture_PendingLow = (Capture_LastSample & 0xFF);
+	Capture_LowPending = true;
+
+	Capture_Task();
+}
+
+/** ISR to set the length of the conversion period that has just started, carrying the fraction of a tick on
+ *  to the next. Servicing the interrupt also clears the compare flag, which must be cleared for the next
+ *  compare match to trigger a conversion.
+ */
+ISR(TIMER0_COMPA_vect, ISR_BLOCK)
+{
+	uint16_t Next = (Capture_PeriodFraction + Capture_Period);
+
+	OCR0A = ((Next >> 8) - 1);
+	Capture_PeriodFraction = (Next & 0xFF);
+
+	if (++Capture_Slot == Capture_Conversions)
+	  Capture_Slot = 0;
+}
+
+/** ISR to add each completed conversion to the output sample in progress. */
+ISR(ADC_vect, ISR_BLOCK)
+{
+	Capture_Sum += ADC;
+
+	if (++Capture_Count == Capture_Conversions)
+	{
+		Capture_Window      = Capture_Sum;
+		Capture_WindowReady = true;
+
+		Capture_Sum   = 0;
+		Capture_Count = 0;
+	}
+}
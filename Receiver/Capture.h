@@ -0,0 +1,76 @@
+/** \file
+ *
+ *  Header file for Capture.c.
+ */
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <avr/interrupt.h>
+		#include <avr/pgmspace.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "../LinkProtocol.h"
+
+	/* Macros: */
+		/** ADC input channel the microphone is captured from, ADC0 on Arduino pin A0. */
+		#define CAPTURE_ADC_CHANNEL          0
+
+		/** ADC clock prescaler bits, dividing the 16MHz system clock by 16 for a 1MHz ADC clock. This is above the
+		 *  50 to 200kHz the datasheet allows for full 10-bit accuracy, trading resolution for conversions: at
+		 *  200kHz a conversion takes longer than a frame at 11025Hz and up.
+		 */
+		#define CAPTURE_ADC_PRESCALER        (1 << ADPS2)
+
+		/** Shortest time in system clock cycles between two conversions: the 13.5 ADC clocks of an auto-triggered
+		 *  conversion, with a little left over for the two ISRs. This is also taken as the time from the trigger
+		 *  of a conversion until its result has been summed.
+		 */
+		#define CAPTURE_CONVERSION_CYCLES    232
+
+		/** Most conversions decimated into each output sample. */
+		#define CAPTURE_MAX_CONVERSIONS      16
+
+		/** Number of sample frames timed to measure the frame period before the conversions are locked to it. */
+		#define CAPTURE_MEASURE_FRAMES       64
+
+		/** Number of fractional bits of the reciprocal table used to average the conversions of a sample. */
+		#define CAPTURE_RECIPROCAL_BITS      9
+
+		/** Shift of the phase error integrator of the lock into the conversion period, setting the loop's
+		 *  bandwidth and damping. The proportional path adds the phase error itself.
+		 */
+		#define CAPTURE_LOCK_INTEGRAL_SHIFT  4
+
+		/** Limit of the phase error integrator, giving the lock a range of about 1.5% either side of the
+		 *  measured frame rate.
+		 */
+		#define CAPTURE_LOCK_INTEGRAL_LIMIT  16000
+
+	/* Enums: */
+		/** Enum for the states of the capture engine. */
+		enum Capture_States_t
+		{
+			CAPTURE_STATE_Off       = 0, /**< Not capturing, the ADC and timer 0 are stopped */
+			CAPTURE_STATE_Measuring = 1, /**< Timing the incoming frames to find the frame period */
+			CAPTURE_STATE_Locked    = 2, /**< Converting on timer 0, phase locked to the incoming frames */
+		};
+
+	/* Function Prototypes: */
+		void Capture_Start(void);
+		void Capture_Stop(void);
+		void Capture_Frame(void);
+		void Capture_Task(void);
+
+		#if defined(INCLUDE_FROM_CAPTURE_C)
+			static uint16_t Capture_MeasureTime(void);
+			static void Capture_Lock(const uint16_t Ticks);
+			static void Capture_Track(void);
+			static void Capture_Send(void);
+		#endif
+
+#endif
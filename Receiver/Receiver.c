@@ -0,0 +1,261 @@
+/** \file
+ *
+ *  Main source file for the ATMEGA328 receiver. This receives audio samples from the ATMEGA16U2 over the
+ *  serial link described in LinkProtocol.h, and outputs them as PWM on the timer 1 and timer 2 output compare pins.
+ *
+ *  The upper 8 bits of each left (or mono) sample are output on OC1A (Arduino pin 9). When the link is
+ *  negotiated for 16-bit samples, the lower 8 bits are output on OC1B (Arduino pin 10); summing the two outputs
+ *  through resistors in a 256:1 ratio gives a 16-bit dual PWM output. In stereo, the right samples are output
+ *  the same way on timer 2, on OC2A (Arduino pin 11) and OC2B (Arduino pin 3).
+ *
+ *  When the link is negotiated with \ref LINK_FORMAT_CAPTURE, the microphone input on A0 is captured as well,
+ *  and one sample is sent back for each frame received; see Capture.c. A handshake for a link rate probe instead
+ *  switches to the given rate and echoes every character received, until the break that ends the probe.
+ */
+
+#include "Receiver.h"
+
+/** Current state of the link, a value from \ref Receiver_States_t. */
+static uint8_t ReceiverState;
+
+/** Mask of \c LINK_FORMAT_* flags the link is currently negotiated for. */
+static uint8_t LinkFormat;
+
+/** Number of bytes in each sample frame of the current link format. */
+static uint8_t FrameBytes;
+
+/** Bytes of the sample frame currently being received. */
+static uint8_t FrameData[RECEIVER_MAX_FRAME_BYTES];
+
+/** Index of the next byte of the sample frame, or \ref RECEIVER_FRAME_UNALIGNED when waiting for a frame start. */
+static uint8_t FrameIndex;
+
+/** Last bytes received in the base mode, matched against the handshake sequence. */
+static uint8_t HandshakeWindow[4];
+
+/** Main program entry point. This routine polls the USART and processes each byte received from the link. */
+int main(void)
+{
+	SetupHardware();
+
+	/* Tell the ATMEGA16U2 we have just come out of reset, so it negotiates the link again */
+	while (!(UCSR0A & (1 << UDRE0)));
+	UDR0 = LINK_HELLO;
+
+	for (;;)
+	{
+		Capture_Task();
+
+		uint8_t Status = UCSR0A;
+
+		if (!(Status & (1 << RXC0)))
+		  continue;
+
+		/* The ninth bit must be read before the data register, as reading UDR0 advances the receive FIFO */
+		bool    FrameStart = (UCSR0B & (1 << RXB80));
+		uint8_t Data       = UDR0;
+
+		if (Status & (1 << FE0))
+		{
+			/* A framing error with a zero data byte is a break, asking us to return to the base mode */
+			if (!(Data))
+			  Receiver_EnterBaseMode();
+
+			continue;
+		}
+
+		if (ReceiverState == RECEIVER_STATE_Base)
+		  Receiver_ProcessBaseByte(Data);
+		else if (ReceiverState == RECEIVER_STATE_Probing)
+		  Receiver_EchoProbeByte(Data, FrameStart);
+		else
+		  Receiver_ProcessFrameByte(Data, FrameStart);
+	}
+}
+
+/** Configures the PWM timers and the USART. */
+void SetupHardware(void)
+{
+	/* Timers 1 and 2 in 8-bit fast PWM mode at Fcpu/256 = 62.5KHz, on both output compare channels */
+	DDRB   |= ((1 << PB1) | (1 << PB2) | (1 << PB3));
+	DDRD   |= (1 << PD3);
+	TCCR1A  = ((1 << COM1A1) | (1 << COM1B1) | (1 << WGM10));
+	TCCR1B  = ((1 << WGM12) | (1 << CS10));
+	TCCR2A  = ((1 << COM2A1) | (1 << COM2B1) | (1 << WGM21) | (1 << WGM20));
+	TCCR2B  = (1 << CS20);
+
+	Receiver_EnterBaseMode();
+}
+
+/** Returns the link to the base mode, muting the output until the next sample arrives. */
+void Receiver_EnterBaseMode(void)
+{
+	Capture_Stop();
+
+	UCSR0B = 0;
+
+	UBRR0  = LINK_UBRR_2X(LINK_BASE_BAUD);
+	UCSR0A = (1 << U2X0);
+	UCSR0C = ((1 << UCSZ01) | (1 << UCSZ00));
+	UCSR0B = ((1 << RXEN0) | (1 << TXEN0));
+
+	ReceiverState = RECEIVER_STATE_Base;
+	LinkFormat    = 0;
+	FrameBytes    = 1;
+
+	for (uint8_t i = 0; i < sizeof(HandshakeWindow); i++)
+	  HandshakeWindow[i] = 0;
+
+	Receiver_Mute();
+}
+
+/** Processes a byte received in the base mode. Each byte is output as an 8-bit sample, so that transmitters
+ *  which never negotiate still work, while the last four bytes are checked for a handshake.
+ *
+ *  \param[in] Data  Byte received from the link.
+ */
+void Receiver_ProcessBaseByte(const uint8_t Data)
+{
+	HandshakeWindow[0] = HandshakeWindow[1];
+	HandshakeWindow[1] = HandshakeWindow[2];
+	HandshakeWindow[2] = HandshakeWindow[3];
+	HandshakeWindow[3] = Data;
+
+	uint8_t Config = HandshakeWindow[2];
+
+	if ((HandshakeWindow[0] != LINK_SYNC1) || (HandshakeWindow[1] != LINK_SYNC2) || (HandshakeWindow[3] != (uint8_t)(~Config)))
+	{
+		/* Hold the output while what has arrived so far could still be the start of a handshake */
+		bool PartialHandshake = ((HandshakeWindow[3] == LINK_SYNC1) ||
+		                         ((HandshakeWindow[2] == LINK_SYNC1) && (HandshakeWindow[3] == LINK_SYNC2)) ||
+		                         ((HandshakeWindow[1] == LINK_SYNC1) && (HandshakeWindow[2] == LINK_SYNC2)));
+
+		if (!(PartialHandshake))
+		  OCR1A = Data;
+
+		return;
+	}
+
+	uint8_t Baud   = LINK_CONFIG_BAUD(Config);
+	uint8_t Format = LINK_CONFIG_FORMAT(Config);
+
+	Receiver_Mute();
+
+	/* Captured samples are sent back as 9-bit characters, so capture needs a format with multi-byte frames */
+	bool CaptureUnframed = ((Format & LINK_FORMAT_CAPTURE) && !(Format & (LINK_FORMAT_16BIT | LINK_FORMAT_STEREO)));
+
+	/* A probe replaces the format flags, and is echoed in 9-bit characters */
+	bool Probe = (Format == LINK_CONFIG_PROBE);
+
+	if ((Baud > LINK_BAUD_2M) || (!(Probe) && (Format & ~LINK_FORMAT_MASK)) || CaptureUnframed)
+	{
+		while (!(UCSR0A & (1 << UDRE0)));
+		UDR0 = LINK_NAK;
+		return;
+	}
+
+	/* Acknowledge the handshake, and wait until the reply has fully left the USART before switching modes */
+	UCSR0A |= (1 << TXC0);
+	while (!(UCSR0A & (1 << UDRE0)));
+	UDR0 = LINK_ACK;
+	while (!(UCSR0A & (1 << UDRE0)));
+	UDR0 = Config;
+	while (!(UCSR0A & (1 << TXC0)));
+
+	LinkFormat = Format;
+	FrameBytes = (Format & LINK_FORMAT_16BIT) ? 2 : 1;
+
+	if (Format & LINK_FORMAT_STEREO)
+	  FrameBytes *= 2;
+	FrameIndex = RECEIVER_FRAME_UNALIGNED;
+
+	UCSR0B = 0;
+	UBRR0  = LINK_UBRR_2X(Baud);
+	UCSR0B = ((1 << RXEN0) | (1 << TXEN0) | (((FrameBytes > 1) || Probe) ? (1 << UCSZ02) : 0));
+
+	ReceiverState = (Probe ? RECEIVER_STATE_Probing : RECEIVER_STATE_Streaming);
+
+	if (Format & LINK_FORMAT_CAPTURE)
+	  Capture_Start();
+}
+
+/** Processes a byte received in a negotiated mode, collecting the bytes of each sample frame and outputting
+ *  the frame once it is complete.
+ *
+ *  \param[in] Data        Byte received from the link.
+ *  \param[in] FrameStart  Boolean \c true if the byte was marked as the first byte of a frame.
+ */
+void Receiver_ProcessFrameByte(const uint8_t Data,
+                               const bool FrameStart)
+{
+	if (FrameBytes == 1)
+	{
+		OCR1A = Data;
+		return;
+	}
+
+	/* Resynchronise on every frame start, discarding any partial frame left over from a dropped byte */
+	if (FrameStart)
+	  FrameIndex = 0;
+	else if (FrameIndex == RECEIVER_FRAME_UNALIGNED)
+	  return;
+
+	FrameData[FrameIndex++] = Data;
+
+	if (FrameIndex == FrameBytes)
+	{
+		Receiver_OutputFrame();
+		FrameIndex = RECEIVER_FRAME_UNALIGNED;
+	}
+}
+
+/** Echoes a character of a link rate probe's test pattern back to the ATMEGA16U2, ninth bit included, which
+ *  checks it against what it sent. The output stays muted until the break that ends the probe.
+ *
+ *  \param[in] Data      Byte received from the link.
+ *  \param[in] NinthBit  Ninth bit of the character received.
+ */
+void Receiver_EchoProbeByte(const uint8_t Data,
+                            const bool NinthBit)
+{
+	while (!(UCSR0A & (1 << UDRE0)));
+
+	if (NinthBit)
+	  UCSR0B |= (1 << TXB80);
+	else
+	  UCSR0B &= ~(1 << TXB80);
+
+	UDR0 = Data;
+}
+
+/** Outputs a complete sample frame to the PWM channels, and answers it with a captured sample when capturing. */
+void Receiver_OutputFrame(void)
+{
+	if (LinkFormat & LINK_FORMAT_16BIT)
+	{
+		OCR1A = FrameData[0];
+		OCR1B = FrameData[1];
+
+		if (LinkFormat & LINK_FORMAT_STEREO)
+		{
+			OCR2A = FrameData[2];
+			OCR2B = FrameData[3];
+		}
+	}
+	else
+	{
+		OCR1A = FrameData[0];
+		OCR2A = FrameData[1];
+	}
+
+	Capture_Frame();
+}
+
+/** Sets the PWM outputs to the midscale level of an offset-binary sample. */
+void Receiver_Mute(void)
+{
+	OCR1A = 0x80;
+	OCR1B = 0x00;
+	OCR2A = 0x80;
+	OCR2B = 0x00;
+}
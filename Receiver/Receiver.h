@@ -0,0 +1,44 @@
+/** \file
+ *
+ *  Header file for Receiver.c.
+ */
+
+#ifndef _RECEIVER_H_
+#define _RECEIVER_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Capture.h"
+		#include "../LinkProtocol.h"
+
+	/* Macros: */
+		/** Largest number of bytes in a single sample frame on the link. */
+		#define RECEIVER_MAX_FRAME_BYTES  4
+
+		/** Value of the frame index while the receiver is waiting for the first byte of a frame. */
+		#define RECEIVER_FRAME_UNALIGNED  0xFF
+
+	/* Enums: */
+		/** Enum for the states of the receiver's link state machine. */
+		enum Receiver_States_t
+		{
+			RECEIVER_STATE_Base      = 0, /**< Running at the base rate, where every byte is a sample or part of a handshake */
+			RECEIVER_STATE_Streaming = 1, /**< Running in a negotiated mode */
+			RECEIVER_STATE_Probing   = 2, /**< Echoing the test pattern of a link rate probe */
+		};
+
+	/* Function Prototypes: */
+		void SetupHardware(void);
+		void Receiver_EnterBaseMode(void);
+		void Receiver_ProcessBaseByte(const uint8_t Data);
+		void Receiver_ProcessFrameByte(const uint8_t Data,
+		                               const bool FrameStart);
+		void Receiver_OutputFrame(void);
+		void Receiver_EchoProbeByte(const uint8_t Data,
+		                            const bool NinthBit);
+		void Receiver_Mute(void);
+
+#endif
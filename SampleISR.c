@@ -0,0 +1,60 @@
+/** \file
+ *
+ *  Sample clock ISR, sending each frame from the sample ring over the link to the ATMEGA328, or to the R-2R
+ *  ladder on the port pins in AUDIO_OUT_PORTC mode. When the build
+ *  defines \c SAMPLE_ISR_ASM, the vector itself is the hand-written routine in SampleISR.S, and the routine
+ *  below only runs for the samples the assembly version defers to it.
+ */
+
+#define  INCLUDE_FROM_SAMPLEISR_C
+#include "SampleISR.h"
+
+/** ISR to handle sending the sample over USART to the atmega328, or to the ladder DAC in AUDIO_OUT_PORTC mode */
+#if defined(SAMPLE_ISR_ASM)
+ISR(SAMPLE_ISR_SLOW_PATH_vect, ISR_BLOCK)
+#else
+ISR(TIMER0_COMPA_vect, ISR_BLOCK)
+#endif
+{
+	#if defined(SAMPLE_CLOCK_SOF_SYNC)
+	/* Set the length of the sample period that has just started, before anything else can delay it */
+	Clock_Tick();
+	#endif
+
+	if (!(SampleRing_IsPrimed()))
+	{
+		Emission_Restart();
+		SampleISR_SendConcealFrame();
+		return;
+	}
+
+	uint8_t FrameEntries = AudioArena.SampleRing.FrameEntries;
+
+	/* On an underrun, hold off playback until the ring has filled back up to the configured depth, fading the
+	 * last frame played to midscale in the meantime */
+	if (SampleRing_Count() < FrameEntries)
+	{
+		SampleRing_SetPrimed(false);
+		Trace_Record(TRACE_EVENT_Underrun, 0);
+		Emission_Restart();
+		Conceal_Start(FrameEntries);
+		SampleISR_SendConcealFrame();
+		return;
+	}
+
+	int16_t LeftSample_16Bit  = SampleRing_Pop();
+	int16_t RightSample_16Bit = (FrameEntries == 2) ? SampleRing_Pop() : LeftSample_16Bit;
+
+	/* Fade back in from the concealment, if playback has only just resumed */
+	Conceal_Crossfade(&LeftSample_16Bit, &RightSample_16Bit);
+
+	#if defined(AUDIO_OUT_PORTC)
+	/* Drive the sample straight onto the ladder; the ring always holds mono frames in this mode */
+	Emission_Record();
+	PortDAC_Output(LeftSample_16Bit);
+	#else
+	/* Send the frame to the atmega328, in the format the link was negotiated for */
+	Emission_Record();
+	Link_SendFrame(LeftSample_16Bit, RightSample_16Bit);
+	#endif
+}
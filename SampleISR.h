@@ -0,0 +1,79 @@
+/** \file
+ *
+ *  Header file for SampleISR.c.
+ */
+
+#ifndef _SAMPLE_ISR_H_
+#define _SAMPLE_ISR_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+		#include "SampleRing.h"
+
+		#if !defined(__ASSEMBLER__)
+			#include <avr/interrupt.h>
+
+			#include "Clock.h"
+			#include "Conceal.h"
+			#include "Emission.h"
+			#include "Link.h"
+			#include "PortDAC.h"
+			#include "Trace.h"
+		#endif
+
+	/* Preprocessor Checks: */
+		#if defined(SAMPLE_ISR_ASM) && defined(AUDIO_OUT_PORTC)
+			#error The hand-written sample ISR only supports output over the serial link.
+		#elif defined(SAMPLE_ISR_ASM) && defined(SAMPLE_CLOCK_SOF_SYNC)
+			#error The hand-written sample ISR does not support the fractional sample period of SAMPLE_CLOCK_SOF_SYNC.
+		#endif
+
+	/* Macros: */
+		#if defined(SAMPLE_ISR_ASM) || defined(__DOXYGEN__)
+			/** Symbol of the C sample ISR when the hand-written vector in SampleISR.S is in use. The assembly
+			 *  vector jumps here for every sample it cannot send itself; the \c __vector prefix keeps the
+			 *  compiler from warning about a misspelled signal handler.
+			 */
+			#define SAMPLE_ISR_SLOW_PATH_vect    __vector_SampleISR_SlowPath
+		#endif
+
+	#if !defined(__ASSEMBLER__)
+		/* Inline Functions: */
+			#if defined(INCLUDE_FROM_SAMPLEISR_C)
+				/** Sends a silent frame while there is nothing to play, if the receiver is capturing the microphone.
+				 *  The receiver sends back a captured sample for each frame it receives, so the frames must keep
+				 *  coming at the sample rate whether or not the speaker stream is playing.
+				 */
+				static inline void SampleISR_SendIdleFrame(void)
+				{
+					#if !defined(AUDIO_OUT_PORTC)
+					if (Link_Format & LINK_FORMAT_CAPTURE)
+					  Link_SendFrame(0, 0);
+					#endif
+				}
+
+				/** Sends the next frame of the underrun concealment's fade to midscale while the ring refills, or an
+				 *  idle frame once the fade is over.
+				 */
+				static inline void SampleISR_SendConcealFrame(void)
+				{
+					int16_t LeftSample_16Bit;
+					int16_t RightSample_16Bit;
+
+					if (!(Conceal_Fade(&LeftSample_16Bit, &RightSample_16Bit)))
+					{
+						SampleISR_SendIdleFrame();
+						return;
+					}
+
+					#if defined(AUDIO_OUT_PORTC)
+					PortDAC_Output(LeftSample_16Bit);
+					#else
+					Link_SendFrame(LeftSample_16Bit, RightSample_16Bit);
+					#endif
+				}
+			#endif
+	#endif
+
+#endif
@@ -0,0 +1,5 @@
+# Flags for building the ArduinoAudio sources with the hand-written sample ISR in SampleISR.S, shared by every
+# makefile that builds them. Registers r2 to r5 are reserved in every compilation unit for the ISR's state, and
+# Tools/ramreport.py --fixed-registers fails the build if any code linked in from outside (avr-libc and libgcc
+# routines are not built with these flags) touches them anywhere but in the interrupt vectors.
+SAMPLE_ISR_ASM_FLAGS = -DSAMPLE_ISR_ASM -ffixed-r2 -ffixed-r3 -ffixed-r4 -ffixed-r5
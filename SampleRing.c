@@ -0,0 +1,28 @@
+/** \file
+ *
+ *  Ring buffer of samples between the main loop, which fills it from the streaming endpoint, and the sample
+ *  ISR, which drains it at the sample rate. Each sample frame takes one entry in mono and two entries (left
+ *  then right) in stereo. The head index is only written by the main loop and the tail index only by the ISR,
+ *  so neither side needs to disable interrupts to access the ring. The ring itself lives in the audio arena.
+ */
+
+#include "SampleRing.h"
+
+/** Empties the ring, and sets the frame layout for the samples that follow. This must only be called from the
+ *  main loop; playback is held off until the ring is primed again.
+ *
+ *  \param[in] FrameEntries  Number of ring entries in each sample frame.
+ *  \param[in] ByteFrames    Boolean \c true if the link carries each frame as a single byte.
+ */
+void SampleRing_Reset(const uint8_t FrameEntries,
+                      const bool ByteFrames)
+{
+	SampleRing_SetPrimed(false);
+	SampleRing_SetTail(AudioArena.SampleRing.Head);
+	AudioArena.SampleRing.FrameEntries = FrameEntries;
+
+	if (ByteFrames)
+	  SAMPLE_FLAGS |=  (1 << SAMPLE_FLAG_BYTE_FRAMES);
+	else
+	  SAMPLE_FLAGS &= ~(1 << SAMPLE_FLAG_BYTE_FRAMES);
+}
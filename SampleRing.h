@@ -0,0 +1,145 @@
+/** \file
+ *
+ *  Header file for SampleRing.c.
+ */
+
+#ifndef _SAMPLE_RING_H_
+#define _SAMPLE_RING_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+		#if !defined(__ASSEMBLER__)
+			#include <stdbool.h>
+			#include <stdint.h>
+		#endif
+
+		#include "Arena.h"
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if ((SAMPLE_RING_SIZE & (SAMPLE_RING_SIZE - 1)) || (SAMPLE_RING_SIZE > 128))
+			#error SAMPLE_RING_SIZE must be a power of two no larger than 128.
+		#endif
+
+	/* Macros: */
+		/** Mask applied to the free running ring indexes to find the entry they refer to. */
+		#define SAMPLE_RING_MASK          (SAMPLE_RING_SIZE - 1)
+
+		/** General purpose I/O register holding the sample path flags, so that the sample ISR can test them
+		 *  with single bit instructions. This must not be shared with \c DEVICE_STATE_AS_GPIOR in LUFAConfig.h.
+		 */
+		#define SAMPLE_FLAGS              GPIOR0
+
+		/** Bit of \ref SAMPLE_FLAGS set once the ring has filled to the configured depth, and playback may proceed.
+		 *  Cleared by the sample ISR on an underrun, so that the ring fills up again before playback resumes.
+		 */
+		#define SAMPLE_FLAG_PRIMED        0
+
+		/** Bit of \ref SAMPLE_FLAGS set while the link carries single byte (8-bit mono) frames, the only format the
+		 *  hand-written sample ISR handles without falling back to the C implementation.
+		 */
+		#define SAMPLE_FLAG_BYTE_FRAMES   1
+
+	#if !defined(__ASSEMBLER__)
+		/* External Variables: */
+			#if defined(SAMPLE_ISR_ASM)
+				/* The tail index lives in a register reserved with -ffixed-r3 in every compilation unit, so the
+				 * hand-written sample ISR in SampleISR.S never has to load or store it */
+				register uint8_t SampleRing_TailReg asm("r3");
+			#endif
+
+		/* Inline Functions: */
+			/** Retrieves the free running index of the next entry the sample ISR will read.
+			 *
+			 *  \return Ring tail index.
+			 */
+			static inline uint8_t SampleRing_GetTail(void)
+			{
+				#if defined(SAMPLE_ISR_ASM)
+				uint8_t Tail;
+
+				/* Read through volatile assembly, as the compiler may otherwise reuse a stale copy of the register */
+				__asm__ __volatile__ ("mov %0, r3" : "=r" (Tail));
+				return Tail;
+				#else
+				return AudioArena.SampleRing.Tail;
+				#endif
+			}
+
+			/** Sets the free running index of the next entry the sample ISR will read.
+			 *
+			 *  \param[in] Tail  New ring tail index.
+			 */
+			static inline void SampleRing_SetTail(const uint8_t Tail)
+			{
+				#if defined(SAMPLE_ISR_ASM)
+				__asm__ __volatile__ ("mov r3, %0" : : "r" (Tail));
+				#else
+				AudioArena.SampleRing.Tail = Tail;
+				#endif
+			}
+
+			/** Retrieves the number of entries currently held in the ring.
+			 *
+			 *  \return Number of ring entries waiting to be played.
+			 */
+			static inline uint8_t SampleRing_Count(void)
+			{
+				return (uint8_t)(AudioArena.SampleRing.Head - SampleRing_GetTail());
+			}
+
+			/** Determines if the ring has been filled to the configured depth, and playback may proceed.
+			 *
+			 *  \return Boolean \c true if the ring is primed, \c false otherwise
+			 */
+			static inline bool SampleRing_IsPrimed(void)
+			{
+				return (SAMPLE_FLAGS & (1 << SAMPLE_FLAG_PRIMED));
+			}
+
+			/** Sets or clears the primed state of the ring.
+			 *
+			 *  \param[in] Primed  Boolean \c true if playback may proceed, \c false to hold it off.
+			 */
+			static inline void SampleRing_SetPrimed(const bool Primed)
+			{
+				if (Primed)
+				  SAMPLE_FLAGS |=  (1 << SAMPLE_FLAG_PRIMED);
+				else
+				  SAMPLE_FLAGS &= ~(1 << SAMPLE_FLAG_PRIMED);
+			}
+
+			/** Adds a sample to the ring. This must only be called from the main loop, and only when the ring has
+			 *  room for the sample.
+			 *
+			 *  \param[in] Sample  Signed 16-bit sample to add.
+			 */
+			static inline void SampleRing_Push(const int16_t Sample)
+			{
+				uint8_t Head = AudioArena.SampleRing.Head;
+
+				AudioArena.SampleRing.Data[Head & SAMPLE_RING_MASK] = Sample;
+				AudioArena.SampleRing.Head = (Head + 1);
+			}
+
+			/** Removes the oldest sample from the ring. This must only be called from the sample ISR, and only when
+			 *  the ring is not empty.
+			 *
+			 *  \return Signed 16-bit sample removed from the ring.
+			 */
+			static inline int16_t SampleRing_Pop(void)
+			{
+				uint8_t Tail = SampleRing_GetTail();
+				int16_t Sample = AudioArena.SampleRing.Data[Tail & SAMPLE_RING_MASK];
+
+				SampleRing_SetTail(Tail + 1);
+				return Sample;
+			}
+
+		/* Function Prototypes: */
+			void SampleRing_Reset(const uint8_t FrameEntries,
+			                      const bool ByteFrames);
+	#endif
+
+#endif
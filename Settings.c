@@ -0,0 +1,110 @@
+/** \file
+ *
+ *  Runtime settings of the audio pipeline and the serial link. Settings are changed through vendor control
+ *  requests into a pending copy, which takes effect at the next stream start, so that a running stream is never
+ *  reconfigured underneath the host. The pending copy is saved to EEPROM from the main loop while no stream is
+ *  open, a byte at a time as the EEPROM becomes ready, as each byte written takes about 3.4ms.
+ */
+
+#include "Settings.h"
+
+/** Settings currently in effect. */
+AppSettings_t Settings_Active;
+
+/** Settings to put into effect at the next stream start. */
+AppSettings_t Settings_Pending;
+
+/** Layout version of the settings stored in EEPROM, used to ignore settings written by other firmware. */
+static uint8_t       EEMEM Settings_EEPROMVersion;
+
+/** Settings stored in EEPROM, restored at power on. */
+static AppSettings_t EEMEM Settings_EEPROM;
+
+/** Indicates if the pending settings are still to be saved to EEPROM, and the offset of the next byte to save. */
+static bool    Settings_SavePending;
+static uint8_t Settings_SaveOffset;
+
+/** Loads the settings stored in EEPROM, or the compile time defaults if none are stored. */
+void Settings_Init(void)
+{
+	eeprom_read_block(&Settings_Pending, &Settings_EEPROM, sizeof(AppSettings_t));
+
+	if ((eeprom_read_byte(&Settings_EEPROMVersion) != SETTINGS_VERSION) || !(Settings_Validate(&Settings_Pending)))
+	  Settings_LoadDefaults(&Settings_Pending);
+
+	Settings_Active = Settings_Pending;
+}
+
+/** Fills the given settings structure with the compile time defaults from AppConfig.h.
+ *
+ *  \param[out] Settings  Settings structure to fill.
+ */
+void Settings_LoadDefaults(AppSettings_t* const Settings)
+{
+	Settings->LinkBaud   = LINK_BAUD;
+	Settings->LinkFormat = SETTINGS_DEFAULT_FORMAT;
+	Settings->RingDepth  = SAMPLE_RING_DEPTH;
+
+	/* The compiled in chain may not fit a stereo frame at the highest rate, which the default must still pass */
+	Settings->DspStages  = Dsp_FitStages(DSP_STAGES, ((SETTINGS_DEFAULT_FORMAT & LINK_FORMAT_STEREO) ? 2 : 1));
+}
+
+/** Checks that the given settings are within the limits of this firmware.
+ *
+ *  \param[in] Settings  Settings structure to check.
+ *
+ *  \return Boolean \c true if the settings can be applied, \c false otherwise
+ */
+bool Settings_Validate(const AppSettings_t* const Settings)
+{
+	/* Capture is requested by the firmware itself while the microphone stream is open, never by the settings */
+	if ((Settings->LinkBaud > LINK_BAUD_2M) || (Settings->LinkFormat & ~(LINK_FORMAT_MASK & ~LINK_FORMAT_CAPTURE)))
+	  return false;
+
+	/* Stereo frames take two ring entries, so the ring holds half as many of them */
+	uint8_t Entries  = (Settings->LinkFormat & LINK_FORMAT_STEREO) ? 2 : 1;
+	uint8_t MaxDepth = (SAMPLE_RING_SIZE / Entries);
+
+	/* A depth of zero selects the adaptive controller */
+	if (Settings->RingDepth > MaxDepth)
+	  return false;
+
+	/* Refuse processing stages which are not compiled in, or which do not fit the cycle budget at the current
+	 * sample rate */
+	return (!(Settings->DspStages & ~DSP_STAGES) && Dsp_IsWithinBudget(Settings->DspStages, Entries));
+}
+
+/** Marks the pending settings to be saved to EEPROM by \ref Settings_Task(). A save already in progress starts
+ *  over, so that the settings stored are always the latest.
+ */
+void Settings_Save(void)
+{
+	Settings_SavePending = true;
+	Settings_SaveOffset  = 0;
+}
+
+/** Saves the pending settings to EEPROM, one byte each time the EEPROM is ready for it, so that this never waits
+ *  on a write. Only bytes which have changed are written. This must be called from the main loop.
+ */
+void Settings_Task(void)
+{
+	if (!(Settings_SavePending) || !(eeprom_is_ready()))
+	  return;
+
+	if (Settings_SaveOffset < sizeof(AppSettings_t))
+	{
+		eeprom_update_byte(&((uint8_t*)&Settings_EEPROM)[Settings_SaveOffset],
+		                   ((const uint8_t*)&Settings_Pending)[Settings_SaveOffset]);
+		Settings_SaveOffset++;
+		return;
+	}
+
+	eeprom_update_byte(&Settings_EEPROMVersion, SETTINGS_VERSION);
+	Settings_SavePending = false;
+}
+
+/** Puts the pending settings into effect. */
+void Settings_Apply(void)
+{
+	Settings_Active = Settings_Pending;
+}
@@ -0,0 +1,40 @@
+/** \file
+ *
+ *  Header file for Settings.c.
+ */
+
+#ifndef _SETTINGS_H_
+#define _SETTINGS_H_
+
+	/* Includes: */
+		#include <avr/eeprom.h>
+		#include <stdbool.h>
+
+		#include <LUFA/Common/Common.h>
+
+		#include "Dsp.h"
+		#include "LinkProtocol.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		#if defined(AUDIO_OUT_STEREO)
+			/** Link format used when no valid settings are stored in EEPROM. */
+			#define SETTINGS_DEFAULT_FORMAT   (LINK_FORMAT | LINK_FORMAT_STEREO)
+		#else
+			#define SETTINGS_DEFAULT_FORMAT   (LINK_FORMAT & ~LINK_FORMAT_STEREO)
+		#endif
+
+	/* External Variables: */
+		extern AppSettings_t Settings_Active;
+		extern AppSettings_t Settings_Pending;
+
+	/* Function Prototypes: */
+		void Settings_Init(void);
+		void Settings_LoadDefaults(AppSettings_t* const Settings) ATTR_NON_NULL_PTR_ARG(1);
+		bool Settings_Validate(const AppSettings_t* const Settings) ATTR_NON_NULL_PTR_ARG(1);
+		void Settings_Save(void);
+		void Settings_Task(void);
+		void Settings_Apply(void);
+
+#endif
@@ -0,0 +1,962 @@
+/** \file
+ *
+ *  Co-simulation of the whole audio path under simavr, with no hardware: the ArduinoAudio firmware and the
+ *  receiver firmware run side by side, their USARTs joined by a model of the serial link, while the harness
+ *  acts as the USB host on one end and records the receiver's PWM outputs on the other.
+ *
+ *  simavr does not model the ATMEGA16U2, so the ArduinoAudio firmware is built for the AT90USB162, which has the
+ *  same core, USB controller, USART1 and timers. The harness enumerates it through simavr's USB ioctls, sets the
+ *  sample rate and opens the speaker stream like a host audio driver, then sends one isochronous packet every
+ *  millisecond of device time: a lead-in of silence while the link is negotiated and the ring primes, then a
+ *  sine tone.
+ *
+ *  The link is modelled bit by bit. Each character sent by one USART is laid out on the wire at the sender's
+ *  baud rate, delayed by the link latency, has each bit flipped at the given bit error rate, and is sampled at
+ *  the middle of each bit cell at the receiving USART's own baud rate, which gives the corrupted data, ninth bit
+ *  and framing errors a real USART would see when the two clocks are apart. The receiver's clock can be set off
+ *  the device's to model a baud mismatch. A break, which the device sends by driving its TX pin low with the
+ *  USART disabled, reaches the receiver as a framing error with a zero data byte.
+ *
+ *  The four PWM outputs of the receiver are demodulated by integrating each pin's high time over every sample
+ *  period of the stream, and combined into the 16-bit offset binary samples the two timers carry. The output from
+ *  the tone's arrival onwards is written to a stereo WAV file, for Tools/enob to measure the end to end fidelity;
+ *  the latency from the tone leaving the host to it reaching the output, the link's error counts and the
+ *  device's own buffer counters are printed.
+ *
+ *  Usage:
+ *    cosim [-r rate] [-t tone] [-a amplitude] [-n seconds] [-l latency] [-c ppm] [-e ber] [-p loss] [-s seed]
+ *          [-o output.wav] <device.elf> <receiver.elf>
+ *
+ *  -r sets the sample rate of the speaker stream in Hz, -t and -a the frequency in Hz and the amplitude, relative
+ *  to full scale, of the tone, and -n its length in seconds. -l delays each character on the link by the given
+ *  number of microseconds in each direction, -c runs the receiver's clock the given number of ppm fast (or slow,
+ *  if negative), -e flips each bit on the link with the given probability, and -p drops the given percentage of
+ *  the host's packets.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/avr_usb.h>
+
+#include "../../LinkProtocol.h"
+#include "../../VendorProtocol.h"
+
+/** Microcontrollers the two firmwares are simulated on. */
+#define DEVICE_MCU              "at90usb162"
+#define RECEIVER_MCU            "atmega328p"
+
+/** Nominal clock frequency of both microcontrollers, in Hz. */
+#define SIM_FREQUENCY           16000000UL
+
+/** Data space addresses of the USART registers of each side, USART1 of the AT90USB162 and USART0 of the
+ *  ATMEGA328P, and the bits of them the link model reads and writes.
+ */
+#define DEVICE_UCSRA            0xC8
+#define DEVICE_UCSRB            0xC9
+#define DEVICE_UBRRL            0xCC
+#define DEVICE_UBRRH            0xCD
+#define RECEIVER_UCSRA          0xC0
+#define RECEIVER_UCSRB          0xC1
+#define RECEIVER_UBRRL          0xC4
+#define RECEIVER_UBRRH          0xC5
+#define USART_FE                4
+#define USART_U2X               1
+#define USART_RXEN              4
+#define USART_TXEN              3
+#define USART_UCSZ2             2
+#define USART_RXB8              1
+#define USART_TXB8              0
+
+/** Pin of the device's USART TX line on port D, which it drives by hand to send a break. */
+#define DEVICE_TX_PIN           3
+
+/** Number of characters each direction of the link model can hold in flight. */
+#define LINK_QUEUE_SIZE         256
+
+/** Endpoint and interface of the speaker stream, as given in Descriptors.h, and the size of the control endpoint. */
+#define SPEAKER_EPADDR          0x03
+#define SPEAKER_INTERFACE       1
+#define CONTROL_EPSIZE          8
+
+/** Time in seconds the harness waits for the device to answer each stage of a control transfer, and the time in
+ *  microseconds it runs the simulation for between retries.
+ */
+#define USB_TIMEOUT_S           0.1
+#define USB_RETRY_US            20
+
+/** Length in milliseconds of the silence sent before the tone while the link negotiates and the ring primes, and
+ *  of the silence after it while the ring drains.
+ */
+#define LEAD_IN_MS              300
+#define TAIL_MS                 100
+
+/** One character on the link, from the moment it starts arriving at the receiving USART until its stop bit. */
+typedef struct
+{
+	double   Start; /**< Time the start bit reaches the receiving USART. */
+	double   End; /**< Time the receiving USART samples the stop bit. */
+	uint16_t Character; /**< Character as sent, with its ninth bit. */
+	uint16_t Received; /**< Character as sampled by the receiving USART, with its ninth bit. */
+	bool     FrameError; /**< Set when the stop bit was sampled low. */
+	bool     Raised; /**< Set once the character has been handed to the receiving USART. */
+	bool     Break; /**< Set when the character is a break. */
+	uint8_t  Bits; /**< Number of bits sent, start and stop bits included. */
+	uint16_t Flips; /**< Mask of the bits flipped on the wire, start bit first. */
+	double   BaudRate; /**< Baud rate of the sending USART. */
+} LinkCharacter_t;
+
+/** Register addresses of a USART. */
+typedef struct
+{
+	uint16_t UCSRA;
+	uint16_t UCSRB;
+	uint16_t UBRRL;
+	uint16_t UBRRH;
+} USARTRegisters_t;
+
+/** One direction of the serial link. */
+typedef struct
+{
+	const char*      Name;
+	avr_t**          From;
+	avr_t**          To;
+	USARTRegisters_t FromUSART;
+	USARTRegisters_t ToUSART;
+	avr_irq_t*       Input; /**< Receive IRQ of the receiving USART. */
+	double           WireFree; /**< Time the wire is free for the next character. */
+	double           BreakStart; /**< Time a break started, or a negative value when none is being sent. */
+
+	LinkCharacter_t  Queue[LINK_QUEUE_SIZE];
+	unsigned         Head;
+	unsigned         Count;
+
+	unsigned long    Characters; /**< Characters sent. */
+	unsigned long    Corrupted; /**< Characters received with different data, or a framing error. */
+	unsigned long    Breaks; /**< Breaks sent. */
+	unsigned long    Overflows; /**< Characters lost because the queue was full. */
+} LinkDirection_t;
+
+/** State of one PWM output pin of the receiver. */
+typedef struct
+{
+	uint8_t  Level; /**< Current level of the pin. */
+	uint64_t LastEdge; /**< Cycle the pin last changed level, or the last sample was taken. */
+	uint64_t HighCycles; /**< Cycles the pin has been high since the last sample. */
+} PwmPin_t;
+
+static avr_t* Device;
+static avr_t* Receiver;
+
+/** Link model parameters. */
+static double LinkLatency;
+static double BitErrorRate;
+
+static LinkDirection_t Downstream =
+	{
+		.Name      = "device -> receiver",
+		.From      = &Device,
+		.To        = &Receiver,
+		.FromUSART = {DEVICE_UCSRA, DEVICE_UCSRB, DEVICE_UBRRL, DEVICE_UBRRH},
+		.ToUSART   = {RECEIVER_UCSRA, RECEIVER_UCSRB, RECEIVER_UBRRL, RECEIVER_UBRRH},
+		.BreakStart = -1,
+	};
+
+static LinkDirection_t Upstream =
+	{
+		.Name      = "receiver -> device",
+		.From      = &Receiver,
+		.To        = &Device,
+		.FromUSART = {RECEIVER_UCSRA, RECEIVER_UCSRB, RECEIVER_UBRRL, RECEIVER_UBRRH},
+		.ToUSART   = {DEVICE_UCSRA, DEVICE_UCSRB, DEVICE_UBRRL, DEVICE_UBRRH},
+		.BreakStart = -1,
+	};
+
+/** PWM output pins of the receiver: OC1A (PB1), OC1B (PB2), OC2A (PB3) and OC2B (PD3). */
+static PwmPin_t PwmPins[4];
+
+/** Output samples recorded so far, interleaved left and right, and the time of the next one. */
+static int16_t* Output;
+static size_t   OutputFrames;
+static size_t   OutputCapacity;
+static double   OutputPeriod;
+static double   NextOutputTime;
+static uint64_t LastOutputCycle;
+
+/** Level the tone is detected at on both ends, and the times it was sent and first played. */
+static int16_t ToneThreshold;
+static double  ToneSentTime    = -1;
+static double  TonePlayedTime  = -1;
+static size_t  TonePlayedFrame;
+
+/** Set once the device has attached to the bus. */
+static bool Attached;
+
+/** Returns the simulated time of a microcontroller, in seconds. */
+static double MCU_Time(const avr_t* AVR)
+{
+	return ((double)AVR->cycle / AVR->frequency);
+}
+
+/** Returns the baud rate a USART is set to, from its clock and its baud rate registers. */
+static double USART_BaudRate(const avr_t* AVR,
+                             const USARTRegisters_t* USART)
+{
+	uint16_t UBRR    = (((AVR->data[USART->UBRRH] & 0x0F) << 8) | AVR->data[USART->UBRRL]);
+	unsigned Divider = ((AVR->data[USART->UCSRA] & (1 << USART_U2X)) ? 8 : 16);
+
+	return ((double)AVR->frequency / (Divider * (UBRR + 1)));
+}
+
+/** Returns the number of data bits of a USART's characters. */
+static uint8_t USART_DataBits(const avr_t* AVR,
+                              const USARTRegisters_t* USART)
+{
+	return ((AVR->data[USART->UCSRB] & (1 << USART_UCSZ2)) ? 9 : 8);
+}
+
+/** Returns the level of a character's wire bit at a time after its start bit began, as sent at its own baud rate.
+ *
+ *  \param[in] Character  Character on the wire.
+ *  \param[in] Offset     Time after the start of the start bit, in seconds.
+ */
+static bool Link_WireLevel(const LinkCharacter_t* Character,
+                           const double Offset)
+{
+	int  Bit = (int)floor(Offset * Character->BaudRate);
+	bool Level;
+
+	if (Character->Break)
+	  return false;
+
+	/* Start bit low, then the data bits LSB first, then the stop bit and the idle line high */
+	if (Bit <= 0)
+	  Level = false;
+	else if (Bit < (Character->Bits - 1))
+	  Level = ((Character->Character >> (Bit - 1)) & 1);
+	else
+	  Level = true;
+
+	if ((Bit >= 0) && (Bit < Character->Bits) && (Character->Flips & (1 << Bit)))
+	  Level = !(Level);
+
+	return Level;
+}
+
+/** Queues a character, or a break, on one direction of the link, laying it out on the wire after the last one.
+ *
+ *  \param[in] Direction  Direction of the link the character is sent on.
+ *  \param[in] Sent       Time the character was sent, or the break started.
+ *  \param[in] Character  Character sent, with its ninth bit.
+ *  \param[in] Duration   Length of a break in seconds, or zero for a character.
+ */
+static void Link_Queue(LinkDirection_t* Direction,
+                       const double Sent,
+                       const uint16_t Character,
+                       const double Duration)
+{
+	const avr_t*     From   = *(Direction->From);
+	LinkCharacter_t* Queued = &Direction->Queue[(Direction->Head + Direction->Count) % LINK_QUEUE_SIZE];
+
+	if (Direction->Count == LINK_QUEUE_SIZE)
+	{
+		Direction->Overflows++;
+		return;
+	}
+
+	memset(Queued, 0, sizeof(LinkCharacter_t));
+	Queued->Character = Character;
+	Queued->Break     = (Duration > 0);
+	Queued->BaudRate  = USART_BaudRate(From, &Direction->FromUSART);
+	Queued->Bits      = (USART_DataBits(From, &Direction->FromUSART) + 2);
+
+	double WireStart  = ((Sent > Direction->WireFree) ? Sent : Direction->WireFree);
+	double WireLength = (Queued->Break ? Duration : (Queued->Bits / Queued->BaudRate));
+
+	Direction->WireFree = (WireStart + WireLength);
+	Queued->Start       = (WireStart + LinkLatency);
+
+	for (uint8_t Bit = 0; Bit < Queued->Bits; Bit++)
+	{
+		if (drand48() < BitErrorRate)
+		  Queued->Flips |= (1 << Bit);
+	}
+
+	if (Queued->Break)
+	  Direction->Breaks++;
+	else
+	  Direction->Characters++;
+
+	Direction->Count++;
+}
+
+/** Samples a character at the receiving USART's own baud rate, as it starts to arrive.
+ *
+ *  \param[in]     Direction  Direction of the link the character was sent on.
+ *  \param[in,out] Character  Character to sample.
+ */
+static void Link_Sample(LinkDirection_t* Direction,
+                        LinkCharacter_t* Character)
+{
+	const avr_t* To       = *(Direction->To);
+	double       BaudRate = USART_BaudRate(To, &Direction->ToUSART);
+	uint8_t      DataBits = USART_DataBits(To, &Direction->ToUSART);
+	uint16_t     Received = 0;
+
+	/* The receiver samples the middle of each of its own bit cells, from the falling edge of the start bit */
+	for (uint8_t Bit = 0; Bit < DataBits; Bit++)
+	{
+		if (Link_WireLevel(Character, ((Bit + 1.5) / BaudRate)))
+		  Received |= (1 << Bit);
+	}
+
+	Character->Received   = Received;
+	Character->FrameError = !(Link_WireLevel(Character, ((DataBits + 1.5) / BaudRate)));
+	Character->End        = (Character->Start + ((DataBits + 1.5) / BaudRate));
+
+	if (Character->Break)
+	  return;
+
+	uint16_t Mask = ((1 << (Character->Bits - 2)) - 1);
+
+	if (Character->FrameError || ((Received & Mask) != (Character->Character & Mask)))
+	  Direction->Corrupted++;
+}
+
+/** Hands the characters due by the receiving microcontroller's current time to its USART. Each character's data is
+ *  raised as it starts to arrive, so that the USART's own receive timing ends with the stop bit, and its ninth
+ *  bit and framing error are set once the stop bit has been sampled.
+ *
+ *  \param[in] Direction  Direction of the link to deliver characters from.
+ */
+static void Link_Deliver(LinkDirection_t* Direction)
+{
+	avr_t* To  = *(Direction->To);
+	double Now = MCU_Time(To);
+
+	while (Direction->Count)
+	{
+		LinkCharacter_t* Character = &Direction->Queue[Direction->Head];
+
+		if (Now < Character->Start)
+		  return;
+
+		if (!(Character->Raised))
+		{
+			Link_Sample(Direction, Character);
+			avr_raise_irq(Direction->Input, (Character->Received & 0xFF));
+			Character->Raised = true;
+		}
+
+		if (Now < Character->End)
+		  return;
+
+		uint8_t* UCSRA = &To->data[Direction->ToUSART.UCSRA];
+		uint8_t* UCSRB = &To->data[Direction->ToUSART.UCSRB];
+
+		*UCSRA = (Character->FrameError ? (*UCSRA | (1 << USART_FE)) : (*UCSRA & ~(1 << USART_FE)));
+		*UCSRB = ((Character->Received & 0x100) ? (*UCSRB | (1 << USART_RXB8)) : (*UCSRB & ~(1 << USART_RXB8)));
+
+		Direction->Head = ((Direction->Head + 1) % LINK_QUEUE_SIZE);
+		Direction->Count--;
+	}
+}
+
+/** USART output hook, queueing each character written to either USART on its direction of the link, with the
+ *  ninth bit the firmware set up beforehand.
+ */
+static void Link_CharacterSent(struct avr_irq_t* IRQ,
+                               uint32_t Value,
+                               void* Param)
+{
+	LinkDirection_t* Direction = Param;
+	const avr_t*     From      = *(Direction->From);
+	uint16_t         Character = (Value & 0xFF);
+
+	if (From->data[Direction->FromUSART.UCSRB] & (1 << USART_TXB8))
+	  Character |= 0x100;
+
+	Link_Queue(Direction, MCU_Time(From), Character, 0);
+}
+
+/** Pin hook of the device's TX line, which turns the line being held low with the USART disabled into a break. */
+static void Link_TxPinChanged(struct avr_irq_t* IRQ,
+                              uint32_t Value,
+                              void* Param)
+{
+	LinkDirection_t* Direction = Param;
+
+	if (Device->data[DEVICE_UCSRB] & (1 << USART_TXEN))
+	  return;
+
+	if (!(Value & 1))
+	{
+		Direction->BreakStart = MCU_Time(Device);
+	}
+	else if (Direction->BreakStart >= 0)
+	{
+		Link_Queue(Direction, Direction->BreakStart, 0, (MCU_Time(Device) - Direction->BreakStart));
+		Direction->BreakStart = -1;
+	}
+}
+
+/** Pin hook of the receiver's PWM outputs, adding up the time each spends high. */
+static void Capture_PinChanged(struct avr_irq_t* IRQ,
+                               uint32_t Value,
+                               void* Param)
+{
+	PwmPin_t* Pin = Param;
+	uint64_t  Now = Receiver->cycle;
+
+	if (Pin->Level)
+	  Pin->HighCycles += (Now - Pin->LastEdge);
+
+	Pin->Level    = (Value & 1);
+	Pin->LastEdge = Now;
+}
+
+/** Returns the average compare value of a PWM pin since the last sample, from its duty cycle, and restarts its
+ *  average. An 8-bit fast PWM output with a compare value of N is high for N + 1 cycles of every 256.
+ */
+static double Capture_PinValue(PwmPin_t* Pin,
+                               const uint64_t Now,
+                               const uint64_t Interval)
+{
+	uint64_t High = (Pin->HighCycles + (Pin->Level ? (Now - Pin->LastEdge) : 0));
+
+	Pin->HighCycles = 0;
+	Pin->LastEdge   = Now;
+
+	return ((((double)High * 256) / Interval) - 1);
+}
+
+/** Converts the averaged compare values of a timer's two PWM pins into a signed 16-bit sample. */
+static int16_t Capture_Combine(const double Upper,
+                               const double Lower)
+{
+	double Sample = round(((Upper * 256) + Lower) - 32768);
+
+	return (int16_t)((Sample > INT16_MAX) ? INT16_MAX : ((Sample < INT16_MIN) ? INT16_MIN : Sample));
+}
+
+/** Records one output frame from the PWM pins, once per sample period of the receiver's time. */
+static void Capture_Task(void)
+{
+	if (MCU_Time(Receiver) < NextOutputTime)
+	  return;
+
+	uint64_t Now      = Receiver->cycle;
+	uint64_t Interval = (Now - LastOutputCycle);
+	double   Values[4];
+
+	for (uint8_t Pin = 0; Pin < 4; Pin++)
+	  Values[Pin] = Capture_PinValue(&PwmPins[Pin], Now, Interval);
+
+	LastOutputCycle  = Now;
+	NextOutputTime  += OutputPeriod;
+
+	if (OutputFrames == OutputCapacity)
+	{
+		OutputCapacity = (OutputCapacity ? (OutputCapacity * 2) : 65536);
+		Output         = realloc(Output, (OutputCapacity * 2 * sizeof(int16_t)));
+	}
+
+	int16_t Left  = Capture_Combine(Values[0], Values[1]);
+	int16_t Right = Capture_Combine(Values[2], Values[3]);
+
+	if ((TonePlayedTime < 0) && (ToneSentTime >= 0) && (abs(Left) >= ToneThreshold))
+	{
+		TonePlayedTime  = MCU_Time(Receiver);
+		TonePlayedFrame = OutputFrames;
+	}
+
+	Output[(OutputFrames * 2)]     = Left;
+	Output[(OutputFrames * 2) + 1] = Right;
+	OutputFrames++;
+}
+
+/** Runs the simulation of both microcontrollers in step until both have reached the given time, running whichever
+ *  is behind one instruction at a time, and handing each the link characters due to it first.
+ *
+ *  \param[in] Time  Time to run the simulation to, in seconds.
+ */
+static void CoSim_RunUntil(const double Time)
+{
+	for (;;)
+	{
+		double  DeviceTime   = MCU_Time(Device);
+		double  ReceiverTime = MCU_Time(Receiver);
+		avr_t*  AVR;
+
+		if ((DeviceTime >= Time) && (ReceiverTime >= Time))
+		  return;
+
+		if (DeviceTime <= ReceiverTime)
+		{
+			Link_Deliver(&Upstream);
+			AVR = Device;
+		}
+		else
+		{
+			Link_Deliver(&Downstream);
+			AVR = Receiver;
+		}
+
+		int State = avr_run(AVR);
+
+		if ((State == cpu_Done) || (State == cpu_Crashed))
+		{
+			fprintf(stderr, "%s firmware stopped at %.6f s\n", ((AVR == Device) ? "device" : "receiver"), MCU_Time(AVR));
+			exit(EXIT_FAILURE);
+		}
+
+		if (AVR == Receiver)
+		  Capture_Task();
+	}
+}
+
+/** Runs the simulation for the given time from now. */
+static void CoSim_Run(const double Seconds)
+{
+	CoSim_RunUntil(MCU_Time(Device) + Seconds);
+}
+
+/** USB attach hook, raised once the firmware has attached the device to the bus. */
+static void USB_AttachChanged(struct avr_irq_t* IRQ,
+                              uint32_t Value,
+                              void* Param)
+{
+	Attached = Value;
+}
+
+/** Performs one stage of a USB transaction on the device, retrying while the device NAKs it.
+ *
+ *  \param[in]     Ioctl   simavr USB ioctl of the stage: setup, write (host to device) or read (device to host).
+ *  \param[in]     Pipe    Endpoint number.
+ *  \param[in,out] Buffer  Data of the packet.
+ *  \param[in]     Size    Size of the packet, or of the buffer for a read.
+ *
+ *  \return Number of bytes transferred, or -1 if the device stalled or did not answer
+ */
+static int USB_Transfer(const uint32_t Ioctl,
+                        const uint8_t Pipe,
+                        uint8_t* const Buffer,
+                        const uint32_t Size)
+{
+	double Timeout = (MCU_Time(Device) + USB_TIMEOUT_S);
+
+	for (;;)
+	{
+		struct avr_io_usb Packet = {.pipe = Pipe, .sz = Size, .buf = Buffer};
+		int               Result = avr_ioctl(Device, Ioctl, &Packet);
+
+		if (Result != AVR_IOCTL_USB_NAK)
+		  return ((Result == AVR_IOCTL_USB_OK) ? (int)Packet.sz : -1);
+
+		if (MCU_Time(Device) > Timeout)
+		  return -1;
+
+		CoSim_Run(USB_RETRY_US * 1e-6);
+	}
+}
+
+/** Performs a control transfer on the device.
+ *
+ *  \param[in]     RequestType  bmRequestType of the request.
+ *  \param[in]     Request      bRequest of the request.
+ *  \param[in]     Value        wValue of the request.
+ *  \param[in]     Index        wIndex of the request.
+ *  \param[in,out] Data         Data stage buffer.
+ *  \param[in]     Length       Length of the data stage.
+ *
+ *  \return Number of bytes transferred in the data stage, or -1 on failure
+ */
+static int USB_Control(const uint8_t RequestType,
+                       const uint8_t Request,
+                       const uint16_t Value,
+                       const uint16_t Index,
+                       uint8_t* const Data,
+                       const uint16_t Length)
+{
+	uint8_t Setup[8] = {RequestType, Request, (Value & 0xFF), (Value >> 8), (Index & 0xFF), (Index >> 8),
+	                    (Length & 0xFF), (Length >> 8)};
+	uint8_t Packet[CONTROL_EPSIZE];
+	int     Transferred = 0;
+
+	if (USB_Transfer(AVR_IOCTL_USB_SETUP, 0, Setup, sizeof(Setup)) < 0)
+	  return -1;
+
+	if (RequestType & 0x80)
+	{
+		while (Transferred < Length)
+		{
+			int Received = USB_Transfer(AVR_IOCTL_USB_READ, 0, Packet, CONTROL_EPSIZE);
+
+			if (Received < 0)
+			  return -1;
+
+			if (Received > (Length - Transferred))
+			  Received = (Length - Transferred);
+
+			memcpy(&Data[Transferred], Packet, Received);
+			Transferred += Received;
+
+			if (Received < CONTROL_EPSIZE)
+			  break;
+		}
+
+		return ((USB_Transfer(AVR_IOCTL_USB_WRITE, 0, Packet, 0) < 0) ? -1 : Transferred);
+	}
+
+	while (Transferred < Length)
+	{
+		int Chunk = (((Length - Transferred) > CONTROL_EPSIZE) ? CONTROL_EPSIZE : (Length - Transferred));
+
+		if (USB_Transfer(AVR_IOCTL_USB_WRITE, 0, &Data[Transferred], Chunk) < 0)
+		  return -1;
+
+		Transferred += Chunk;
+	}
+
+	return ((USB_Transfer(AVR_IOCTL_USB_READ, 0, Packet, 0) < 0) ? -1 : Transferred);
+}
+
+/** Reads the configuration descriptor of the device, and finds the number of channels of the 16-bit alternate
+ *  setting of the speaker stream in its Audio 1.0 format type descriptor.
+ *
+ *  \return Number of channels of the speaker stream, or zero if it was not found
+ */
+static uint8_t USB_GetSpeakerChannels(void)
+{
+	uint8_t Descriptor[512];
+	int     Length;
+	uint8_t Interface   = 0xFF;
+	uint8_t Alternate   = 0xFF;
+	uint8_t Channels    = 0;
+
+	if (USB_Control(0x80, 0x06, 0x0200, 0, Descriptor, 9) < 9)
+	  return 0;
+
+	Length = (Descriptor[2] | (Descriptor[3] << 8));
+
+	if ((Length > (int)sizeof(Descriptor)) || (USB_Control(0x80, 0x06, 0x0200, 0, Descriptor, Length) < Length))
+	  return 0;
+
+	for (int Offset = 0; (Offset + 2) <= Length; Offset += Descriptor[Offset])
+	{
+		const uint8_t* Header = &Descriptor[Offset];
+
+		if (!(Header[0]))
+		  break;
+
+		if (Header[1] == 0x04)
+		{
+			Interface = Header[2];
+			Alternate = Header[3];
+		}
+		else if ((Header[1] == 0x24) && (Header[2] == 0x02) && (Interface == SPEAKER_INTERFACE) && (Alternate == 1))
+		{
+			Channels = Header[4];
+		}
+	}
+
+	return Channels;
+}
+
+/** Writes the given frames of the recorded output to a 16-bit stereo WAV file. */
+static int WriteOutput(const char* Name,
+                       const uint32_t SampleRate,
+                       const size_t FirstFrame,
+                       const size_t Frames)
+{
+	FILE*    File  = fopen(Name, "wb");
+	uint32_t Bytes = (Frames * 4);
+	uint8_t  Header[44];
+
+	if (!(File))
+	{
+		perror(Name);
+		return -1;
+	}
+
+	memcpy(&Header[0], "RIFF", 4);
+	uint32_t RIFFLength = (36 + Bytes);
+	memcpy(&Header[4], &RIFFLength, 4);
+	memcpy(&Header[8], "WAVEfmt ", 8);
+
+	uint32_t FormatLength = 16;
+	uint16_t Format       = 1;
+	uint16_t Channels     = 2;
+	uint32_t ByteRate     = (SampleRate * 4);
+	uint16_t BlockAlign   = 4;
+	uint16_t Bits         = 16;
+
+	memcpy(&Header[16], &FormatLength, 4);
+	memcpy(&Header[20], &Format, 2);
+	memcpy(&Header[22], &Channels, 2);
+	memcpy(&Header[24], &SampleRate, 4);
+	memcpy(&Header[28], &ByteRate, 4);
+	memcpy(&Header[32], &BlockAlign, 2);
+	memcpy(&Header[34], &Bits, 2);
+	memcpy(&Header[36], "data", 4);
+	memcpy(&Header[40], &Bytes, 4);
+
+	fwrite(Header, 1, sizeof(Header), File);
+	fwrite(&Output[FirstFrame * 2], 1, Bytes, File);
+	fclose(File);
+
+	return 0;
+}
+
+/** Loads a firmware image onto a new simulated microcontroller. */
+static avr_t* LoadFirmware(const char* Name,
+                           const char* MCU,
+                           const uint32_t Frequency)
+{
+	elf_firmware_t Firmware = {{0}};
+	avr_t*         AVR;
+
+	if (elf_read_firmware(Name, &Firmware) != 0)
+	{
+		fprintf(stderr, "Unable to read %s\n", Name);
+		return NULL;
+	}
+
+	if ((AVR = avr_make_mcu_by_name(MCU)) == NULL)
+	{
+		fprintf(stderr, "simavr does not support the %s\n", MCU);
+		return NULL;
+	}
+
+	avr_init(AVR);
+	avr_load_firmware(AVR, &Firmware);
+	AVR->frequency = Frequency;
+
+	return AVR;
+}
+
+/** Joins one direction of the link between the two USARTs, with the given names of the sending and receiving
+ *  USART, and stops simavr echoing their output to the console.
+ */
+static void ConnectLink(LinkDirection_t* Direction,
+                        const char FromUSART,
+                        const char ToUSART)
+{
+	uint32_t Flags = 0;
+
+	avr_ioctl(*(Direction->From), AVR_IOCTL_UART_GET_FLAGS(FromUSART), &Flags);
+	Flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(*(Direction->From), AVR_IOCTL_UART_SET_FLAGS(FromUSART), &Flags);
+
+	avr_irq_register_notify(avr_io_getirq(*(Direction->From), AVR_IOCTL_UART_GETIRQ(FromUSART), UART_IRQ_OUTPUT),
+	                        Link_CharacterSent, Direction);
+
+	Direction->Input = avr_io_getirq(*(Direction->To), AVR_IOCTL_UART_GETIRQ(ToUSART), UART_IRQ_INPUT);
+}
+
+int main(int argc,
+         char* argv[])
+{
+	uint32_t    SampleRate = 8000;
+	double      Tone       = 1000;
+	double      Amplitude  = 0.5;
+	double      Seconds    = 2;
+	double      ClockPPM   = 0;
+	double      PacketLoss = 0;
+	long        Seed       = 1;
+	const char* OutputName = "cosim.wav";
+	int         Option;
+
+	while ((Option = getopt(argc, argv, "r:t:a:n:l:c:e:p:s:o:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'r': SampleRate   = atoi(optarg);          break;
+			case 't': Tone         = atof(optarg);          break;
+			case 'a': Amplitude    = atof(optarg);          break;
+			case 'n': Seconds      = atof(optarg);          break;
+			case 'l': LinkLatency  = (atof(optarg) * 1e-6); break;
+			case 'c': ClockPPM     = atof(optarg);          break;
+			case 'e': BitErrorRate = atof(optarg);          break;
+			case 'p': PacketLoss   = (atof(optarg) / 100);  break;
+			case 's': Seed         = atol(optarg);          break;
+			case 'o': OutputName   = optarg;                break;
+			default:
+				fprintf(stderr, "Usage: %s [-r rate] [-t tone] [-a amplitude] [-n seconds] [-l latency] [-c ppm] [-e ber] "
+				        "[-p loss] [-s seed] [-o output.wav] <device.elf> <receiver.elf>\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if ((argc - optind) != 2)
+	{
+		fprintf(stderr, "Both a device and a receiver firmware image are needed\n");
+		return EXIT_FAILURE;
+	}
+
+	srand48(Seed);
+
+	if (!(Device = LoadFirmware(argv[optind], DEVICE_MCU, SIM_FREQUENCY)) ||
+	    !(Receiver = LoadFirmware(argv[optind + 1], RECEIVER_MCU, (uint32_t)(SIM_FREQUENCY * (1 + (ClockPPM * 1e-6))))))
+	{
+		return EXIT_FAILURE;
+	}
+
+	ConnectLink(&Downstream, '1', '0');
+	ConnectLink(&Upstream, '0', '1');
+
+	avr_irq_register_notify(avr_io_getirq(Device, AVR_IOCTL_IOPORT_GETIRQ('D'), (IOPORT_IRQ_PIN0 + DEVICE_TX_PIN)),
+	                        Link_TxPinChanged, &Downstream);
+
+	avr_irq_register_notify(avr_io_getirq(Receiver, AVR_IOCTL_IOPORT_GETIRQ('B'), (IOPORT_IRQ_PIN0 + 1)), Capture_PinChanged, &PwmPins[0]);
+	avr_irq_register_notify(avr_io_getirq(Receiver, AVR_IOCTL_IOPORT_GETIRQ('B'), (IOPORT_IRQ_PIN0 + 2)), Capture_PinChanged, &PwmPins[1]);
+	avr_irq_register_notify(avr_io_getirq(Receiver, AVR_IOCTL_IOPORT_GETIRQ('B'), (IOPORT_IRQ_PIN0 + 3)), Capture_PinChanged, &PwmPins[2]);
+	avr_irq_register_notify(avr_io_getirq(Receiver, AVR_IOCTL_IOPORT_GETIRQ('D'), (IOPORT_IRQ_PIN0 + 3)), Capture_PinChanged, &PwmPins[3]);
+
+	avr_irq_register_notify(avr_io_getirq(Device, AVR_IOCTL_USB_GETIRQ(), USB_IRQ_ATTACH), USB_AttachChanged, NULL);
+
+	OutputPeriod   = (1.0 / SampleRate);
+	NextOutputTime = OutputPeriod;
+	ToneThreshold  = (int16_t)((Amplitude * INT16_MAX) / 2);
+
+	/* Power the bus, and reset the device once its firmware has attached to it */
+	avr_ioctl(Device, AVR_IOCTL_USB_VBUS, (void*)1);
+
+	while (!(Attached) && (MCU_Time(Device) < 1))
+	  CoSim_Run(1e-3);
+
+	if (!(Attached))
+	{
+		fprintf(stderr, "The device did not attach to the bus\n");
+		return EXIT_FAILURE;
+	}
+
+	avr_ioctl(Device, AVR_IOCTL_USB_RESET, NULL);
+	CoSim_Run(10e-3);
+
+	uint8_t Channels;
+	uint8_t Frequency[3] = {(SampleRate & 0xFF), ((SampleRate >> 8) & 0xFF), (SampleRate >> 16)};
+
+	if ((USB_Control(0x00, 0x05, 1, 0, NULL, 0) < 0) || !(Channels = USB_GetSpeakerChannels()) ||
+	    (USB_Control(0x00, 0x09, 1, 0, NULL, 0) < 0) ||
+	    (USB_Control(0x22, 0x01, 0x0100, SPEAKER_EPADDR, Frequency, sizeof(Frequency)) < 0) ||
+	    (USB_Control(0x01, 0x0B, 1, SPEAKER_INTERFACE, NULL, 0) < 0))
+	{
+		fprintf(stderr, "The device did not enumerate as an Audio 1.0 device\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("streaming %u channels at %u Hz, %.0f Hz tone at %.2f of full scale for %.1f s\n",
+	       Channels, SampleRate, Tone, Amplitude, Seconds);
+
+	/* Send one isochronous packet every millisecond of device time, as the host controller would */
+	double        Start       = MCU_Time(Device);
+	uint32_t      Packets     = (LEAD_IN_MS + (uint32_t)(Seconds * 1000) + TAIL_MS);
+	double        FramesDue   = 0;
+	uint64_t      FramesSent  = 0;
+	unsigned long Dropped     = 0;
+	unsigned long Refused     = 0;
+
+	for (uint32_t Packet = 0; Packet < Packets; Packet++)
+	{
+		uint8_t Data[1024];
+		uint8_t Frames = 0;
+
+		FramesDue += (SampleRate / 1000.0);
+
+		while ((FramesDue >= 1) && (((Frames + 1) * Channels * 2) <= (int)sizeof(Data)))
+		{
+			double  Time   = ((double)FramesSent / SampleRate);
+			bool    Sound  = ((Packet >= LEAD_IN_MS) && (Packet < (LEAD_IN_MS + (Seconds * 1000))));
+			int16_t Sample = (Sound ? (int16_t)(Amplitude * INT16_MAX * sin(2 * M_PI * Tone * Time)) : 0);
+
+			if ((ToneSentTime < 0) && (abs(Sample) >= ToneThreshold))
+			  ToneSentTime = MCU_Time(Device);
+
+			for (uint8_t Channel = 0; Channel < Channels; Channel++)
+			{
+				Data[(((Frames * Channels) + Channel) * 2)]     = (Sample & 0xFF);
+				Data[(((Frames * Channels) + Channel) * 2) + 1] = (Sample >> 8);
+			}
+
+			Frames++;
+			FramesSent++;
+			FramesDue -= 1;
+		}
+
+		if (drand48() < PacketLoss)
+		{
+			Dropped++;
+		}
+		else
+		{
+			struct avr_io_usb Transfer = {.pipe = (SPEAKER_EPADDR & 0x0F), .sz = (Frames * Channels * 2), .buf = Data};
+
+			/* An isochronous packet the device has no room for is lost, not retried */
+			if (avr_ioctl(Device, AVR_IOCTL_USB_WRITE, &Transfer) != AVR_IOCTL_USB_OK)
+			  Refused++;
+		}
+
+		CoSim_RunUntil(Start + ((Packet + 1) * 1e-3));
+	}
+
+	BufferStatus_t BufferStatus;
+	LinkStatus_t   LinkStatus;
+
+	if ((USB_Control(0xC0, VENDOR_REQ_GetBufferStatus, 0, 0, (uint8_t*)&BufferStatus, sizeof(BufferStatus)) < (int)sizeof(BufferStatus)) ||
+	    (USB_Control(0xC0, VENDOR_REQ_GetLinkStatus, 0, 0, (uint8_t*)&LinkStatus, sizeof(LinkStatus)) < (int)sizeof(LinkStatus)))
+	{
+		fprintf(stderr, "The device did not answer its status requests\n");
+		return EXIT_FAILURE;
+	}
+
+	USB_Control(0x01, 0x0B, 0, SPEAKER_INTERFACE, NULL, 0);
+
+	printf("host: %" PRIu64 " frames in %u packets, %lu dropped by the host, %lu refused by the device\n",
+	       FramesSent, Packets, Dropped, Refused);
+	printf("link: %s at %lu baud, %u-bit %s, probe %u capped at %lu baud\n",
+	       (LinkStatus.Negotiated ? "negotiated" : "not negotiated"), LINK_BAUD_RATE(LinkStatus.LinkBaud),
+	       ((LinkStatus.LinkFormat & LINK_FORMAT_16BIT) ? 16 : 8), ((LinkStatus.LinkFormat & LINK_FORMAT_STEREO) ? "stereo" : "mono"),
+	       LinkStatus.ProbeResult, LINK_BAUD_RATE(LinkStatus.MaxBaud));
+
+	LinkDirection_t* Directions[] = {&Downstream, &Upstream};
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		printf("link %s: %lu characters, %lu corrupted, %lu breaks, %lu lost to the model's queue\n",
+		       Directions[i]->Name, Directions[i]->Characters, Directions[i]->Corrupted, Directions[i]->Breaks,
+		       Directions[i]->Overflows);
+	}
+
+	printf("buffer: depth %u of %u, %u underruns, %u concealed, %u merges\n",
+	       BufferStatus.Depth, BufferStatus.TargetDepth, BufferStatus.Underruns, BufferStatus.Concealments, BufferStatus.Merges);
+
+	if (TonePlayedTime < 0)
+	{
+		fprintf(stderr, "The tone never reached the output\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("latency: %.2f ms from host to output\n", ((TonePlayedTime - ToneSentTime) * 1000));
+
+	/* Only the tone itself is written out, without the silence that follows it, so that a sine fits all of it */
+	size_t ToneFrames = (OutputFrames - TonePlayedFrame);
+
+	if (ToneFrames > (size_t)(Seconds * SampleRate))
+	  ToneFrames = (size_t)(Seconds * SampleRate);
+
+	if (WriteOutput(OutputName, SampleRate, TonePlayedFrame, ToneFrames) < 0)
+	  return EXIT_FAILURE;
+
+	printf("output: %zu frames -> %s\n", ToneFrames, OutputName);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,779 @@
+/** \file
+ *
+ *  Linux emulation of the ArduinoAudio device's USB audio function, for checking how the host's USB audio driver
+ *  (such as ALSA's snd-usb-audio) enumerates and controls the device without an Uno attached. The emulator binds to a UDC through
+ *  Raw Gadget and presents the device, configuration and string descriptors extracted from the firmware image,
+ *  answering the standard requests and the sampling frequency requests itself. Packets received on the speaker
+ *  stream are fed through the host compiled downmix matrix and sample ring into a sample clock thread, which
+ *  stands in for the sample ISR, and the emulator logs once a second:
+ *
+ *    - the number and size range of the packets received, and the longest gap between two of them
+ *    - the range of ring depths, as buffering latency in milliseconds, and any underruns or overruns
+ *
+ *  as well as every alternate setting, sampling frequency and mixer gain change as it happens. The emulator
+ *  must be built with the same AUDIO_IN_CHANNELS as the firmware the descriptors come from.
+ *
+ *  FunctionFS cannot be used for this, as it rejects the class specific interface and endpoint descriptors of
+ *  the audio class. Note that dummy_hcd fails every isochronous transfer, so on a single machine only the
+ *  enumeration and control traffic (descriptor parsing, alternate settings and rate changes) can be observed.
+ *  The packet and latency statistics need a real UDC, such as the dwc2 controller of a Raspberry Pi Zero, and
+ *  have not been run against one, so the streaming side of the emulator is unverified.
+ *
+ *  Usage:
+ *    audiogadget [-d driver] [-u device] [-D depth] [-s] [-o output.raw]
+ *
+ *  The defaults bind to the first dummy_hcd instance; the output file receives the samples as they leave the
+ *  ring, as signed 16-bit little endian mono (or stereo with -s). A depth of 0, the default unless the firmware
+ *  configuration sets a fixed one, runs the firmware's adaptive jitter buffer controller, whose target depth
+ *  is logged along with the other statistics.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <linux/usb/ch9.h>
+#include <linux/usb/raw_gadget.h>
+
+#include "Arena.h"
+#include "Dsp.h"
+#include "Jitter.h"
+#include "Mix.h"
+#include "SampleRing.h"
+#include "VendorProtocol.h"
+#include "Descriptors.gen.h"
+
+/** Largest number of endpoints in the configuration descriptor the emulator keeps track of. */
+#define MAX_ENDPOINTS           8
+
+/** Largest number of interfaces in the configuration descriptor the emulator keeps track of. */
+#define MAX_INTERFACES          4
+
+/** Largest control or endpoint transfer handled by the emulator. */
+#define MAX_TRANSFER            1024
+
+/** Audio class request codes and the sampling frequency control selector, from the USB Audio 1.0 spec. */
+#define AUDIO_REQ_SET_CUR       0x01
+#define AUDIO_REQ_GET_CUR       0x81
+#define AUDIO_REQ_GET_MIN       0x82
+#define AUDIO_REQ_GET_MAX       0x83
+#define AUDIO_REQ_GET_RES       0x84
+#define AUDIO_SAMPLING_FREQ     0x01
+
+/** Audio class specific descriptor type, and the subtypes of the mixer unit and of the format type descriptor,
+ *  which share a value in the control and streaming interfaces respectively.
+ */
+#define AUDIO_DTYPE_CS_INTERFACE  0x24
+#define AUDIO_DSUBTYPE_MIXER      0x04
+#define AUDIO_DSUBTYPE_FORMAT     0x02
+
+/** Interface protocol of the Audio Class 2.0 interfaces. */
+#define AUDIO_PROTOCOL_IP_V2      0x20
+
+/** Type define for a USB transfer buffer, as passed to the Raw Gadget I/O ioctls. */
+typedef struct
+{
+	struct usb_raw_ep_io IO;
+	uint8_t              Data[MAX_TRANSFER];
+} Transfer_t;
+
+/** Type define for a non-control endpoint of the configuration, and the interface setting it belongs to. */
+typedef struct
+{
+	uint8_t                        Interface;
+	uint8_t                        AltSetting;
+	uint8_t                        Channels; /**< Channels of the stream in the endpoint's interface setting */
+	uint8_t                        SubFrameSize; /**< Bytes in each sample of the stream */
+	struct usb_endpoint_descriptor Descriptor;
+	int                            Handle; /**< Raw Gadget endpoint handle while enabled, or -1 */
+} Endpoint_t;
+
+/** Host side storage for the GPIOR0 register used by the sample ring flags. */
+volatile uint8_t Host_GPIOR0;
+
+static int             RawGadget;
+static Endpoint_t      Endpoints[MAX_ENDPOINTS];
+static uint8_t         EndpointCount;
+static uint8_t         CurrentAltSetting[MAX_INTERFACES];
+
+static pthread_mutex_t PipelineLock   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  StreamChanged  = PTHREAD_COND_INITIALIZER;
+static uint32_t        SampleRate;
+static uint8_t         RingDepth      = SAMPLE_RING_DEPTH;
+static uint8_t         FrameEntries   = 1;
+static uint8_t         MixerUnitID;
+static FILE*           OutputFile;
+
+/** Statistics gathered over each one second reporting period, protected by \ref PipelineLock. */
+static struct
+{
+	uint32_t Packets;
+	uint32_t MinPacket;
+	uint32_t MaxPacket;
+	uint64_t MaxGapUs;
+	uint8_t  MinDepth;
+	uint8_t  MaxDepth;
+	uint32_t Underruns;
+	uint32_t Overruns;
+} Stats;
+
+static uint64_t MonotonicUs(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return ((uint64_t)Now.tv_sec * 1000000) + (Now.tv_nsec / 1000);
+}
+
+static void ResetStats(void)
+{
+	memset(&Stats, 0, sizeof(Stats));
+	Stats.MinPacket = UINT32_MAX;
+	Stats.MinDepth  = UINT8_MAX;
+}
+
+/** Finds the endpoints of each interface setting and the format of its stream, the mixer unit, and the first
+ *  sample rate of the speaker stream, in the configuration descriptor extracted from the firmware.
+ */
+static void ParseConfiguration(void)
+{
+	uint8_t Interface    = 0;
+	uint8_t AltSetting   = 0;
+	uint8_t Channels     = 0;
+	uint8_t SubFrameSize = 0;
+
+	for (size_t Offset = 0; Offset < sizeof(ConfigurationDescriptor); Offset += ConfigurationDescriptor[Offset])
+	{
+		const uint8_t* Descriptor = &ConfigurationDescriptor[Offset];
+
+		if (!(Descriptor[0]))
+		  break;
+
+		switch (Descriptor[1])
+		{
+			case USB_DT_INTERFACE:
+				Interface  = Descriptor[2];
+				AltSetting = Descriptor[3];
+
+				/* The emulator speaks the Audio Class 1.0 requests only */
+				if (Descriptor[7] == AUDIO_PROTOCOL_IP_V2)
+				{
+					fprintf(stderr, "firmware uses Audio Class 2.0, rebuild it without AUDIO_CLASS_2\n");
+					exit(1);
+				}
+
+				break;
+			case USB_DT_ENDPOINT:
+				if (EndpointCount < MAX_ENDPOINTS)
+				{
+					Endpoint_t* Endpoint = &Endpoints[EndpointCount++];
+
+					Endpoint->Interface  = Interface;
+					Endpoint->AltSetting   = AltSetting;
+					Endpoint->Channels     = Channels;
+					Endpoint->SubFrameSize = SubFrameSize;
+					Endpoint->Handle       = -1;
+					memcpy(&Endpoint->Descriptor, Descriptor, MIN(Descriptor[0], sizeof(Endpoint->Descriptor)));
+				}
+
+				break;
+			case AUDIO_DTYPE_CS_INTERFACE:
+				if ((Interface == 0) && (Descriptor[2] == AUDIO_DSUBTYPE_MIXER))
+				{
+					MixerUnitID = Descriptor[3];
+				}
+				else if ((Interface != 0) && (Descriptor[2] == AUDIO_DSUBTYPE_FORMAT))
+				{
+					Channels     = Descriptor[4];
+					SubFrameSize = Descriptor[5];
+
+					if (SampleRate)
+					  break;
+
+					/* The first format type descriptor is the speaker stream's, starting at its first rate */
+					if (Channels != AUDIO_IN_CHANNELS)
+					{
+						fprintf(stderr, "firmware has %u channels, rebuild with AUDIO_IN_CHANNELS=%u\n", Channels, Channels);
+						exit(1);
+					}
+
+					SampleRate = (Descriptor[8] | (Descriptor[9] << 8) | (Descriptor[10] << 16));
+				}
+
+				break;
+		}
+	}
+}
+
+static Endpoint_t* FindStreamEndpoint(const uint8_t Direction)
+{
+	for (uint8_t i = 0; i < EndpointCount; i++)
+	{
+		if (((Endpoints[i].Descriptor.bmAttributes & USB_ENDPOINT_XFERTYPE_MASK) == USB_ENDPOINT_XFER_ISOC) &&
+		    ((Endpoints[i].Descriptor.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == Direction))
+		{
+			return &Endpoints[i];
+		}
+	}
+
+	return NULL;
+}
+
+/** Empties the sample ring for a new stream, as the firmware does when the speaker stream opens. */
+static void ResetPipeline(void)
+{
+	SampleRing_Reset(FrameEntries, (FrameEntries == 1));
+	Mix_SetLayout(FrameEntries);
+	Dsp_Configure(DSP_STAGES, FrameEntries);
+	Jitter_Reset(FrameEntries, RingDepth, SampleRate);
+	ResetStats();
+}
+
+/** Selects an alternate setting of an interface, disabling the endpoints of the previous setting and enabling
+ *  those of the new one.
+ */
+static int SetInterface(const uint8_t Interface,
+                        const uint8_t AltSetting)
+{
+	if (Interface >= MAX_INTERFACES)
+	  return -1;
+
+	pthread_mutex_lock(&PipelineLock);
+
+	for (uint8_t i = 0; i < EndpointCount; i++)
+	{
+		Endpoint_t* Endpoint = &Endpoints[i];
+
+		if ((Endpoint->Interface == Interface) && (Endpoint->Handle >= 0))
+		{
+			ioctl(RawGadget, USB_RAW_IOCTL_EP_DISABLE, Endpoint->Handle);
+			Endpoint->Handle = -1;
+		}
+
+		if ((Endpoint->Interface == Interface) && (Endpoint->AltSetting == AltSetting))
+		{
+			if ((Endpoint->Handle = ioctl(RawGadget, USB_RAW_IOCTL_EP_ENABLE, &Endpoint->Descriptor)) < 0)
+			  perror("USB_RAW_IOCTL_EP_ENABLE");
+		}
+	}
+
+	CurrentAltSetting[Interface] = AltSetting;
+	ResetPipeline();
+
+	pthread_cond_broadcast(&StreamChanged);
+	pthread_mutex_unlock(&PipelineLock);
+
+	printf("interface %u: alternate setting %u\n", Interface, AltSetting);
+	return 0;
+}
+
+/** Waits for a stream endpoint to be enabled by the host selecting one of the alternate settings it appears in.
+ *
+ *  \param[in] Address  Address of the endpoint.
+ *
+ *  \return Endpoint of the selected alternate setting.
+ */
+static Endpoint_t* WaitForEndpoint(const uint8_t Address)
+{
+	Endpoint_t* Enabled = NULL;
+
+	pthread_mutex_lock(&PipelineLock);
+
+	while (!(Enabled))
+	{
+		for (uint8_t i = 0; i < EndpointCount; i++)
+		{
+			if ((Endpoints[i].Descriptor.bEndpointAddress == Address) && (Endpoints[i].Handle >= 0))
+			  Enabled = &Endpoints[i];
+		}
+
+		if (!(Enabled))
+		  pthread_cond_wait(&StreamChanged, &PipelineLock);
+	}
+
+	pthread_mutex_unlock(&PipelineLock);
+	return Enabled;
+}
+
+/** Receives the speaker stream, and moves each packet through the downmix matrix into the sample ring as the
+ *  firmware's Audio_Task() does.
+ */
+static void* SpeakerThread(void* Argument)
+{
+	uint8_t    Address    = ((Endpoint_t*)Argument)->Descriptor.bEndpointAddress;
+	uint64_t   LastPacket = 0;
+	Transfer_t Packet;
+
+	for (;;)
+	{
+		Endpoint_t* Endpoint     = WaitForEndpoint(Address);
+		uint8_t     Channels     = Endpoint->Channels;
+		uint8_t     SubFrameSize = Endpoint->SubFrameSize;
+
+		Packet.IO.ep     = Endpoint->Handle;
+		Packet.IO.flags  = 0;
+		Packet.IO.length = sizeof(Packet.Data);
+
+		int Length = ioctl(RawGadget, USB_RAW_IOCTL_EP_READ, &Packet);
+
+		/* Reads fail while the endpoint is being disabled, and on every isochronous transfer under dummy_hcd */
+		if (Length < 0)
+		  continue;
+
+		uint64_t Now = MonotonicUs();
+
+		pthread_mutex_lock(&PipelineLock);
+
+		Jitter_Observe();
+
+		Stats.Packets++;
+		Stats.MinPacket = MIN(Stats.MinPacket, (uint32_t)Length);
+		Stats.MaxPacket = MAX(Stats.MaxPacket, (uint32_t)Length);
+
+		if (LastPacket)
+		  Stats.MaxGapUs = MAX(Stats.MaxGapUs, (Now - LastPacket));
+
+		LastPacket = Now;
+
+		for (int i = 0; (i + (Channels * SubFrameSize)) <= Length; i += (Channels * SubFrameSize))
+		{
+			int16_t Input[AUDIO_IN_CHANNELS];
+			int16_t Output[MIX_OUTPUTS];
+
+			if ((SAMPLE_RING_SIZE - SampleRing_Count()) < FrameEntries)
+			{
+				Stats.Overruns++;
+				continue;
+			}
+
+			if (Endpoint->AltSetting == SPEAKER_ALT_PCM8)
+			{
+				Output[0] = (int16_t)((uint16_t)(Packet.Data[i] ^ 0x80) << 8);
+				Output[1] = Output[0];
+			}
+			else
+			{
+				for (uint8_t Channel = 0; Channel < AUDIO_IN_CHANNELS; Channel++)
+				{
+					const uint8_t* Sample = &Packet.Data[i + (Channel * SubFrameSize)];
+
+					if (SubFrameSize == 1)
+					  Input[Channel] = (int16_t)((uint16_t)(Sample[0] ^ 0x80) << 8);
+					else
+					  Input[Channel] = (int16_t)(Sample[0] | (Sample[1] << 8));
+				}
+
+				Mix_Process(Input, Output);
+				Dsp_Process(Output);
+			}
+
+			if (!(Jitter_Process(Output)))
+			  continue;
+
+			for (uint8_t Entry = 0; Entry < FrameEntries; Entry++)
+			  SampleRing_Push(Output[Entry]);
+		}
+
+		if (!(SampleRing_IsPrimed()) && (SampleRing_Count() >= (Jitter_TargetDepth * FrameEntries)))
+		{
+			SampleRing_SetPrimed(true);
+			Jitter_Started();
+		}
+
+		pthread_mutex_unlock(&PipelineLock);
+	}
+
+	return NULL;
+}
+
+/** Sends silence on the microphone stream while it is open, one packet per 1ms frame. */
+static void* MicThread(void* Argument)
+{
+	uint8_t    Address = ((Endpoint_t*)Argument)->Descriptor.bEndpointAddress;
+	Transfer_t Packet;
+
+	memset(Packet.Data, 0, sizeof(Packet.Data));
+
+	for (;;)
+	{
+		Endpoint_t* Endpoint = WaitForEndpoint(Address);
+
+		Packet.IO.ep     = Endpoint->Handle;
+		Packet.IO.flags  = 0;
+		Packet.IO.length = MIN(((SampleRate / 1000) * sizeof(int16_t)), Endpoint->Descriptor.wMaxPacketSize);
+
+		if (ioctl(RawGadget, USB_RAW_IOCTL_EP_WRITE, &Packet) < 0)
+		  usleep(1000);
+	}
+
+	return NULL;
+}
+
+/** Drains the sample ring at the sample rate, standing in for the firmware's sample ISR, and reports the
+ *  statistics gathered over each second.
+ */
+static void* ClockThread(void* Argument)
+{
+	struct timespec Next;
+	uint32_t        Ticks = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &Next);
+
+	for (;;)
+	{
+		pthread_mutex_lock(&PipelineLock);
+
+		uint32_t Rate  = SampleRate;
+		uint8_t  Depth = (SampleRing_Count() / FrameEntries);
+
+		Stats.MinDepth = MIN(Stats.MinDepth, Depth);
+		Stats.MaxDepth = MAX(Stats.MaxDepth, Depth);
+
+		if (SampleRing_IsPrimed())
+		{
+			if (SampleRing_Count() < FrameEntries)
+			{
+				SampleRing_SetPrimed(false);
+				Stats.Underruns++;
+			}
+			else
+			{
+				int16_t Frame[2];
+
+				for (uint8_t i = 0; i < FrameEntries; i++)
+				  Frame[i] = SampleRing_Pop();
+
+				if (OutputFile)
+				  fwrite(Frame, sizeof(int16_t), FrameEntries, OutputFile);
+			}
+		}
+
+		if (++Ticks >= Rate)
+		{
+			printf("packets=%u size=%u..%u gap<=%.1fms depth=%u..%u (%.1f..%.1fms) target=%u underruns=%u overruns=%u\n",
+			       Stats.Packets, Stats.Packets ? Stats.MinPacket : 0, Stats.MaxPacket, Stats.MaxGapUs / 1000.0,
+			       Stats.MinDepth, Stats.MaxDepth, (Stats.MinDepth * 1000.0) / Rate, (Stats.MaxDepth * 1000.0) / Rate,
+			       Jitter_TargetDepth, Stats.Underruns, Stats.Overruns);
+			fflush(stdout);
+
+			ResetStats();
+			Ticks = 0;
+		}
+
+		pthread_mutex_unlock(&PipelineLock);
+
+		Next.tv_nsec += (1000000000L / Rate);
+		if (Next.tv_nsec >= 1000000000L)
+		{
+			Next.tv_nsec -= 1000000000L;
+			Next.tv_sec++;
+		}
+
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Next, NULL);
+	}
+
+	return NULL;
+}
+
+static int ControlWrite(const void* Data,
+                        const uint16_t Length,
+                        const uint16_t RequestedLength)
+{
+	Transfer_t Transfer;
+
+	Transfer.IO.ep     = 0;
+	Transfer.IO.flags  = 0;
+	Transfer.IO.length = MIN(Length, RequestedLength);
+	memcpy(Transfer.Data, Data, Transfer.IO.length);
+
+	return ioctl(RawGadget, USB_RAW_IOCTL_EP0_WRITE, &Transfer);
+}
+
+static int ControlRead(void* Data,
+                       const uint16_t Length)
+{
+	Transfer_t Transfer;
+
+	Transfer.IO.ep     = 0;
+	Transfer.IO.flags  = 0;
+	Transfer.IO.length = MIN(Length, sizeof(Transfer.Data));
+
+	int Result = ioctl(RawGadget, USB_RAW_IOCTL_EP0_READ, &Transfer);
+
+	if ((Result > 0) && Data)
+	  memcpy(Data, Transfer.Data, Result);
+
+	return Result;
+}
+
+/** Processes a standard control request, as the LUFA device stack would.
+ *
+ *  \return Zero if the request was handled, or -1 if it must be stalled
+ */
+static int ProcessStandardRequest(const struct usb_ctrlrequest* const Request)
+{
+	uint8_t Value = (Request->wValue & 0xFF);
+
+	switch (Request->bRequest)
+	{
+		case USB_REQ_GET_DESCRIPTOR:
+			switch (Request->wValue >> 8)
+			{
+				case USB_DT_DEVICE:
+					return ControlWrite(DeviceDescriptor, sizeof(DeviceDescriptor), Request->wLength);
+				case USB_DT_CONFIG:
+					return ControlWrite(ConfigurationDescriptor, sizeof(ConfigurationDescriptor), Request->wLength);
+				case USB_DT_STRING:
+					if (Value == 0)
+					  return ControlWrite(LanguageString, sizeof(LanguageString), Request->wLength);
+					else if (Value == DeviceDescriptor[14])
+					  return ControlWrite(ManufacturerString, sizeof(ManufacturerString), Request->wLength);
+					else if (Value == DeviceDescriptor[15])
+					  return ControlWrite(ProductString, sizeof(ProductString), Request->wLength);
+
+					return -1;
+			}
+
+			return -1;
+		case USB_REQ_SET_CONFIGURATION:
+			ioctl(RawGadget, USB_RAW_IOCTL_VBUS_DRAW, (ConfigurationDescriptor[8] * 2));
+			ioctl(RawGadget, USB_RAW_IOCTL_CONFIGURE, 0);
+			printf("configuration %u\n", Value);
+			return ControlRead(NULL, 0);
+		case USB_REQ_GET_CONFIGURATION:
+			Value = 1;
+			return ControlWrite(&Value, 1, Request->wLength);
+		case USB_REQ_SET_INTERFACE:
+			if (SetInterface(Request->wIndex, Value) < 0)
+			  return -1;
+
+			return ControlRead(NULL, 0);
+		case USB_REQ_GET_INTERFACE:
+			if (Request->wIndex >= MAX_INTERFACES)
+			  return -1;
+
+			return ControlWrite(&CurrentAltSetting[Request->wIndex], 1, Request->wLength);
+		case USB_REQ_GET_STATUS:
+			return ControlWrite("\0\0", 2, Request->wLength);
+	}
+
+	return -1;
+}
+
+/** Processes an audio class request addressed to a streaming endpoint. Only the sampling frequency control is
+ *  supported, as in CALLBACK_Audio_Device_GetSetEndpointProperty() of the firmware.
+ *
+ *  \return Zero if the request was handled, or -1 if it must be stalled
+ */
+static int ProcessEndpointRequest(const struct usb_ctrlrequest* const Request)
+{
+	uint8_t Data[3];
+
+	if ((Request->wValue >> 8) != AUDIO_SAMPLING_FREQ)
+	  return -1;
+
+	switch (Request->bRequest)
+	{
+		case AUDIO_REQ_SET_CUR:
+			if (ControlRead(Data, sizeof(Data)) != sizeof(Data))
+			  return -1;
+
+			pthread_mutex_lock(&PipelineLock);
+			SampleRate = (Data[0] | (Data[1] << 8) | (Data[2] << 16));
+			Dsp_SetRate(SampleRate);
+			Dsp_Configure(DSP_STAGES, FrameEntries);
+			Jitter_Reset(FrameEntries, RingDepth, SampleRate);
+			pthread_mutex_unlock(&PipelineLock);
+
+			printf("endpoint 0x%02x: sampling frequency %u Hz\n", Request->wIndex, SampleRate);
+			return 0;
+		case AUDIO_REQ_GET_CUR:
+			Data[0] = (SampleRate & 0xFF);
+			Data[1] = ((SampleRate >> 8) & 0xFF);
+			Data[2] = ((SampleRate >> 16) & 0xFF);
+			return ControlWrite(Data, sizeof(Data), Request->wLength);
+	}
+
+	return -1;
+}
+
+/** Processes an audio class request addressed to the mixer unit, whose crosspoint gains are handled by the
+ *  host compiled downmix matrix as in CALLBACK_Audio_Device_GetSetInterfaceProperty() of the firmware.
+ *
+ *  \return Zero if the request was handled, or -1 if it must be stalled
+ */
+static int ProcessMixerRequest(const struct usb_ctrlrequest* const Request)
+{
+	uint8_t InputChannel  = (Request->wValue >> 8);
+	uint8_t OutputChannel = (Request->wValue & 0xFF);
+	uint8_t Data[2];
+	int16_t Value;
+
+	if (!(MixerUnitID) || ((Request->wIndex >> 8) != MixerUnitID) || !(InputChannel) ||
+	    (InputChannel > AUDIO_IN_CHANNELS) || !(OutputChannel) || (OutputChannel > MIX_OUTPUTS))
+	{
+		return -1;
+	}
+
+	switch (Request->bRequest)
+	{
+		case AUDIO_REQ_SET_CUR:
+			if (ControlRead(Data, sizeof(Data)) != sizeof(Data))
+			  return -1;
+
+			pthread_mutex_lock(&PipelineLock);
+			Mix_SetGain((InputChannel - 1), (OutputChannel - 1), (int16_t)(Data[0] | (Data[1] << 8)));
+			Value = Mix_GetGain((InputChannel - 1), (OutputChannel - 1));
+			pthread_mutex_unlock(&PipelineLock);
+
+			printf("mixer %u->%u: %d dB\n", InputChannel, OutputChannel, (Value == MIX_GAIN_SILENT_DB256) ? -128 : (Value / 256));
+			return 0;
+		case AUDIO_REQ_GET_CUR:
+			pthread_mutex_lock(&PipelineLock);
+			Value = Mix_GetGain((InputChannel - 1), (OutputChannel - 1));
+			pthread_mutex_unlock(&PipelineLock);
+			break;
+		case AUDIO_REQ_GET_MIN:
+			Value = (MIX_GAIN_MIN_DB * 256);
+			break;
+		case AUDIO_REQ_GET_MAX:
+			Value = (MIX_GAIN_MAX_DB * 256);
+			break;
+		case AUDIO_REQ_GET_RES:
+			Value = 256;
+			break;
+		default:
+			return -1;
+	}
+
+	Data[0] = (Value & 0xFF);
+	Data[1] = ((uint16_t)Value >> 8);
+	return ControlWrite(Data, sizeof(Data), Request->wLength);
+}
+
+static void ProcessControlRequest(const struct usb_ctrlrequest* const Request)
+{
+	int Result = -1;
+
+	if ((Request->bRequestType & USB_TYPE_MASK) == USB_TYPE_STANDARD)
+	  Result = ProcessStandardRequest(Request);
+	else if (((Request->bRequestType & USB_TYPE_MASK) == USB_TYPE_CLASS) &&
+	         ((Request->bRequestType & USB_RECIP_MASK) == USB_RECIP_ENDPOINT))
+	  Result = ProcessEndpointRequest(Request);
+	else if (((Request->bRequestType & USB_TYPE_MASK) == USB_TYPE_CLASS) &&
+	         ((Request->bRequestType & USB_RECIP_MASK) == USB_RECIP_INTERFACE))
+	  Result = ProcessMixerRequest(Request);
+
+	if (Result < 0)
+	  ioctl(RawGadget, USB_RAW_IOCTL_EP0_STALL, 0);
+}
+
+int main(int argc,
+         char* argv[])
+{
+	struct usb_raw_init Init       = {.speed = USB_SPEED_FULL};
+	const char*         DriverName = "dummy_udc";
+	const char*         DeviceName = "dummy_udc.0";
+	int                 Option;
+
+	while ((Option = getopt(argc, argv, "d:u:D:so:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'd':
+				DriverName = optarg;
+				break;
+			case 'u':
+				DeviceName = optarg;
+				break;
+			case 'D':
+				RingDepth = atoi(optarg);
+				break;
+			case 's':
+				FrameEntries = 2;
+				break;
+			case 'o':
+				if (!(OutputFile = fopen(optarg, "wb")))
+				{
+					perror(optarg);
+					return 1;
+				}
+
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-d driver] [-u device] [-D depth] [-s] [-o output.raw]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((RingDepth * FrameEntries) > SAMPLE_RING_SIZE)
+	{
+		fprintf(stderr, "ring depth must be at most %u frames, or 0 to adapt\n", (SAMPLE_RING_SIZE / FrameEntries));
+		return 1;
+	}
+
+	ParseConfiguration();
+	Mix_Init();
+	Dsp_Init();
+	Dsp_SetRate(SampleRate);
+	ResetPipeline();
+
+	if ((RawGadget = open("/dev/raw-gadget", O_RDWR)) < 0)
+	{
+		perror("/dev/raw-gadget");
+		return 1;
+	}
+
+	strncpy((char*)Init.driver_name, DriverName, sizeof(Init.driver_name) - 1);
+	strncpy((char*)Init.device_name, DeviceName, sizeof(Init.device_name) - 1);
+
+	if ((ioctl(RawGadget, USB_RAW_IOCTL_INIT, &Init) < 0) || (ioctl(RawGadget, USB_RAW_IOCTL_RUN, 0) < 0))
+	{
+		perror("raw gadget");
+		return 1;
+	}
+
+	pthread_t   Thread;
+	Endpoint_t* Endpoint;
+
+	if ((Endpoint = FindStreamEndpoint(USB_DIR_OUT)))
+	  pthread_create(&Thread, NULL, SpeakerThread, Endpoint);
+
+	if ((Endpoint = FindStreamEndpoint(USB_DIR_IN)))
+	  pthread_create(&Thread, NULL, MicThread, Endpoint);
+
+	pthread_create(&Thread, NULL, ClockThread, NULL);
+
+	for (;;)
+	{
+		struct
+		{
+			struct usb_raw_event   Event;
+			struct usb_ctrlrequest Request;
+		} Event;
+
+		Event.Event.type   = 0;
+		Event.Event.length = sizeof(Event.Request);
+
+		if (ioctl(RawGadget, USB_RAW_IOCTL_EVENT_FETCH, &Event) < 0)
+		{
+			perror("USB_RAW_IOCTL_EVENT_FETCH");
+			return 1;
+		}
+
+		if (Event.Event.type == USB_RAW_EVENT_CONNECT)
+		  printf("connected\n");
+		else if (Event.Event.type == USB_RAW_EVENT_CONTROL)
+		  ProcessControlRequest(&Event.Request);
+	}
+}
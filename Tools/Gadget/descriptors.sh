@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# Extracts the USB descriptors from a linked ArduinoAudio firmware image, and writes them to standard output
+# as a C header for the gadget emulator. Taking the bytes from the firmware itself guarantees the emulator
+# presents exactly the descriptor set built from Descriptors.c.
+#
+# Usage: descriptors.sh ArduinoAudio.elf > Descriptors.gen.h
+
+set -e
+
+ELF="$1"
+CROSS="${CROSS:-avr-}"
+FLASH=$(mktemp)
+trap 'rm -f "$FLASH"' EXIT
+
+# Descriptors are in PROGMEM, which the linker places in the .text output section starting at flash address 0
+"${CROSS}objcopy" -O binary -j .text "$ELF" "$FLASH"
+
+echo "/* Generated from $(basename "$ELF") by descriptors.sh, do not edit */"
+echo
+
+for SYMBOL in DeviceDescriptor ConfigurationDescriptor LanguageString ManufacturerString ProductString; do
+	set -- $("${CROSS}nm" -S "$ELF" | awk -v Symbol="$SYMBOL" '$4 == Symbol { print $1, $2 }')
+
+	if [ -z "$1" ]; then
+		echo "descriptors.sh: $SYMBOL not found in $ELF" >&2
+		exit 1
+	fi
+
+	echo "static const uint8_t $SYMBOL[] ="
+	echo "	{"
+	od -An -tx1 -v -j $((0x$1)) -N $((0x$2)) "$FLASH" | sed -e 's/ \([0-9a-f][0-9a-f]\)/0x\1, /g' -e 's/^/		/' -e 's/, *$/,/'
+	echo "	};"
+	echo
+done
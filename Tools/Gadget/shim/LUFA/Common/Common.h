@@ -0,0 +1,13 @@
+/** \file
+ *
+ *  Host build shim for the parts of LUFA/Common/Common.h used by Mix.c.
+ */
+
+#ifndef _HOST_LUFA_COMMON_H_
+#define _HOST_LUFA_COMMON_H_
+
+	/* Macros: */
+		#define MIN(x, y)    (((x) < (y)) ? (x) : (y))
+		#define MAX(x, y)    (((x) > (y)) ? (x) : (y))
+
+#endif
@@ -0,0 +1,19 @@
+/** \file
+ *
+ *  Host build shim for the parts of avr/io.h used by the sample pipeline sources, so that SampleRing.c and
+ *  Arena.c can be compiled into the gadget emulator unchanged.
+ */
+
+#ifndef _HOST_AVR_IO_H_
+#define _HOST_AVR_IO_H_
+
+	/* Includes: */
+		#include <stdint.h>
+
+	/* Macros: */
+		#define GPIOR0    Host_GPIOR0
+
+	/* External Variables: */
+		extern volatile uint8_t Host_GPIOR0;
+
+#endif
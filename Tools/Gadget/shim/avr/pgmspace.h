@@ -0,0 +1,19 @@
+/** \file
+ *
+ *  Host build shim for the parts of avr/pgmspace.h used by Mix.c. The host has a single address space, so
+ *  flash data is read directly.
+ */
+
+#ifndef _HOST_AVR_PGMSPACE_H_
+#define _HOST_AVR_PGMSPACE_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <string.h>
+
+	/* Macros: */
+		#define PROGMEM
+		#define pgm_read_word(Address)        (*(const uint16_t*)(Address))
+		#define memcpy_P(Dest, Source, Size)  memcpy((Dest), (Source), (Size))
+
+#endif
@@ -0,0 +1,32 @@
+/** \file
+ *
+ *  DSP chain benchmark firmware. Runs the compiled in chain over a single mono frame over and over, each with
+ *  interrupts disabled, so that simisr times every frame as if it were an ISR. The input swings between full
+ *  scale positive and negative, so that the DC blocker and the biquads saturate and the limiter stays in its
+ *  attack path, which are the slowest paths through each stage.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "Dsp.h"
+
+int main(void)
+{
+	int16_t Sample = INT16_MAX;
+
+	Dsp_Init();
+
+	GlobalInterruptEnable();
+
+	for (;;)
+	{
+		int16_t Frame = Sample;
+
+		GlobalInterruptDisable();
+		Dsp_Process(&Frame);
+		GlobalInterruptEnable();
+
+		Sample = ~Sample;
+	}
+}
@@ -0,0 +1,52 @@
+/** \file
+ *
+ *  Sample ISR benchmark firmware. Runs the sample path of the ArduinoAudio firmware with nothing but a full
+ *  sample ring behind it, so that simisr can time each sample ISR in isolation. The link stays in the base
+ *  mode (8-bit mono frames), which is the format the hand-written ISR handles itself.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "Link.h"
+#include "SampleISR.h"
+#include "SampleRing.h"
+
+/** Sample rate the benchmark runs the sample clock at. */
+#define BENCH_SAMPLE_RATE    48000
+
+int main(void)
+{
+	int16_t Sample = 0;
+
+	/* Timer 1 times the link's probe, which with no receiver attached gives up and leaves the base mode ready */
+	TCCR1B  = (1 << CS10);
+
+	Link_Init();
+
+	while (!(Link_Ready))
+	  Link_Task();
+
+	SampleRing_Reset(1, true);
+
+	/* Sample reload timer initialization, as in the ArduinoAudio firmware */
+	TIMSK0  = (1 << OCIE0A);
+	OCR0A   = ((F_CPU / 8 / BENCH_SAMPLE_RATE) - 1);
+	TCCR0A  = (1 << WGM01);  // CTC mode
+	TCCR0B  = (1 << CS01);   // Fcpu/8 speed
+
+	GlobalInterruptEnable();
+
+	for (;;)
+	{
+		/* Keep the ring topped up with a ramp, so the ISR never sees an underrun */
+		if (SampleRing_Count() < SAMPLE_RING_SIZE)
+		{
+			SampleRing_Push(Sample);
+			Sample += 0x0101;
+		}
+
+		if (!(SampleRing_IsPrimed()) && (SampleRing_Count() == SAMPLE_RING_SIZE))
+		  SampleRing_SetPrimed(true);
+	}
+}
@@ -0,0 +1,41 @@
+/** \file
+ *
+ *  Level meter benchmark firmware. Meters a stereo frame over and over, as sent to an 8-bit link so that the
+ *  levels both before and after the reduction are measured, the reduction taking its longest shift, each with
+ *  interrupts disabled so that simisr times every frame as if it were an ISR. The input swings between the two rails, so that every sample is counted
+ *  as a clip at both widths and the sum of squares carries on most frames, and the totals are started over
+ *  every few frames outside the timed section so that the peaks are raised again.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include <LUFA/Common/Common.h>
+
+#include "Level.h"
+
+int main(void)
+{
+	LevelReport_t Report;
+	int16_t       Sample = INT16_MAX;
+
+	Level_Init();
+	Level_SetRate(8000);
+	Level_Configure(2, 8);
+
+	GlobalInterruptEnable();
+
+	for (uint8_t Count = 0;; Count++)
+	{
+		int16_t Frame[2] = {Sample, ~Sample};
+
+		GlobalInterruptDisable();
+		Level_Process(Frame);
+		GlobalInterruptEnable();
+
+		if (!(Count & 0x3F))
+		  Level_GetReport(&Report);
+
+		Sample = ~Sample;
+	}
+}
@@ -0,0 +1,59 @@
+/** \file
+ *
+ *  Downmix matrix benchmark firmware. Runs a full packet of the speaker stream through the downmix matrix, the
+ *  DSP chain and into the sample ring over and over, each with interrupts disabled, so that simisr times every packet as if
+ *  it were an ISR. The link layout alternates between mono and stereo from one packet to the next, so both
+ *  show up in the minimum and maximum.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "Budget.h"
+#include "Descriptors.h"
+#include "Dsp.h"
+#include "Mix.h"
+#include "SampleRing.h"
+
+int main(void)
+{
+	/* The downmix and the DSP chain together may take their two shares of each 1ms frame */
+	__asm__ __volatile__ (".global __mix_cycle_budget" "\n\t" ".set __mix_cycle_budget, %c0"
+	                      :
+	                      : "i" (BUDGET_CYCLES_PER_MS(BUDGET_PARTS_MIX + BUDGET_PARTS_DSP)));
+
+	int16_t Input[AUDIO_IN_CHANNELS];
+	int16_t Output[MIX_OUTPUTS];
+	uint8_t Layout = 1;
+
+	Mix_Init();
+	Dsp_Init();
+
+	/* A full scale ramp on every channel, so that every crosspoint multiplies and saturates */
+	for (uint8_t Channel = 0; Channel < AUDIO_IN_CHANNELS; Channel++)
+	  Input[Channel] = (INT16_MAX - (Channel * 0x1111));
+
+	GlobalInterruptEnable();
+
+	for (;;)
+	{
+		Mix_SetLayout(Layout);
+		Dsp_Configure(DSP_STAGES, Layout);
+		SampleRing_Reset(Layout, false);
+
+		GlobalInterruptDisable();
+
+		for (uint8_t Frame = 0; Frame < AUDIO_STREAM_OUT_FRAMES; Frame++)
+		{
+			Mix_Process(Input, Output);
+			Dsp_Process(Output);
+
+			for (uint8_t Entry = 0; Entry < Layout; Entry++)
+			  SampleRing_Push(Output[Entry]);
+		}
+
+		GlobalInterruptEnable();
+
+		Layout = ((Layout == 1) ? 2 : 1);
+	}
+}
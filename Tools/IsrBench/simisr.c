@@ -0,0 +1,123 @@
+/** \file
+ *
+ *  Runs an IsrBench firmware image under simavr, and reports how many cycles each sample ISR took. Every
+ *  stretch of execution with the global interrupt flag clear is taken to be one ISR, as nothing else in the
+ *  benchmark firmware disables interrupts; each is timed from the vector table jump to the end of its RETI.
+ *  The fixed 4 cycle interrupt response is not included.
+ *
+ *  Usage: simisr <firmware.elf> [cycles] [budget]
+ *
+ *  With a budget given, the run fails if any ISR took more cycles than that.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+
+/** Microcontroller the benchmark firmware is simulated on; it shares the USART1, Timer 0 and GPIOR layout of
+ *  the ATMEGA16U2, which simavr does not model.
+ */
+#define SIM_MCU            "atmega32u4"
+
+/** Clock frequency of the simulated microcontroller, in Hz. */
+#define SIM_FREQUENCY      16000000UL
+
+/** Default number of cycles to simulate, one second of run time. */
+#define SIM_DEFAULT_CYCLES SIM_FREQUENCY
+
+int main(int argc, char** argv)
+{
+	elf_firmware_t Firmware = {{0}};
+	avr_t*         AVR;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <firmware.elf> [cycles] [budget]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint64_t RunCycles = (argc > 2) ? strtoull(argv[2], NULL, 0) : SIM_DEFAULT_CYCLES;
+	uint64_t Budget    = (argc > 3) ? strtoull(argv[3], NULL, 0) : UINT64_MAX;
+
+	if (elf_read_firmware(argv[1], &Firmware) != 0)
+	{
+		fprintf(stderr, "Unable to read %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	if ((AVR = avr_make_mcu_by_name(SIM_MCU)) == NULL)
+	{
+		fprintf(stderr, "simavr does not support the %s\n", SIM_MCU);
+		return EXIT_FAILURE;
+	}
+
+	avr_init(AVR);
+	AVR->frequency = SIM_FREQUENCY;
+	avr_load_firmware(AVR, &Firmware);
+
+	bool     Started  = false;
+	bool     InISR    = false;
+	uint64_t ISRStart = 0;
+	uint64_t ISRCount = 0;
+	uint64_t Total    = 0;
+	uint64_t Min      = UINT64_MAX;
+	uint64_t Max      = 0;
+
+	while (AVR->cycle < RunCycles)
+	{
+		int State = avr_run(AVR);
+
+		if ((State == cpu_Done) || (State == cpu_Crashed))
+		  break;
+
+		bool Masked = !(AVR->sreg[S_I]);
+
+		/* Interrupts are disabled from reset until the firmware first enables them, which isn't an ISR */
+		if (!(Started))
+		{
+			Started = !(Masked);
+			continue;
+		}
+
+		if (Masked && !(InISR))
+		{
+			/* The step that took the interrupt leaves the core at the vector table */
+			InISR    = true;
+			ISRStart = AVR->cycle;
+		}
+		else if (!(Masked) && InISR)
+		{
+			uint64_t Cycles = (AVR->cycle - ISRStart);
+
+			InISR  = false;
+			Total += Cycles;
+			ISRCount++;
+
+			if (Cycles < Min)
+			  Min = Cycles;
+			if (Cycles > Max)
+			  Max = Cycles;
+		}
+	}
+
+	if (!(ISRCount))
+	{
+		fprintf(stderr, "No ISRs completed in %" PRIu64 " cycles\n", RunCycles);
+		return EXIT_FAILURE;
+	}
+
+	printf("%s: %" PRIu64 " ISRs, cycles min %" PRIu64 " avg %.1f max %" PRIu64 "\n",
+	       argv[1], ISRCount, Min, ((double)Total / ISRCount), Max);
+
+	if (Max > Budget)
+	{
+		fprintf(stderr, "%s: %" PRIu64 " cycles is over the budget of %" PRIu64 "\n", argv[1], Max, Budget);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,470 @@
+/** \file
+ *
+ *  Host tool to configure and inspect the ArduinoAudio device at runtime, through the vendor control requests
+ *  described in VendorProtocol.h. Settings written with this tool are saved to the device's EEPROM, and take
+ *  effect the next time the host starts a stream.
+ *
+ *  Usage:
+ *    audioctl settings
+ *    audioctl set [baud=250k|500k|1M|2M] [bits=8|16] [channels=mono|stereo] [depth=<frames>|auto] [dsp=<stages>]
+ *    audioctl reset
+ *    audioctl link
+ *    audioctl clock
+ *    audioctl buffer
+ *    audioctl emission [seconds]
+ *    audioctl levels [reports]
+ *
+ *  link shows the mode the link is running in, and the outcome of the rate probe run when the device starts: the
+ *  fastest baud rate it found clean, which caps the requested one, and the bit errors counted at the last rate to
+ *  fail.
+ *
+ *  A depth of auto lets the device adapt the buffer depth to the host, starting shallow and growing it after
+ *  each underrun; buffer shows the depth it has settled on, and the resulting latency.
+ *
+ *  emission shows how far the intervals between the samples sent to the output stray from the sample period over
+ *  the given time, one second by default, as a histogram. The device must be built with \c EMISSION_HISTOGRAM_BINS
+ *  defined, and a stream must be playing.
+ *
+ *  levels prints each level report the device sends, until the given number have been printed or forever by
+ *  default: the peak and RMS level in dBFS and the number of clipped samples of each channel, both before the
+ *  link reduces the samples and, on an 8-bit link, after. The device must be built with \c LEVEL_METER defined.
+ *
+ *  The DSP stages are given as a comma separated list of dc, eq1, eq2 and limit, or as none. The device refuses
+ *  stages which are not compiled into its firmware, or which would not fit its cycle budget.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libusb-1.0/libusb.h>
+
+#include "../LinkProtocol.h"
+#include "../VendorProtocol.h"
+
+/** Vendor and product ID of the device, as given in its device descriptor. */
+#define DEVICE_VID              0x03EB
+#define DEVICE_PID              0x3068
+
+/** Timeout in milliseconds of each control transfer. */
+#define CONTROL_TIMEOUT_MS      1000
+
+/** Largest emission histogram a device can report, and the width of its bars when printed. */
+#define MAX_EMISSION_BINS       64
+#define HISTOGRAM_BAR_WIDTH     50
+
+/** Interface number and interrupt endpoint address of the level meter interface. */
+#define LEVEL_INTERFACE         3
+#define LEVEL_ENDPOINT          0x82
+
+/** Timeout in milliseconds of each read of a level report, longer than the slowest report period. */
+#define LEVEL_TIMEOUT_MS        2000
+
+static const char* const BaudNames[] = {"250k", "500k", "1M", "2M"};
+
+/** Names of the outcomes of the link rate probe, in the order of \ref LinkProbeResults_t. */
+static const char* const ProbeResultNames[] = {"no-receiver", "unsupported", "clean", "failed"};
+
+/** Names of the DSP stages, in the order of their \c DSP_STAGE_* flags. */
+static const char* const DspStageNames[] = {"dc", "eq1", "eq2", "limit"};
+
+/** Performs a vendor control request on the device.
+ *
+ *  \param[in]     Device   Handle of the opened device.
+ *  \param[in]     Request  Request to perform, a value from \ref VendorRequests_t.
+ *  \param[in]     In       Non-zero if the data stage is device to host.
+ *  \param[in,out] Data     Data stage buffer.
+ *  \param[in]     Length   Length of the data stage.
+ *
+ *  \return Number of bytes transferred, or a negative libusb error code
+ */
+static int VendorRequest(libusb_device_handle* Device,
+                         uint8_t Request,
+                         int In,
+                         void* Data,
+                         uint16_t Length)
+{
+	uint8_t RequestType = (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | (In ? LIBUSB_ENDPOINT_IN : LIBUSB_ENDPOINT_OUT));
+
+	return libusb_control_transfer(Device, RequestType, Request, 0, 0, Data, Length, CONTROL_TIMEOUT_MS);
+}
+
+static void PrintSettings(const char* Name,
+                          const AppSettings_t* Settings)
+{
+	printf("%-8s baud=%s bits=%d channels=%s ", Name,
+	       (Settings->LinkBaud <= LINK_BAUD_2M) ? BaudNames[Settings->LinkBaud] : "?",
+	       (Settings->LinkFormat & LINK_FORMAT_16BIT) ? 16 : 8,
+	       (Settings->LinkFormat & LINK_FORMAT_STEREO) ? "stereo" : "mono");
+
+	if (Settings->RingDepth)
+	  printf("depth=%u dsp=", Settings->RingDepth);
+	else
+	  printf("depth=auto dsp=");
+
+	if (!(Settings->DspStages))
+	  printf("none");
+
+	for (uint8_t Stage = 0, Printed = 0; Stage < 4; Stage++)
+	{
+		if (Settings->DspStages & (1 << Stage))
+		  printf("%s%s", (Printed++ ? "," : ""), DspStageNames[Stage]);
+	}
+
+	printf("\n");
+}
+
+static int ParseDspStages(uint8_t* Stages,
+                          const char* Value)
+{
+	char List[32];
+
+	*Stages = 0;
+
+	if (!strcmp(Value, "none"))
+	  return 0;
+
+	snprintf(List, sizeof(List), "%s", Value);
+
+	for (char* Name = strtok(List, ","); Name; Name = strtok(NULL, ","))
+	{
+		uint8_t Stage;
+
+		for (Stage = 0; Stage < 4; Stage++)
+		{
+			if (!strcmp(Name, DspStageNames[Stage]))
+			  break;
+		}
+
+		if (Stage == 4)
+		  return -1;
+
+		*Stages |= (1 << Stage);
+	}
+
+	return 0;
+}
+
+static int ParseSetting(AppSettings_t* Settings,
+                        const char* Argument)
+{
+	const char* Value = strchr(Argument, '=');
+
+	if (!Value)
+	  return -1;
+
+	Value++;
+
+	if (!strncmp(Argument, "baud=", 5))
+	{
+		for (uint8_t Baud = LINK_BAUD_250K; Baud <= LINK_BAUD_2M; Baud++)
+		{
+			if (!strcmp(Value, BaudNames[Baud]))
+			{
+				Settings->LinkBaud = Baud;
+				return 0;
+			}
+		}
+	}
+	else if (!strncmp(Argument, "bits=", 5))
+	{
+		if (!strcmp(Value, "8") || !strcmp(Value, "16"))
+		{
+			Settings->LinkFormat &= ~LINK_FORMAT_16BIT;
+			Settings->LinkFormat |= (atoi(Value) == 16) ? LINK_FORMAT_16BIT : 0;
+			return 0;
+		}
+	}
+	else if (!strncmp(Argument, "channels=", 9))
+	{
+		if (!strcmp(Value, "mono") || !strcmp(Value, "stereo"))
+		{
+			Settings->LinkFormat &= ~LINK_FORMAT_STEREO;
+			Settings->LinkFormat |= !strcmp(Value, "stereo") ? LINK_FORMAT_STEREO : 0;
+			return 0;
+		}
+	}
+	else if (!strncmp(Argument, "depth=", 6))
+	{
+		Settings->RingDepth = strcmp(Value, "auto") ? atoi(Value) : 0;
+		return 0;
+	}
+	else if (!strncmp(Argument, "dsp=", 4))
+	{
+		return ParseDspStages(&Settings->DspStages, Value);
+	}
+
+	return -1;
+}
+
+/** Prints the emission histogram, with a bar scaled to the fullest bin for each bin.
+ *
+ *  \param[in] Status  Histogram header.
+ *  \param[in] Counts  Count of each bin.
+ */
+static void PrintEmission(const EmissionStatus_t* Status,
+                          const uint16_t* Counts)
+{
+	unsigned Total   = 0;
+	unsigned Largest = 1;
+
+	for (uint8_t Bin = 0; Bin < Status->Bins; Bin++)
+	{
+		Total  += Counts[Bin];
+		Largest = (Counts[Bin] > Largest) ? Counts[Bin] : Largest;
+	}
+
+	printf("period=%u cycles intervals=%u", Status->NominalCycles, Total);
+
+	if (!(Total))
+	{
+		printf("\n");
+		return;
+	}
+
+	printf(" min=%+d max=%+d cycles\n", Status->MinCycles, Status->MaxCycles);
+
+	for (uint8_t Bin = 0; Bin < Status->Bins; Bin++)
+	{
+		int From = ((Bin - (Status->Bins / 2)) * Status->BinCycles);
+
+		if (Bin == 0)
+		  printf("      <%+5d", (From + Status->BinCycles));
+		else if (Bin == (Status->Bins - 1))
+		  printf("     >=%+5d", From);
+		else
+		  printf("%+5d..%+5d", From, (From + Status->BinCycles - 1));
+
+		printf(" %6u |%.*s\n", Counts[Bin], (int)((Counts[Bin] * HISTOGRAM_BAR_WIDTH + Largest - 1) / Largest),
+		       "##################################################");
+	}
+}
+
+/** Converts a magnitude to decibels relative to full scale.
+ *
+ *  \param[in] Level      Magnitude to convert.
+ *  \param[in] FullScale  Magnitude of full scale.
+ *
+ *  \return Level in dBFS, or -infinity for silence
+ */
+static double ToDecibels(unsigned Level,
+                         unsigned FullScale)
+{
+	return (20.0 * log10((double)Level / FullScale));
+}
+
+/** Prints a level report, one line for each channel the link carries.
+ *
+ *  \param[in] Report  Level report received from the device.
+ */
+static void PrintLevels(const LevelReport_t* Report)
+{
+	uint8_t Channels = (Report->Flags & LEVEL_FLAG_STEREO) ? 2 : 1;
+
+	for (uint8_t Channel = 0; Channel < Channels; Channel++)
+	{
+		const LevelChannel_t* Levels = &Report->Channels[Channel];
+
+		printf("%3u %s peak=%6.1f rms=%6.1f clips=%-5u", Report->Sequence, (Channels == 1) ? "M" : (Channel ? "R" : "L"),
+		       ToDecibels(Levels->Peak, 32768), ToDecibels(Levels->RMS, 32768), Levels->Clips);
+
+		if ((Report->Flags & LEVEL_FLAG_REDUCED) && (Report->Bits >= 2) && (Report->Bits < 16))
+		{
+			unsigned FullScale = (1U << (Report->Bits - 1));
+
+			printf(" | %u-bit peak=%6.1f rms=%6.1f clips=%-5u", Report->Bits, ToDecibels(Levels->LinkPeak, FullScale),
+			       ToDecibels(Levels->LinkRMS, FullScale), Levels->LinkClips);
+		}
+
+		printf(" frames=%u", Report->Frames);
+
+		if (Report->Stride > 1)
+		  printf("/%u", Report->Stride);
+
+		printf("\n");
+	}
+}
+
+int main(int argc,
+         char* argv[])
+{
+	libusb_device_handle* Device;
+	AppSettings_t         Settings[2];
+	int                   Result = 1;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s settings | set <name>=<value>... | reset | link | clock | buffer | emission [seconds] | levels [reports]\n",
+		        argv[0]);
+		return 1;
+	}
+
+	if (libusb_init(NULL) < 0)
+	  return 1;
+
+	if (!(Device = libusb_open_device_with_vid_pid(NULL, DEVICE_VID, DEVICE_PID)))
+	{
+		fprintf(stderr, "device %04x:%04x not found\n", DEVICE_VID, DEVICE_PID);
+		libusb_exit(NULL);
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "settings"))
+	{
+		if (VendorRequest(Device, VENDOR_REQ_GetSettings, 1, Settings, sizeof(Settings)) == sizeof(Settings))
+		{
+			PrintSettings("active", &Settings[0]);
+			PrintSettings("pending", &Settings[1]);
+			Result = 0;
+		}
+	}
+	else if (!strcmp(argv[1], "set"))
+	{
+		if (VendorRequest(Device, VENDOR_REQ_GetSettings, 1, Settings, sizeof(Settings)) == sizeof(Settings))
+		{
+			Result = 0;
+
+			for (int i = 2; i < argc; i++)
+			{
+				if (ParseSetting(&Settings[1], argv[i]))
+				{
+					fprintf(stderr, "invalid setting '%s'\n", argv[i]);
+					Result = 1;
+				}
+			}
+
+			if (!Result && (VendorRequest(Device, VENDOR_REQ_SetSettings, 0, &Settings[1], sizeof(AppSettings_t)) != sizeof(AppSettings_t)))
+			{
+				fprintf(stderr, "device rejected the settings\n");
+				Result = 1;
+			}
+
+			if (!Result)
+			  PrintSettings("pending", &Settings[1]);
+		}
+	}
+	else if (!strcmp(argv[1], "reset"))
+	{
+		Result = (VendorRequest(Device, VENDOR_REQ_ResetSettings, 0, NULL, 0) < 0);
+	}
+	else if (!strcmp(argv[1], "link"))
+	{
+		LinkStatus_t LinkStatus;
+
+		if (VendorRequest(Device, VENDOR_REQ_GetLinkStatus, 1, &LinkStatus, sizeof(LinkStatus)) == sizeof(LinkStatus))
+		{
+			printf("%s baud=%s bits=%d channels=%s capture=%s\n", LinkStatus.Negotiated ? "negotiated" : "base",
+			       (LinkStatus.LinkBaud <= LINK_BAUD_2M) ? BaudNames[LinkStatus.LinkBaud] : "?",
+			       (LinkStatus.LinkFormat & LINK_FORMAT_16BIT) ? 16 : 8,
+			       (LinkStatus.LinkFormat & LINK_FORMAT_STEREO) ? "stereo" : "mono",
+			       (LinkStatus.LinkFormat & LINK_FORMAT_CAPTURE) ? "on" : "off");
+			printf("probe=%s max=%s errors=%u drops=%u\n",
+			       (LinkStatus.ProbeResult <= LINK_PROBE_Failed) ? ProbeResultNames[LinkStatus.ProbeResult] : "?",
+			       (LinkStatus.MaxBaud <= LINK_BAUD_2M) ? BaudNames[LinkStatus.MaxBaud] : "?",
+			       LinkStatus.ProbeErrors, LinkStatus.Drops);
+			Result = 0;
+		}
+	}
+	else if (!strcmp(argv[1], "clock"))
+	{
+		ClockStatus_t ClockStatus;
+
+		if (VendorRequest(Device, VENDOR_REQ_GetClockStatus, 1, &ClockStatus, sizeof(ClockStatus)) == sizeof(ClockStatus))
+		{
+			printf("sync=%s ", ClockStatus.SyncMode ? "sof" : "free-running");
+
+			if (ClockStatus.Locked)
+			  printf("drift=%+.2fppm\n", ClockStatus.DriftCentiPPM / 100.0);
+			else
+			  printf("drift=unmeasured\n");
+
+			Result = 0;
+		}
+	}
+	else if (!strcmp(argv[1], "buffer"))
+	{
+		BufferStatus_t BufferStatus;
+
+		if (VendorRequest(Device, VENDOR_REQ_GetBufferStatus, 1, &BufferStatus, sizeof(BufferStatus)) == sizeof(BufferStatus))
+		{
+			printf("%s target=%u depth=%u low=%u latency=%.2fms underruns=%u merges=%u concealed=%u\n",
+			       BufferStatus.Adaptive ? "adaptive" : "fixed", BufferStatus.TargetDepth, BufferStatus.Depth,
+			       BufferStatus.LowWater, BufferStatus.LatencyUS / 1000.0, BufferStatus.Underruns, BufferStatus.Merges,
+			       BufferStatus.Concealments);
+			Result = 0;
+		}
+	}
+	else if (!strcmp(argv[1], "emission"))
+	{
+		struct
+		{
+			EmissionStatus_t Status;
+			uint16_t         Counts[MAX_EMISSION_BINS];
+		} Histogram;
+
+		unsigned Seconds = (argc > 2) ? atoi(argv[2]) : 1;
+		int      Length;
+
+		/* Empty the histogram, then let it fill for the requested time */
+		if (libusb_control_transfer(Device, (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | LIBUSB_ENDPOINT_IN),
+		                            VENDOR_REQ_GetEmission, 1, 0, (uint8_t*)&Histogram, sizeof(Histogram), CONTROL_TIMEOUT_MS) < 0)
+		{
+			fprintf(stderr, "device does not record emissions, rebuild it with EMISSION_HISTOGRAM_BINS defined\n");
+		}
+		else
+		{
+			sleep(Seconds);
+
+			Length = VendorRequest(Device, VENDOR_REQ_GetEmission, 1, &Histogram, sizeof(Histogram));
+
+			if ((Length >= (int)sizeof(EmissionStatus_t)) && (Histogram.Status.Bins <= MAX_EMISSION_BINS) &&
+			    (Length >= (int)(sizeof(EmissionStatus_t) + (Histogram.Status.Bins * sizeof(uint16_t)))))
+			{
+				PrintEmission(&Histogram.Status, Histogram.Counts);
+				Result = 0;
+			}
+		}
+	}
+	else if (!strcmp(argv[1], "levels"))
+	{
+		LevelReport_t Report;
+
+		unsigned Reports = (argc > 2) ? atoi(argv[2]) : 0;
+		int      Length;
+
+		if (libusb_claim_interface(Device, LEVEL_INTERFACE) < 0)
+		{
+			fprintf(stderr, "device has no level meter, rebuild it with LEVEL_METER defined\n");
+		}
+		else
+		{
+			Result = 0;
+
+			for (unsigned Count = 0; !(Reports) || (Count < Reports); Count++)
+			{
+				if ((libusb_interrupt_transfer(Device, LEVEL_ENDPOINT, (unsigned char*)&Report, sizeof(Report), &Length,
+				                               LEVEL_TIMEOUT_MS) < 0) || (Length != sizeof(Report)))
+				{
+					fprintf(stderr, "device has no level meter, rebuild it with LEVEL_METER defined\n");
+					Result = 1;
+					break;
+				}
+
+				PrintLevels(&Report);
+				fflush(stdout);
+			}
+
+			libusb_release_interface(Device, LEVEL_INTERFACE);
+		}
+	}
+	else
+	{
+		fprintf(stderr, "unknown command '%s'\n", argv[1]);
+	}
+
+	libusb_close(Device);
+	libusb_exit(NULL);
+	return Result;
+}
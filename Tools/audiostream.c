@@ -0,0 +1,318 @@
+/** \file
+ *
+ *  Host tool to play raw PCM through the vendor stream interface of the ArduinoAudio device, as an alternative to
+ *  the isochronous speaker stream for audio generated on the host. The device must be built with
+ *  \c VENDOR_STREAM defined. Samples are written to its bulk endpoint, which only takes each packet once the
+ *  device has room for it, so nothing is lost to a late frame and the pace is set by the device's sample clock.
+ *
+ *  Usage:
+ *    audiostream [-r <rate>] [-q <transfers>] [<file> | -]
+ *
+ *  The input is read from the file, or from stdin if none is given or it is -, and must be interleaved PCM in the
+ *  format of the device's speaker stream: as many channels as the firmware was built with, as 16-bit signed little
+ *  endian samples. The tool prints the format it expects, which it reads from the interface descriptor. For
+ *  example, to play a WAV file at 8kHz on a stereo build:
+ *
+ *    sox music.wav -t raw -e signed -b 16 -c 2 -r 8000 - | audiostream -r 8000
+ *
+ *  The given number of bulk transfers are kept queued, four by default, so that the host can fall behind by
+ *  the whole queue before the device runs dry.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libusb-1.0/libusb.h>
+
+#include "../VendorProtocol.h"
+
+/** Vendor and product ID of the device, as given in its device descriptor. */
+#define DEVICE_VID              0x03EB
+#define DEVICE_PID              0x3068
+
+/** Timeout in milliseconds of each control transfer. */
+#define CONTROL_TIMEOUT_MS      1000
+
+/** Alternate setting of the vendor stream interface which opens the stream. */
+#define STREAM_ALT_SETTING      1
+
+/** Size in bytes of each bulk transfer, rounded down to whole frames, and the most transfers queued at once. */
+#define TRANSFER_BYTES          4096
+#define MAX_TRANSFERS           16
+
+/** Time in milliseconds to let the device play out its ring before the stream is closed. */
+#define DRAIN_MS                100
+
+/** Vendor stream interface found on the device. */
+typedef struct
+{
+	int     Number; /**< Interface number. */
+	uint8_t Endpoint; /**< Address of the bulk OUT endpoint. */
+	uint8_t Channels; /**< Number of channels in each frame. */
+	uint8_t SubframeSize; /**< Size in bytes of each sample. */
+} StreamInterface_t;
+
+/** Set from the signal handler to stop streaming. */
+static volatile sig_atomic_t Interrupted;
+
+/** Input file, and whether it has run out. */
+static FILE* Input;
+static int   InputEnded;
+
+/** Bytes in each transfer, the number of transfers still queued, and the frames sent so far. */
+static int           TransferBytes;
+static int           TransfersQueued;
+static unsigned long FramesSent;
+static int           FrameSize;
+static int           TransferFailed;
+
+static void HandleSignal(int Signal)
+{
+	Interrupted = 1;
+}
+
+/** Finds the vendor stream interface in the device's active configuration.
+ *
+ *  \param[in]  Device     Handle of the opened device.
+ *  \param[out] Interface  Interface found.
+ *
+ *  \return Zero if the interface was found, -1 otherwise
+ */
+static int FindStreamInterface(libusb_device_handle* Device,
+                               StreamInterface_t* Interface)
+{
+	struct libusb_config_descriptor* Config;
+	int                              Result = -1;
+
+	if (libusb_get_active_config_descriptor(libusb_get_device(Device), &Config) < 0)
+	  return -1;
+
+	for (int i = 0; i < Config->bNumInterfaces; i++)
+	{
+		const struct libusb_interface* Alternates = &Config->interface[i];
+
+		for (int Alt = 0; Alt < Alternates->num_altsetting; Alt++)
+		{
+			const struct libusb_interface_descriptor* Descriptor = &Alternates->altsetting[Alt];
+
+			if ((Descriptor->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC) || (Descriptor->bAlternateSetting != STREAM_ALT_SETTING) ||
+			    (Descriptor->bNumEndpoints != 1))
+			{
+				continue;
+			}
+
+			/* The firmware describes its frame format in the otherwise unused subclass and protocol fields */
+			Interface->Number       = Descriptor->bInterfaceNumber;
+			Interface->Endpoint     = Descriptor->endpoint[0].bEndpointAddress;
+			Interface->Channels     = Descriptor->bInterfaceSubClass;
+			Interface->SubframeSize = Descriptor->bInterfaceProtocol;
+			Result = 0;
+		}
+	}
+
+	libusb_free_config_descriptor(Config);
+	return Result;
+}
+
+/** Fills a transfer's buffer with whole frames from the input.
+ *
+ *  \param[in,out] Transfer  Transfer to fill.
+ *
+ *  \return Number of bytes filled, zero once the input has run out
+ */
+static int FillTransfer(struct libusb_transfer* Transfer)
+{
+	size_t Length = 0;
+
+	while (!(InputEnded) && (Length < (size_t)TransferBytes))
+	{
+		size_t Read = fread(&Transfer->buffer[Length], 1, (TransferBytes - Length), Input);
+
+		if (!(Read))
+		  InputEnded = 1;
+
+		Length += Read;
+	}
+
+	/* A partial frame at the very end of the input is dropped, so that every packet holds whole frames */
+	Length -= (Length % FrameSize);
+	Transfer->length = Length;
+
+	return Length;
+}
+
+/** Completion callback of the bulk transfers, which refills each transfer and queues it again until the input
+ *  runs out or streaming is interrupted.
+ *
+ *  \param[in] Transfer  Completed transfer.
+ */
+static void LIBUSB_CALL TransferComplete(struct libusb_transfer* Transfer)
+{
+	if (Transfer->status == LIBUSB_TRANSFER_COMPLETED)
+	{
+		FramesSent += (Transfer->actual_length / FrameSize);
+	}
+	else if (Transfer->status != LIBUSB_TRANSFER_CANCELLED)
+	{
+		fprintf(stderr, "transfer failed: %s\n", libusb_error_name(Transfer->status));
+		TransferFailed = 1;
+	}
+
+	if (!(Interrupted) && !(TransferFailed) && FillTransfer(Transfer) && (libusb_submit_transfer(Transfer) == 0))
+	  return;
+
+	TransfersQueued--;
+}
+
+int main(int argc,
+         char* argv[])
+{
+	libusb_device_handle*   Device;
+	StreamInterface_t       Interface;
+	struct libusb_transfer* Transfers[MAX_TRANSFERS] = {NULL};
+	unsigned                SampleRate = 8000;
+	int                     Queue      = 4;
+	int                     Option;
+	int                     Result     = 1;
+
+	while ((Option = getopt(argc, argv, "r:q:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'r':
+				SampleRate = atoi(optarg);
+				break;
+			case 'q':
+				Queue = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-r rate] [-q transfers] [file | -]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((Queue < 1) || (Queue > MAX_TRANSFERS))
+	{
+		fprintf(stderr, "queue must be between 1 and %d transfers\n", MAX_TRANSFERS);
+		return 1;
+	}
+
+	if ((optind < argc) && strcmp(argv[optind], "-"))
+	{
+		if (!(Input = fopen(argv[optind], "rb")))
+		{
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+	else
+	{
+		Input = stdin;
+	}
+
+	if (libusb_init(NULL) < 0)
+	  return 1;
+
+	if (!(Device = libusb_open_device_with_vid_pid(NULL, DEVICE_VID, DEVICE_PID)))
+	{
+		fprintf(stderr, "device %04x:%04x not found\n", DEVICE_VID, DEVICE_PID);
+		libusb_exit(NULL);
+		return 1;
+	}
+
+	if (FindStreamInterface(Device, &Interface) < 0)
+	{
+		fprintf(stderr, "device has no vendor stream, rebuild it with VENDOR_STREAM defined\n");
+		goto Close;
+	}
+
+	if (libusb_claim_interface(Device, Interface.Number) < 0)
+	{
+		fprintf(stderr, "vendor stream interface is in use\n");
+		goto Close;
+	}
+
+	if (libusb_control_transfer(Device, (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | LIBUSB_ENDPOINT_OUT),
+	                            VENDOR_REQ_SetStreamRate, SampleRate, 0, NULL, 0, CONTROL_TIMEOUT_MS) < 0)
+	{
+		fprintf(stderr, "device refused a rate of %u Hz\n", SampleRate);
+		goto Release;
+	}
+
+	FrameSize     = (Interface.Channels * Interface.SubframeSize);
+	TransferBytes = (TRANSFER_BYTES - (TRANSFER_BYTES % FrameSize));
+
+	fprintf(stderr, "streaming %u channels of %s PCM at %u Hz\n", Interface.Channels,
+	        (Interface.SubframeSize == 1) ? "8-bit unsigned" : "16-bit signed little endian", SampleRate);
+
+	if (libusb_set_interface_alt_setting(Device, Interface.Number, STREAM_ALT_SETTING) < 0)
+	{
+		fprintf(stderr, "could not open the vendor stream\n");
+		goto Release;
+	}
+
+	signal(SIGINT, HandleSignal);
+
+	for (int i = 0; i < Queue; i++)
+	{
+		if (!(Transfers[i] = libusb_alloc_transfer(0)))
+		  break;
+
+		libusb_fill_bulk_transfer(Transfers[i], Device, Interface.Endpoint, malloc(TransferBytes), 0, TransferComplete, NULL, 0);
+
+		if (!(Transfers[i]->buffer) || !(FillTransfer(Transfers[i])) || (libusb_submit_transfer(Transfers[i]) < 0))
+		  break;
+
+		TransfersQueued++;
+	}
+
+	while (TransfersQueued)
+	{
+		struct timeval Timeout = {.tv_sec = 0, .tv_usec = 100000};
+
+		libusb_handle_events_timeout(NULL, &Timeout);
+
+		/* Transfers wait on the device's flow control with no timeout of their own, so they are cancelled here */
+		if (Interrupted)
+		{
+			for (int i = 0; i < Queue; i++)
+			{
+				if (Transfers[i])
+				  libusb_cancel_transfer(Transfers[i]);
+			}
+		}
+	}
+
+	/* Let the device play out what it has buffered before closing the stream, which empties its ring */
+	if (!(Interrupted))
+	  usleep(DRAIN_MS * 1000);
+
+	libusb_set_interface_alt_setting(Device, Interface.Number, 0);
+
+	fprintf(stderr, "sent %lu frames (%.2f s)\n", FramesSent, ((double)FramesSent / SampleRate));
+	Result = TransferFailed;
+
+	for (int i = 0; i < Queue; i++)
+	{
+		if (Transfers[i])
+		{
+			free(Transfers[i]->buffer);
+			libusb_free_transfer(Transfers[i]);
+		}
+	}
+
+Release:
+	libusb_release_interface(Device, Interface.Number);
+
+Close:
+	libusb_close(Device);
+	libusb_exit(NULL);
+
+	if (Input != stdin)
+	  fclose(Input);
+
+	return Result;
+}
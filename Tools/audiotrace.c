@@ -0,0 +1,313 @@
+/** \file
+ *
+ *  Host tool to record the event trace of the ArduinoAudio device as a timeline, through the vendor control
+ *  requests described in VendorProtocol.h. The device must be built with \c TRACE_EVENTS defined. The trace is
+ *  polled until the duration runs out, a trigger event stops it, or the tool is interrupted, and written out
+ *  in the Chrome trace event format for chrome://tracing or Perfetto.
+ *
+ *  Usage:
+ *    audiotrace [-e <events>] [-t <events>] [-i <interval ms>] [-d <seconds>] [-o <trace.json>]
+ *
+ *  Events are given as a comma separated list of sof, packet, underrun, drop, rate and alt, or as all. By
+ *  default every event but sof and packet is traced, as those fill the device's buffer within a few frames;
+ *  the events given to -t stop the trace once the device's buffer is half filled after one of them.
+ *
+ *  Each poll of the device appears on the host track of the timeline, so that a gap in the polls can be lined
+ *  up with the device events around it. Device times are placed on the host clock using the first poll.
+ */
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libusb-1.0/libusb.h>
+
+#include "../VendorProtocol.h"
+
+/** Vendor and product ID of the device, as given in its device descriptor. */
+#define DEVICE_VID              0x03EB
+#define DEVICE_PID              0x3068
+
+/** Timeout in milliseconds of each control transfer. */
+#define CONTROL_TIMEOUT_MS      1000
+
+/** System clock cycles of the device in each microsecond, the unit of the trace's cycle counts. */
+#define DEVICE_CYCLES_PER_US    16
+
+/** Largest trace buffer a device can report. */
+#define MAX_TRACE_EVENTS        128
+
+/** Chrome trace process IDs of the device and host tracks. */
+#define PID_DEVICE              1
+#define PID_HOST                2
+
+/** Names of the trace events, in the order of \ref TraceEvents_t. */
+static const char* const EventNames[] = {"sof", "packet", "underrun", "drop", "rate", "alt"};
+
+#define EVENT_COUNT             (sizeof(EventNames) / sizeof(EventNames[0]))
+
+/** Set from the signal handler to end the trace. */
+static volatile sig_atomic_t Interrupted;
+
+/** Output file, and whether an event has already been written to it. */
+static FILE* Output;
+static int   OutputEvents;
+
+static void HandleSignal(int Signal)
+{
+	Interrupted = 1;
+}
+
+/** Reads the host's monotonic clock.
+ *
+ *  \return Time in microseconds.
+ */
+static double HostTime(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return ((Now.tv_sec * 1e6) + (Now.tv_nsec / 1e3));
+}
+
+static int ParseEvents(uint8_t* Mask,
+                       const char* Value)
+{
+	char List[64];
+
+	*Mask = 0;
+
+	if (!strcmp(Value, "all"))
+	{
+		*Mask = ((1 << EVENT_COUNT) - 1);
+		return 0;
+	}
+
+	snprintf(List, sizeof(List), "%s", Value);
+
+	for (char* Name = strtok(List, ","); Name; Name = strtok(NULL, ","))
+	{
+		uint8_t Event;
+
+		for (Event = 0; Event < EVENT_COUNT; Event++)
+		{
+			if (!strcmp(Name, EventNames[Event]))
+			  break;
+		}
+
+		if (Event == EVENT_COUNT)
+		  return -1;
+
+		*Mask |= (1 << Event);
+	}
+
+	return 0;
+}
+
+/** Writes a single event to the trace file, separating it from the previous one.
+ *
+ *  \param[in] Format  printf() format of the JSON object of the event.
+ */
+static void WriteEvent(const char* Format,
+                       ...)
+{
+	va_list Arguments;
+
+	fprintf(Output, "%s\n", (OutputEvents++ ? "," : ""));
+
+	va_start(Arguments, Format);
+	vfprintf(Output, Format, Arguments);
+	va_end(Arguments);
+}
+
+static void WriteTrackNames(void)
+{
+	WriteEvent("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"device\"}}", PID_DEVICE);
+	WriteEvent("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"host\"}}", PID_HOST);
+	WriteEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"audiotrace\"}}", PID_HOST);
+
+	for (uint8_t Event = 0; Event < EVENT_COUNT; Event++)
+	{
+		WriteEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+		           PID_DEVICE, Event, EventNames[Event]);
+	}
+}
+
+int main(int argc,
+         char* argv[])
+{
+	libusb_device_handle* Device;
+	const char*           OutputName = "trace.json";
+	uint8_t               Mask       = ((1 << TRACE_EVENT_Underrun) | (1 << TRACE_EVENT_LinkDrop) |
+	                                    (1 << TRACE_EVENT_RateChange) | (1 << TRACE_EVENT_AltSetting));
+	uint8_t               Triggers   = 0;
+	unsigned              IntervalMS = 10;
+	double                Duration   = 10;
+	int                   Option;
+
+	while ((Option = getopt(argc, argv, "e:t:i:d:o:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'e':
+				if (ParseEvents(&Mask, optarg) < 0)
+				{
+					fprintf(stderr, "unknown event in %s\n", optarg);
+					return 1;
+				}
+
+				break;
+			case 't':
+				if (ParseEvents(&Triggers, optarg) < 0)
+				{
+					fprintf(stderr, "unknown event in %s\n", optarg);
+					return 1;
+				}
+
+				break;
+			case 'i':
+				IntervalMS = atoi(optarg);
+				break;
+			case 'd':
+				Duration = atof(optarg);
+				break;
+			case 'o':
+				OutputName = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-e events] [-t events] [-i interval_ms] [-d seconds] [-o trace.json]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	/* Trigger events are always traced, or they could never stop the trace */
+	Mask |= Triggers;
+
+	if (libusb_init(NULL) < 0)
+	  return 1;
+
+	if (!(Device = libusb_open_device_with_vid_pid(NULL, DEVICE_VID, DEVICE_PID)))
+	{
+		fprintf(stderr, "device %04x:%04x not found\n", DEVICE_VID, DEVICE_PID);
+		libusb_exit(NULL);
+		return 1;
+	}
+
+	if (libusb_control_transfer(Device, (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | LIBUSB_ENDPOINT_OUT),
+	                            VENDOR_REQ_SetTrace, Mask, Triggers, NULL, 0, CONTROL_TIMEOUT_MS) < 0)
+	{
+		fprintf(stderr, "device does not support tracing, rebuild it with TRACE_EVENTS defined\n");
+		libusb_close(Device);
+		libusb_exit(NULL);
+		return 1;
+	}
+
+	if (!(Output = fopen(OutputName, "w")))
+	{
+		perror(OutputName);
+		libusb_close(Device);
+		libusb_exit(NULL);
+		return 1;
+	}
+
+	signal(SIGINT, HandleSignal);
+
+	fprintf(Output, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	WriteTrackNames();
+
+	double   Start       = HostTime();
+	double   Offset      = 0;
+	uint32_t Frame       = 0;
+	uint16_t LastFrame   = 0;
+	int      Polls       = 0;
+	unsigned TotalEvents = 0;
+	unsigned TotalLost   = 0;
+	int      Result      = 0;
+
+	while (!(Interrupted) && ((HostTime() - Start) < (Duration * 1e6)))
+	{
+		struct
+		{
+			TraceStatus_t Status;
+			TraceEvent_t  Events[MAX_TRACE_EVENTS];
+		} __attribute__((packed)) Trace;
+
+		double Requested = HostTime();
+		int    Length    = libusb_control_transfer(Device, (LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | LIBUSB_ENDPOINT_IN),
+		                                           VENDOR_REQ_GetTrace, 0, 0, (uint8_t*)&Trace, sizeof(Trace), CONTROL_TIMEOUT_MS);
+		double Completed = HostTime();
+
+		if (Length < (int)sizeof(TraceStatus_t))
+		{
+			fprintf(stderr, "trace read failed: %s\n", (Length < 0) ? libusb_error_name(Length) : "short reply");
+			Result = 1;
+			break;
+		}
+
+		/* Extend the device's start of frame count, which wraps every 65 seconds, across the polls */
+		Frame    += (Polls ? (uint16_t)(Trace.Status.Frame - LastFrame) : Trace.Status.Frame);
+		LastFrame = Trace.Status.Frame;
+
+		double DeviceNow = ((Frame * 1000.0) + ((double)Trace.Status.Cycles / DEVICE_CYCLES_PER_US));
+
+		/* Line the device clock up with the host's, taking the device to have been read halfway through the first poll */
+		if (!(Polls++))
+		  Offset = (((Requested + Completed) / 2) - Start) - DeviceNow;
+
+		WriteEvent("{\"name\":\"poll\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,\"ts\":%.1f,\"dur\":%.1f}",
+		           PID_HOST, (Requested - Start), (Completed - Requested));
+
+		uint8_t Capacity = Trace.Status.Capacity;
+		uint8_t Count    = Trace.Status.Count;
+
+		if (!(Capacity) || (Capacity > MAX_TRACE_EVENTS) || (Count > Capacity) ||
+		    (Length < (int)(sizeof(TraceStatus_t) + (Capacity * sizeof(TraceEvent_t)))))
+		{
+			fprintf(stderr, "malformed trace reply\n");
+			Result = 1;
+			break;
+		}
+
+		for (uint8_t i = 0; i < Count; i++)
+		{
+			const TraceEvent_t* Event = &Trace.Events[((Trace.Status.Next + Capacity - Count) + i) % Capacity];
+
+			uint32_t EventFrame = (Frame - (uint16_t)(Trace.Status.Frame - Event->Frame));
+			double   EventTime  = ((EventFrame * 1000.0) + ((double)Event->Cycles / DEVICE_CYCLES_PER_US) + Offset);
+
+			WriteEvent("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%u,\"ts\":%.1f,\"args\":{\"data\":%u}}",
+			           ((Event->Event < EVENT_COUNT) ? EventNames[Event->Event] : "unknown"), PID_DEVICE, Event->Event,
+			           EventTime, Event->Data);
+		}
+
+		if (Trace.Status.Lost)
+		{
+			WriteEvent("{\"name\":\"lost %u events\",\"ph\":\"i\",\"s\":\"p\",\"pid\":%d,\"ts\":%.1f}",
+			           Trace.Status.Lost, PID_DEVICE, (DeviceNow + Offset));
+		}
+
+		TotalEvents += Count;
+		TotalLost   += Trace.Status.Lost;
+
+		if (Trace.Status.Flags & TRACE_FLAG_STOPPED)
+		{
+			printf("trace stopped by a trigger event\n");
+			break;
+		}
+
+		usleep(IntervalMS * 1000);
+	}
+
+	fprintf(Output, "\n]}\n");
+	fclose(Output);
+
+	printf("%u events (%u lost) over %d polls written to %s\n", TotalEvents, TotalLost, Polls, OutputName);
+
+	libusb_close(Device);
+	libusb_exit(NULL);
+	return Result;
+}
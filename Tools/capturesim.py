@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+#
+# Model of the receiver's microphone capture engine (Receiver/Capture.c), for exercising it without hardware. Its
+# figures depend on the assumed ADC accuracy and are not a measurement of a board. A sine tone is sampled at the instants the engine would trigger its conversions, with
+# gaussian input noise, quantized by a 10-bit ADC, decimated, and written out at the frame rate as a 16-bit WAV
+# file for Tools/enob. The frame period measurement, the choice of the number of conversions, the phase lock and
+# the decimation use the same fixed point arithmetic as the firmware; the frames arrive with random jitter, and
+# the receiver's clock can be set apart from the transmitter's.
+#
+# The ADC is ideal unless --adc-bits is given: the receiver clocks it at 1MHz, five times the 200kHz the datasheet
+# gives for full 10-bit accuracy, and the datasheet gives no figure for what is left at that clock, so a board can
+# be expected to fall short of the ideal model. With --adc-bits each conversion is rounded to that many bits
+# instead, as a crude stand-in for the lost accuracy.
+#
+# Usage: capturesim.py [--rates 8000,16000,...] [--noise LSB] [--jitter US] [--clock-error PERCENT]
+#                      [--adc-bits BITS] [--tone HZ] [--seconds S] [--output DIR]
+#
+# Each rate is written to capture_<rate>.wav in the output directory, and the number of conversions, the range
+# of the lock's phase error once settled, and the number of frames which found no new sample are printed.
+
+import argparse
+import math
+import os
+import random
+import struct
+import wave
+
+F_CPU                       = 16000000
+CAPTURE_CONVERSION_CYCLES   = 232
+CAPTURE_MAX_CONVERSIONS     = 16
+CAPTURE_MEASURE_FRAMES      = 64
+CAPTURE_RECIPROCAL_BITS     = 9
+CAPTURE_LOCK_INTEGRAL_SHIFT = 4
+CAPTURE_LOCK_INTEGRAL_LIMIT = 16000
+
+# Sample and hold of an auto-triggered conversion, 1.5 ADC clocks after the trigger
+ADC_SAMPLE_CYCLES           = 24
+
+RECIPROCALS = [round((1 << (6 + CAPTURE_RECIPROCAL_BITS)) / n) for n in range(1, CAPTURE_MAX_CONVERSIONS + 1)]
+
+def clamp(value, low, high):
+	return max(low, min(high, value))
+
+def simulate(rate, args):
+	cycle  = 1.0 / (F_CPU * (1 + (args.clock_error / 100)))
+	step   = 2 ** (10 - args.adc_bits)
+	frames = [((k + 1) / rate) + random.uniform(0, args.jitter * 1e-6) for k in range(int(rate * args.seconds))]
+
+	# Frame period measured on timer 0 at Fcpu/8, as by Capture_Lock()
+	ticks       = int((frames[CAPTURE_MEASURE_FRAMES] - frames[0]) / (8 * cycle)) & 0xFFFF
+	frame_cycles = ticks // (CAPTURE_MEASURE_FRAMES // 8)
+	conversions = clamp(frame_cycles // CAPTURE_CONVERSION_CYCLES, 1, CAPTURE_MAX_CONVERSIONS)
+	period      = (ticks << 5) // conversions
+	prescale    = 1
+
+	if period > 0xFFFF:
+		period  >>= 3
+		prescale  = 8
+
+	tick        = prescale * cycle
+	nominal     = period
+	frame_ticks = (period * conversions) >> 8
+	complete    = ((conversions - 1) * (period >> 8)) + ((CAPTURE_CONVERSION_CYCLES + prescale - 1) // prescale)
+	target      = (complete + (frame_ticks // 2)) % frame_ticks
+	integrator  = 0
+
+	# Timer 0 and the two ISRs
+	trigger     = frames[CAPTURE_MEASURE_FRAMES] + (((period >> 8)) * tick)
+	fraction    = period & 0xFF
+	last_trigger = frames[CAPTURE_MEASURE_FRAMES]
+	slot        = 0
+	total       = 0
+	count       = 0
+	completed   = []
+
+	output = [0x8000] * (CAPTURE_MEASURE_FRAMES + 1)
+	last   = 0x8000
+	errors = []
+	slips  = 0
+
+	for arrival in frames[CAPTURE_MEASURE_FRAMES + 1:]:
+		while trigger <= arrival:
+			instant = trigger + (ADC_SAMPLE_CYCLES * cycle)
+			level   = 511.5 + (args.amplitude * 511.5 * math.sin(2 * math.pi * args.tone * instant)) + random.gauss(0, args.noise)
+
+			total += clamp(int(math.floor((level / step) + 0.5) * step), 0, 1023)
+			count += 1
+
+			if count == conversions:
+				completed.append((trigger + (CAPTURE_CONVERSION_CYCLES * cycle), total))
+				total = 0
+				count = 0
+
+			slot = (slot + 1) % conversions
+			last_trigger = trigger
+
+			next_period = fraction + period
+			fraction    = next_period & 0xFF
+			trigger    += (next_period >> 8) * tick
+
+		# Capture_Track()
+		triggers = slot if slot else conversions
+		phase    = ((triggers - 1) * (nominal >> 8)) + int((arrival - last_trigger) / tick)
+		error    = phase - target
+
+		if error >= (frame_ticks // 2):
+			error -= frame_ticks
+		elif error < -(frame_ticks // 2):
+			error += frame_ticks
+
+		integrator = clamp(integrator + error, -CAPTURE_LOCK_INTEGRAL_LIMIT, CAPTURE_LOCK_INTEGRAL_LIMIT)
+		period     = (nominal + (integrator >> CAPTURE_LOCK_INTEGRAL_SHIFT) + error) & 0xFFFF
+		errors.append(error * prescale)
+
+		# Capture_Send()
+		ready = None
+		while completed and completed[0][0] <= arrival:
+			ready = completed.pop(0)[1]
+
+		if ready is None:
+			slips += 1
+		else:
+			last = (ready * RECIPROCALS[conversions - 1]) >> CAPTURE_RECIPROCAL_BITS
+
+		output.append(last)
+
+	settled = errors[len(errors) // 2:]
+	return conversions, prescale, output, min(settled), max(settled), slips
+
+def write_wav(name, rate, samples):
+	with wave.open(name, 'wb') as output:
+		output.setnchannels(1)
+		output.setsampwidth(2)
+		output.setframerate(rate)
+		output.writeframes(b''.join(struct.pack('<h', (sample ^ 0x8000) - (0x10000 if sample < 0x8000 else 0)) for sample in samples))
+
+def main():
+	parser = argparse.ArgumentParser(description='Model the receiver\'s microphone capture, writing its output as WAV files.')
+	parser.add_argument('--rates', default='8000,11025,16000,22050,32000,44100,48000', help='comma separated sample rates')
+	parser.add_argument('--noise', type=float, default=0.5, help='RMS input noise in LSBs of the ADC')
+	parser.add_argument('--jitter', type=float, default=3.0, help='peak arrival jitter of the frames in microseconds')
+	parser.add_argument('--clock-error', type=float, default=0.3, help='error of the receiver clock in percent')
+	parser.add_argument('--adc-bits', type=int, default=10, help='effective bits of each conversion, 10 for an ideal ADC')
+	parser.add_argument('--tone', type=float, default=441.7, help='frequency of the input tone in Hz')
+	parser.add_argument('--amplitude', type=float, default=0.95, help='amplitude of the input tone, relative to full scale')
+	parser.add_argument('--seconds', type=float, default=3.0, help='length of each recording')
+	parser.add_argument('--output', default='.', help='directory to write the recordings to')
+	parser.add_argument('--seed', type=int, default=1, help='seed of the noise and jitter')
+	args = parser.parse_args()
+
+	random.seed(args.seed)
+
+	for rate in (int(rate) for rate in args.rates.split(',')):
+		conversions, prescale, samples, low, high, slips = simulate(rate, args)
+		name = os.path.join(args.output, 'capture_%d.wav' % rate)
+
+		write_wav(name, rate, samples)
+		print('%6d Hz: %2d conversions, timer 0 at Fcpu/%d, phase error %d to %d cycles, %d slips -> %s' %
+		      (rate, conversions, prescale, low, high, slips, name))
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,331 @@
+/** \file
+ *
+ *  Host tool to measure the effective number of bits of the microphone capture, from a recording of a pure sine
+ *  tone fed into the receiver's ADC input. A sine is fitted to the recording by least squares, as in IEEE 1057,
+ *  and everything left over once the fit is taken out counts as noise and distortion. The tone should be well
+ *  inside the passband, a few hundred hertz, and just short of the full ADC range, and the recording should
+ *  hold at least a second of it.
+ *
+ *  Usage:
+ *    enob <recording.wav> [frequency]
+ *
+ *  The recording must be 16-bit PCM; only its first channel is used. Without a frequency, the tone is found
+ *  from the recording's zero crossings. For example, to measure the capture at 8KHz on Linux:
+ *    arecord -D hw:CARD=Audio -f S16_LE -r 8000 -c 1 -d 5 tone.wav && enob tone.wav 440
+ *
+ *  Effective bits are given referred to the tone's own amplitude, and referred to full scale, which adds back
+ *  the headroom the tone left unused and is the figure to compare against the resolution of an ideal converter.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Samples skipped at the start of the recording, where the stream and the input's coupling settle. */
+#define SETTLE_SAMPLES          1024
+
+/** Frequency bins of the recording searched either side of the estimated frequency, and the steps per bin of
+ *  the coarse search through them. The residual has a local minimum in every bin, so the coarse search picks
+ *  the right one before it is refined.
+ */
+#define FREQUENCY_SPAN_BINS     4
+#define FREQUENCY_GRID_STEPS    4
+
+/** Steps of the golden section search refining the frequency. */
+#define FREQUENCY_STEPS         40
+
+/** Result of fitting a sine of a fixed frequency to the recording. */
+typedef struct
+{
+	double Amplitude; /**< Peak amplitude of the fitted sine */
+	double Offset; /**< DC offset of the fitted sine */
+	double Residual; /**< RMS of the recording less the fitted sine */
+} SineFit_t;
+
+static uint32_t ReadLE(const uint8_t* Data,
+                       const int Bytes)
+{
+	uint32_t Value = 0;
+
+	for (int i = (Bytes - 1); i >= 0; i--)
+	  Value = ((Value << 8) | Data[i]);
+
+	return Value;
+}
+
+/** Loads the first channel of a 16-bit PCM WAV file.
+ *
+ *  \param[in]  FileName    Name of the file to load.
+ *  \param[out] Samples     Allocated array of the samples, normalized to +/-1.
+ *  \param[out] SampleRate  Sample rate of the recording in Hz.
+ *
+ *  \return Number of samples loaded, or -1 on error
+ */
+static long LoadWav(const char* FileName,
+                    double** Samples,
+                    uint32_t* SampleRate)
+{
+	FILE*    File = fopen(FileName, "rb");
+	uint8_t  Header[12];
+	uint8_t  Chunk[8];
+	uint16_t Channels = 0;
+	uint16_t Bits     = 0;
+
+	if (!(File))
+	{
+		perror(FileName);
+		return -1;
+	}
+
+	if ((fread(Header, 1, sizeof(Header), File) != sizeof(Header)) || memcmp(Header, "RIFF", 4) || memcmp(&Header[8], "WAVE", 4))
+	{
+		fprintf(stderr, "%s is not a WAV file\n", FileName);
+		fclose(File);
+		return -1;
+	}
+
+	while (fread(Chunk, 1, sizeof(Chunk), File) == sizeof(Chunk))
+	{
+		uint32_t Size = ReadLE(&Chunk[4], 4);
+
+		if (!(memcmp(Chunk, "fmt ", 4)))
+		{
+			uint8_t Format[16];
+
+			if ((Size < sizeof(Format)) || (fread(Format, 1, sizeof(Format), File) != sizeof(Format)))
+			  break;
+
+			Channels    = ReadLE(&Format[2], 2);
+			*SampleRate = ReadLE(&Format[4], 4);
+			Bits        = ReadLE(&Format[14], 2);
+
+			if ((ReadLE(&Format[0], 2) != 1) || (Bits != 16) || !(Channels))
+			{
+				fprintf(stderr, "%s is not 16-bit PCM\n", FileName);
+				break;
+			}
+
+			fseek(File, (Size - sizeof(Format) + (Size & 1)), SEEK_CUR);
+		}
+		else if (!(memcmp(Chunk, "data", 4)) && (Bits == 16))
+		{
+			long     Count = (Size / (2 * Channels));
+			int16_t* Frame = malloc(2 * Channels);
+
+			*Samples = malloc(Count * sizeof(double));
+
+			for (long i = 0; i < Count; i++)
+			{
+				if (fread(Frame, 2, Channels, File) != Channels)
+				{
+					Count = i;
+					break;
+				}
+
+				(*Samples)[i] = (Frame[0] / 32768.0);
+			}
+
+			free(Frame);
+			fclose(File);
+			return Count;
+		}
+		else
+		{
+			fseek(File, (Size + (Size & 1)), SEEK_CUR);
+		}
+	}
+
+	fprintf(stderr, "no 16-bit PCM data in %s\n", FileName);
+	fclose(File);
+	return -1;
+}
+
+/** Fits a sine of the given frequency, with any phase and offset, to the samples by linear least squares.
+ *
+ *  \param[in] Samples    Samples to fit.
+ *  \param[in] Count      Number of samples.
+ *  \param[in] Frequency  Frequency of the sine in cycles per sample.
+ *
+ *  \return Amplitude, offset and residual of the fit.
+ */
+static SineFit_t FitSine(const double* Samples,
+                         const long Count,
+                         const double Frequency)
+{
+	/* Normal equations for x = a cos(wn) + b sin(wn) + c */
+	double M[3][4] = {{0}};
+
+	for (long n = 0; n < Count; n++)
+	{
+		double Basis[3] = {cos(2 * M_PI * Frequency * n), sin(2 * M_PI * Frequency * n), 1};
+
+		for (int Row = 0; Row < 3; Row++)
+		{
+			for (int Column = 0; Column < 3; Column++)
+			  M[Row][Column] += (Basis[Row] * Basis[Column]);
+
+			M[Row][3] += (Basis[Row] * Samples[n]);
+		}
+	}
+
+	for (int Pivot = 0; Pivot < 3; Pivot++)
+	{
+		for (int Row = 0; Row < 3; Row++)
+		{
+			if (Row == Pivot)
+			  continue;
+
+			double Factor = (M[Row][Pivot] / M[Pivot][Pivot]);
+
+			for (int Column = Pivot; Column < 4; Column++)
+			  M[Row][Column] -= (Factor * M[Pivot][Column]);
+		}
+	}
+
+	double A = (M[0][3] / M[0][0]);
+	double B = (M[1][3] / M[1][1]);
+	double C = (M[2][3] / M[2][2]);
+	double Sum = 0;
+
+	for (long n = 0; n < Count; n++)
+	{
+		double Error = (Samples[n] - ((A * cos(2 * M_PI * Frequency * n)) + (B * sin(2 * M_PI * Frequency * n)) + C));
+
+		Sum += (Error * Error);
+	}
+
+	return (SineFit_t){.Amplitude = sqrt((A * A) + (B * B)), .Offset = C, .Residual = sqrt(Sum / Count)};
+}
+
+/** Estimates the frequency of the tone from the rising zero crossings of the recording, about its mean.
+ *
+ *  \return Frequency in cycles per sample, or zero if the recording holds no tone
+ */
+static double EstimateFrequency(const double* Samples,
+                                const long Count)
+{
+	double Mean  = 0;
+	long   First = -1;
+	long   Last  = -1;
+	long   Crossings = 0;
+
+	for (long n = 0; n < Count; n++)
+	  Mean += Samples[n];
+
+	Mean /= Count;
+
+	for (long n = 1; n < Count; n++)
+	{
+		if ((Samples[n - 1] < Mean) && (Samples[n] >= Mean))
+		{
+			if (First < 0)
+			  First = n;
+			else
+			  Crossings++;
+
+			Last = n;
+		}
+	}
+
+	return Crossings ? ((double)Crossings / (Last - First)) : 0;
+}
+
+int main(int argc,
+         char* argv[])
+{
+	double*  Samples;
+	uint32_t SampleRate = 0;
+	long     Count;
+
+	if ((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "usage: %s recording.wav [frequency]\n", argv[0]);
+		return 1;
+	}
+
+	if ((Count = LoadWav(argv[1], &Samples, &SampleRate)) < 0)
+	  return 1;
+
+	if (Count < (SETTLE_SAMPLES * 2))
+	{
+		fprintf(stderr, "recording is too short, it needs at least %d samples\n", (SETTLE_SAMPLES * 2));
+		return 1;
+	}
+
+	double* Signal    = &Samples[SETTLE_SAMPLES];
+	long    Length    = (Count - SETTLE_SAMPLES);
+	double  Frequency = (argc == 3) ? (atof(argv[2]) / SampleRate) : EstimateFrequency(Signal, Length);
+
+	if ((Frequency <= 0) || (Frequency >= 0.5))
+	{
+		fprintf(stderr, "no tone found below the Nyquist frequency\n");
+		return 1;
+	}
+
+	/* Refine the frequency, as the tone's generator and the device's sample clock never quite agree on it: first
+	 * on a grid around the estimate, then by a golden section search on the residual around the best grid point */
+	const double Ratio = ((sqrt(5) - 1) / 2);
+	const double Step  = (1.0 / (Length * FREQUENCY_GRID_STEPS));
+
+	double Best         = Frequency;
+	double BestResidual = FitSine(Signal, Length, Frequency).Residual;
+
+	for (int i = -(FREQUENCY_SPAN_BINS * FREQUENCY_GRID_STEPS); i <= (FREQUENCY_SPAN_BINS * FREQUENCY_GRID_STEPS); i++)
+	{
+		double Residual = FitSine(Signal, Length, (Frequency + (i * Step))).Residual;
+
+		if (Residual < BestResidual)
+		{
+			Best         = (Frequency + (i * Step));
+			BestResidual = Residual;
+		}
+	}
+
+	double Low  = (Best - Step);
+	double High = (Best + Step);
+	double X1   = (High - (Ratio * (High - Low)));
+	double X2   = (Low  + (Ratio * (High - Low)));
+	double R1   = FitSine(Signal, Length, X1).Residual;
+	double R2   = FitSine(Signal, Length, X2).Residual;
+
+	for (int i = 0; i < FREQUENCY_STEPS; i++)
+	{
+		if (R1 < R2)
+		{
+			High = X2; X2 = X1; R2 = R1;
+			X1   = (High - (Ratio * (High - Low)));
+			R1   = FitSine(Signal, Length, X1).Residual;
+		}
+		else
+		{
+			Low  = X1; X1 = X2; R1 = R2;
+			X2   = (Low + (Ratio * (High - Low)));
+			R2   = FitSine(Signal, Length, X2).Residual;
+		}
+	}
+
+	Frequency = ((Low + High) / 2);
+
+	SineFit_t Fit = FitSine(Signal, Length, Frequency);
+
+	if (!(Fit.Residual > 0))
+	{
+		fprintf(stderr, "recording holds no noise to measure\n");
+		return 1;
+	}
+
+	/* SINAD of the tone, and effective bits by the quantization noise of an ideal converter, 6.02N + 1.76dB */
+	double Sinad      = (20 * log10((Fit.Amplitude / sqrt(2)) / Fit.Residual));
+	double Enob       = ((Sinad - 1.76) / 6.02);
+	double Headroom   = (20 * log10(1.0 / Fit.Amplitude));
+	double EnobFull   = ((Sinad + Headroom - 1.76) / 6.02);
+
+	printf("rate=%u samples=%ld tone=%.2fHz amplitude=%.1fdBFS offset=%.0f\n", SampleRate, Length,
+	       (Frequency * SampleRate), -Headroom, (Fit.Offset * 32768));
+	printf("sinad=%.2fdB enob=%.2f bits (%.2f bits referred to full scale)\n", Sinad, Enob, EnobFull);
+
+	free(Samples);
+	return 0;
+}
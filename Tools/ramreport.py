@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+#
+# Static RAM and worst case stack report for the ArduinoAudio firmware.
+#
+# Reads the linked ELF image and prints the static RAM use (.data, .bss and .noinit, with the audio arena and
+# the largest other objects broken out), and the worst case stack depth of main() with the deepest possible
+# nesting of interrupt handlers on top. Stack depths come from a call graph built from the disassembly, with
+# each function's frame taken from its pushes and frame pointer adjustment, so assembly and library routines
+# are covered too. Exits with a failure, failing the build, if fewer than --headroom bytes of RAM would be left
+# free in the worst case, or if the stack depth cannot be bounded.
+#
+# Also reports the estimated cycle cost of the DSP chain compiled into the image, which Dsp.c publishes as the
+# absolute symbols __dsp_cycles_mono, __dsp_cycles_stereo and __dsp_cycle_budget. A chain over the budget has
+# already failed the build at compile time; a stereo chain over it is cut back when the link is negotiated.
+#
+# With --fixed-registers, for images built with the hand-written sample ISR, also fails if any code outside the
+# interrupt vectors touches r2 to r5, which SampleISR.S keeps its state in. Every compilation unit of the firmware
+# is built with them reserved, so this catches avr-libc and libgcc routines, which are not; the only use allowed is
+# the plain move in and out of r3 of the ring tail accessors in SampleRing.h.
+#
+# Usage: ramreport.py [--ram BYTES] [--headroom BYTES] [--cross PREFIX] [--fixed-registers] firmware.elf
+
+import argparse
+import re
+import subprocess
+import sys
+
+FUNCTION_RE = re.compile(r'^[0-9a-f]+ <([^>]+)>:$')
+CALL_RE     = re.compile(r'\b(r?call|r?jmp)\s+[^;]*;\s*0x[0-9a-f]+ <([^>+]+)>$')
+FRAME_RE    = re.compile(r'\b(sbiw|subi)\s+r28,\s*(0x[0-9a-fA-F]+|\d+)')
+ISR_RE      = re.compile(r'^__vector_')
+FIXED_RE    = re.compile(r'\br([2-5])\b')
+
+def run(tool, *args):
+	return subprocess.run([tool] + list(args), check=True, capture_output=True, text=True).stdout
+
+def section_sizes(cross, elf):
+	sizes = {}
+	for line in run(cross + 'size', '-A', elf).splitlines():
+		fields = line.split()
+		if len(fields) >= 2 and fields[0] in ('.data', '.bss', '.noinit'):
+			sizes[fields[0]] = int(fields[1])
+	return sizes
+
+def ram_symbols(cross, elf):
+	symbols = []
+	for line in run(cross + 'nm', '-S', '--size-sort', elf).splitlines():
+		fields = line.split()
+		if len(fields) == 4 and fields[2] in 'bBdD':
+			symbols.append((fields[3], int(fields[1], 16)))
+	return symbols
+
+def absolute_symbols(cross, elf):
+	symbols = {}
+	for line in run(cross + 'nm', elf).splitlines():
+		fields = line.split()
+		if len(fields) == 3 and fields[1] in 'aA':
+			symbols[fields[2]] = int(fields[0], 16)
+	return symbols
+
+def call_graph(cross, elf):
+	frames  = {}
+	callees = {}
+	nesting = set()
+	vectors = set()
+	fixed   = {}
+	current = None
+	frame_pointer = False
+
+	for line in run(cross + 'objdump', '-d', '--no-show-raw-insn', elf).splitlines():
+		match = FUNCTION_RE.match(line)
+		if match:
+			current = match.group(1)
+			frames[current]  = 0
+			callees[current] = []
+			frame_pointer    = False
+			continue
+
+		if current is None or ':' not in line:
+			continue
+
+		insn = line.split(':', 1)[1].strip()
+
+		# Operands only, as the comment objdump appends may name addresses which look like registers
+		registers = set(FIXED_RE.findall(insn.split(';', 1)[0]))
+		if registers and not (registers == {'3'} and re.match(r'mov\s', insn)):
+			fixed.setdefault(current, insn)
+
+		if insn.startswith('push'):
+			frames[current] += 1
+		elif re.match(r'rcall\s+\.\+0', insn):
+			# Allocates a two byte frame by pushing a dummy return address
+			frames[current] += 2
+		elif insn.startswith('sei'):
+			nesting.add(current)
+		elif re.match(r'e?icall|e?ijmp', insn):
+			callees[current].append((None, True))
+		elif re.match(r'in\s+r28,\s*0x3d', insn):
+			frame_pointer = True
+		else:
+			match = FRAME_RE.search(insn)
+			if match and frame_pointer:
+				# Frame allocated below the pushed registers, once the stack pointer is loaded into Y
+				frames[current] += int(match.group(2), 0)
+				frame_pointer = False
+
+			match = CALL_RE.search(insn)
+			if match and current == '__vectors':
+				if ISR_RE.match(match.group(2)):
+					vectors.add(match.group(2))
+			elif match and match.group(2) != current:
+				callees[current].append((match.group(2), match.group(1).endswith('call')))
+
+	return frames, callees, nesting, vectors, fixed
+
+def reachable(function, callees):
+	seen    = set()
+	pending = [function]
+	while pending:
+		current = pending.pop()
+		if current in seen:
+			continue
+		seen.add(current)
+		pending.extend(callee for callee, _ in callees.get(current, []) if callee is not None)
+	return seen
+
+def stack_depth(function, frames, callees, path=()):
+	if function in path:
+		raise ValueError('recursion through ' + ' -> '.join(path + (function,)))
+
+	deepest = 0
+	for callee, is_call in callees.get(function, []):
+		if callee is None:
+			raise ValueError('indirect call in ' + function)
+		if callee not in frames:
+			continue
+
+		depth = stack_depth(callee, frames, callees, path + (function,)) + (2 if is_call else 0)
+		deepest = max(deepest, depth)
+
+	return frames.get(function, 0) + deepest
+
+def main():
+	parser = argparse.ArgumentParser(description='Report static RAM and worst case stack use of a firmware image.')
+	parser.add_argument('elf')
+	parser.add_argument('--ram', type=int, default=512, help='internal SRAM size in bytes')
+	parser.add_argument('--headroom', type=int, default=32, help='minimum bytes to leave free in the worst case')
+	parser.add_argument('--cross', default='avr-', help='binutils tool prefix')
+	parser.add_argument('--fixed-registers', action='store_true',
+	                    help='fail if code outside the interrupt vectors uses r2 to r5')
+	args = parser.parse_args()
+
+	sizes   = section_sizes(args.cross, args.elf)
+	static  = sum(sizes.values())
+	symbols = ram_symbols(args.cross, args.elf)
+
+	print('Static RAM: %d of %d bytes (%s)' % (static, args.ram,
+	      ', '.join('%s %d' % (name, size) for name, size in sorted(sizes.items()))))
+	for name, size in reversed(symbols[-8:]):
+		print('  %5d  %s' % (size, name))
+
+	dsp = absolute_symbols(args.cross, args.elf)
+	if '__dsp_cycle_budget' in dsp:
+		print('DSP chain: %d cycles per mono frame, %d per stereo frame (budget %d per frame at the highest rate)' %
+		      (dsp['__dsp_cycles_mono'], dsp['__dsp_cycles_stereo'], dsp['__dsp_cycle_budget']))
+
+	frames, callees, nesting, vectors, fixed = call_graph(args.cross, args.elf)
+
+	# A handler re-enables interrupts if it, or anything it calls, does; library event hooks run inside the vector
+	nesting = {vector for vector in vectors if reachable(vector, callees) & nesting}
+
+	if args.fixed_registers:
+		offenders = sorted(function for function in fixed if function not in vectors)
+		for function in offenders:
+			print('Reserved register used in %s: %s' % (function, fixed[function]))
+		if offenders:
+			print('r2 to r5 are reserved for the sample ISR; a routine linked in uses them')
+			return 1
+		print('Reserved registers: r2 to r5 untouched outside the interrupt vectors')
+
+	try:
+		# Including the return address pushed by the C runtime's call to main()
+		main_depth = stack_depth('main', frames, callees) + 2
+		isr_depths = {vector: stack_depth(vector, frames, callees) + 2 for vector in vectors}
+	except ValueError as error:
+		print('Stack depth cannot be bounded: %s' % error)
+		return 1
+
+	# Handlers that re-enable interrupts can each be interrupted once by every other handler; otherwise only
+	# the deepest single handler can be on the stack on top of main()
+	if nesting:
+		isr_total = sum(isr_depths.values())
+	else:
+		isr_total = max(isr_depths.values(), default=0)
+
+	print('Worst case stack: %d bytes (main %d, interrupts %d%s)' % (main_depth + isr_total, main_depth, isr_total,
+	      ', nested through ' + ', '.join(sorted(nesting)) if nesting else ''))
+	for vector, depth in sorted(isr_depths.items(), key=lambda item: -item[1]):
+		print('  %5d  %s' % (depth, vector))
+
+	free = args.ram - static - main_depth - isr_total
+	print('Worst case free RAM: %d bytes (headroom required %d)' % (free, args.headroom))
+
+	if free < args.headroom:
+		print('RAM headroom violated; reduce SAMPLE_RING_SIZE or AUDIO_ARENA_SIZE in Config/AppConfig.h')
+		return 1
+
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,84 @@
+/** \file
+ *
+ *  Event trace, recording the time of each USB start of frame, batch of frames taken from the streaming endpoint,
+ *  underrun, dropped link frame, sampling frequency change and alternate setting switch into a small ring in
+ *  SRAM, so that a dropout can be placed against what the host was doing at the time. Times are taken from the
+ *  free-running Timer 1 of the sample clock, relative to the last start of frame, together with a count of start
+ *  of frames since reset. The buffer is read and emptied with \ref VENDOR_REQ_GetTrace; Tools/audiotrace turns
+ *  the result into a timeline.
+ *
+ *  The trace is only compiled in when \c TRACE_EVENTS is defined, as the buffer takes six bytes of SRAM for
+ *  each entry.
+ */
+
+#include "Trace.h"
+
+#if defined(TRACE_EVENTS)
+
+/** Trace buffer, holding the trace state followed by the most recent events. */
+TraceBuffer_t     Trace_Buffer = {.Status = {.Capacity = TRACE_EVENTS}};
+
+/** Number of USB start of frames since reset, the coarse part of each timestamp. */
+volatile uint16_t Trace_Frame;
+
+/** Mask of \c (1 << TRACE_EVENT_*) flags of the events being recorded. */
+uint8_t           Trace_Mask = TRACE_DEFAULT_MASK;
+
+/** Mask of \c (1 << TRACE_EVENT_*) flags of the events which trigger the trace. */
+uint8_t           Trace_TriggerMask;
+
+/** Number of events still to be recorded after a trigger event, before recording stops. */
+uint8_t           Trace_Remaining;
+
+/** Indicates if the trace buffer is being sent to the host, and must not change. */
+volatile bool     Trace_Frozen;
+
+/** Number of events missed while the trace buffer was frozen, carried into the next read. */
+uint8_t           Trace_FrozenLost;
+
+/** Selects the events to record and the events that trigger the trace, and empties the trace buffer.
+ *
+ *  \param[in] Mask         Mask of \c (1 << TRACE_EVENT_*) flags of the events to record.
+ *  \param[in] TriggerMask  Mask of \c (1 << TRACE_EVENT_*) flags of the events which stop recording once
+ *                          half of the trace buffer has been filled after them, or zero to record continuously.
+ */
+void Trace_Configure(const uint8_t Mask,
+                     const uint8_t TriggerMask)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Trace_Mask        = Mask;
+		Trace_TriggerMask = (TriggerMask & Mask);
+	}
+
+	Trace_Clear();
+}
+
+/** Stops recording and timestamps the trace buffer, so that it can be sent to the host as it stands. Events
+ *  occurring until the next call to \ref Trace_Clear() are counted as lost.
+ */
+void Trace_Freeze(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Trace_Buffer.Status.Frame  = Trace_Frame;
+		Trace_Buffer.Status.Cycles = (TCNT1 - AudioArena.Clock.LastCount);
+		Trace_Frozen = true;
+	}
+}
+
+/** Empties the trace buffer and re-arms the trigger, resuming recording. */
+void Trace_Clear(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Trace_Buffer.Status.Count = 0;
+		Trace_Buffer.Status.Lost  = Trace_FrozenLost;
+		Trace_Buffer.Status.Flags = 0;
+
+		Trace_Frozen     = false;
+		Trace_FrozenLost = 0;
+	}
+}
+
+#endif
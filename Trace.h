@@ -0,0 +1,133 @@
+/** \file
+ *
+ *  Header file for Trace.c.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+		#include <util/atomic.h>
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Arena.h"
+		#include "VendorProtocol.h"
+		#include "Config/AppConfig.h"
+
+	/* Preprocessor Checks: */
+		#if defined(TRACE_EVENTS) && ((TRACE_EVENTS < 2) || (TRACE_EVENTS > 32))
+			#error TRACE_EVENTS must be between 2 and 32, as at six bytes each a larger trace buffer would not fit the SRAM left beside the audio arena.
+		#endif
+
+	/* Macros: */
+		/** Mask of the events traced after reset: everything but the start of frames and packets, which
+		 *  would otherwise fill the buffer every few milliseconds.
+		 */
+		#define TRACE_DEFAULT_MASK           ((1 << TRACE_EVENT_Underrun) | (1 << TRACE_EVENT_LinkDrop) | \
+		                                      (1 << TRACE_EVENT_RateChange) | (1 << TRACE_EVENT_AltSetting))
+
+	#if defined(TRACE_EVENTS) || defined(__DOXYGEN__)
+		/* Type Defines: */
+			/** Type define for the trace buffer, laid out as the \ref VENDOR_REQ_GetTrace reply so that it can be
+			 *  sent as it stands.
+			 */
+			typedef struct
+			{
+				TraceStatus_t Status; /**< Trace buffer state */
+				TraceEvent_t  Events[TRACE_EVENTS]; /**< Trace entries, written in turn and wrapping around */
+			} __attribute__((packed)) TraceBuffer_t;
+
+		/* External Variables: */
+			extern TraceBuffer_t     Trace_Buffer;
+			extern volatile uint16_t Trace_Frame;
+			extern uint8_t           Trace_Mask;
+			extern uint8_t           Trace_TriggerMask;
+			extern uint8_t           Trace_Remaining;
+			extern volatile bool     Trace_Frozen;
+			extern uint8_t           Trace_FrozenLost;
+	#endif
+
+	/* Inline Functions: */
+		/** Records an event into the trace buffer, timestamped against the last USB start of frame, if the event
+		 *  is being traced. Once a trigger event has been recorded, recording stops when another half of the
+		 *  buffer has been filled. This may be called from any context, including the sample ISR.
+		 *
+		 *  \param[in] Event  Event to record, a value from \ref TraceEvents_t.
+		 *  \param[in] Data   Event specific data.
+		 */
+		static inline void Trace_Record(const uint8_t Event,
+		                                const uint8_t Data)
+		{
+			#if defined(TRACE_EVENTS)
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				TraceStatus_t* Status = &Trace_Buffer.Status;
+
+				if (!(Trace_Mask & (1 << Event)) || (Status->Flags & TRACE_FLAG_STOPPED))
+				  return;
+
+				/* The buffer is being sent to the host, so just count the event as lost */
+				if (Trace_Frozen)
+				{
+					if (Trace_FrozenLost != UINT8_MAX)
+					  Trace_FrozenLost++;
+
+					return;
+				}
+
+				TraceEvent_t* Entry = &Trace_Buffer.Events[Status->Next];
+
+				Entry->Event  = Event;
+				Entry->Data   = Data;
+				Entry->Frame  = Trace_Frame;
+				Entry->Cycles = (TCNT1 - AudioArena.Clock.LastCount);
+
+				if (++Status->Next == TRACE_EVENTS)
+				  Status->Next = 0;
+
+				if (Status->Count < TRACE_EVENTS)
+				  Status->Count++;
+				else if (Status->Lost != UINT8_MAX)
+				  Status->Lost++;
+
+				if (Status->Flags & TRACE_FLAG_TRIGGERED)
+				{
+					if (!(--Trace_Remaining))
+					  Status->Flags |= TRACE_FLAG_STOPPED;
+				}
+				else if (Trace_TriggerMask & (1 << Event))
+				{
+					Status->Flags  |= TRACE_FLAG_TRIGGERED;
+					Trace_Remaining = (TRACE_EVENTS / 2);
+				}
+			}
+			#endif
+		}
+
+		/** Advances the trace time to a new USB start of frame, and records it. This must be called from the main
+		 *  loop, after \c Clock_StartOfFrame() has timestamped the frame; the event is timestamped when the main
+		 *  loop gets to it, which shows how long the frame waited.
+		 *
+		 *  \param[in] Frames  Number of start of frames since the last call.
+		 */
+		static inline void Trace_StartOfFrame(const uint8_t Frames)
+		{
+			#if defined(TRACE_EVENTS)
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				Trace_Frame += Frames;
+			}
+
+			Trace_Record(TRACE_EVENT_StartOfFrame, UDFNUML);
+			#endif
+		}
+
+	/* Function Prototypes: */
+		void Trace_Configure(const uint8_t Mask,
+		                     const uint8_t TriggerMask);
+		void Trace_Freeze(void);
+		void Trace_Clear(void);
+
+#endif
@@ -0,0 +1,176 @@
+/** \file
+ *
+ *  Handler for the vendor specific control requests described in VendorProtocol.h, used by the host tools to
+ *  configure and inspect the device without reflashing it.
+ */
+
+#include "Vendor.h"
+
+/** Processes a vendor specific control request addressed to the device, if one has been received. This should
+ *  be called from the library USB Control Request reception event.
+ */
+void Vendor_ProcessControlRequest(void)
+{
+	if (!(Endpoint_IsSETUPReceived()))
+	  return;
+
+	if ((USB_ControlRequest.bmRequestType & (CONTROL_REQTYPE_TYPE | CONTROL_REQTYPE_RECIPIENT)) != (REQTYPE_VENDOR | REQREC_DEVICE))
+	  return;
+
+	switch (USB_ControlRequest.bRequest)
+	{
+		case VENDOR_REQ_GetSettings:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				AppSettings_t Settings[2] = {Settings_Active, Settings_Pending};
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(Settings, MIN(sizeof(Settings), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+
+			break;
+		case VENDOR_REQ_SetSettings:
+			if (!(USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST) && (USB_ControlRequest.wLength == sizeof(AppSettings_t)))
+			{
+				AppSettings_t Settings;
+
+				Endpoint_ClearSETUP();
+				Endpoint_Read_Control_Stream_LE(&Settings, sizeof(AppSettings_t));
+
+				/* Reject settings this firmware can't apply by stalling the status stage */
+				if (!(Settings_Validate(&Settings)))
+				{
+					Endpoint_StallTransaction();
+					break;
+				}
+
+				Endpoint_ClearIN();
+
+				Settings_Pending = Settings;
+				Settings_Save();
+			}
+
+			break;
+		case VENDOR_REQ_ResetSettings:
+			if (!(USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST))
+			{
+				Endpoint_ClearSETUP();
+				Endpoint_ClearStatusStage();
+
+				Settings_LoadDefaults(&Settings_Pending);
+				Settings_Save();
+			}
+
+			break;
+		case VENDOR_REQ_GetLinkStatus:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				LinkStatus_t LinkStatus =
+					{
+						.Negotiated  = Link_Negotiated,
+						.LinkBaud    = Link_Baud,
+						.LinkFormat  = Link_Format,
+						.ProbeResult = Link_ProbeResult,
+						.MaxBaud     = Link_MaxBaud,
+						.ProbeErrors = Link_ProbeErrors,
+						.Drops       = Link_GetDrops(),
+					};
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&LinkStatus, MIN(sizeof(LinkStatus), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+
+			break;
+		case VENDOR_REQ_GetClockStatus:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				ClockStatus_t ClockStatus =
+					{
+						#if defined(SAMPLE_CLOCK_SOF_SYNC)
+						.SyncMode      = CLOCK_SYNC_SOF,
+						#else
+						.SyncMode      = CLOCK_SYNC_FreeRunning,
+						#endif
+						.Locked        = Clock_Locked,
+						.DriftCentiPPM = Clock_DriftCentiPPM,
+					};
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&ClockStatus, MIN(sizeof(ClockStatus), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+
+			break;
+		case VENDOR_REQ_GetBufferStatus:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				BufferStatus_t BufferStatus;
+
+				Jitter_GetStatus(&BufferStatus);
+				BufferStatus.Concealments = Conceal_GetEvents();
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&BufferStatus, MIN(sizeof(BufferStatus), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+
+			break;
+
+		#if defined(TRACE_EVENTS)
+		case VENDOR_REQ_GetTrace:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				/* Send the buffer in place, with recording held off until it has gone */
+				Trace_Freeze();
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Trace_Buffer, MIN(sizeof(Trace_Buffer), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+
+				Trace_Clear();
+			}
+
+			break;
+		case VENDOR_REQ_SetTrace:
+			if (!(USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST))
+			{
+				Endpoint_ClearSETUP();
+				Endpoint_ClearStatusStage();
+
+				Trace_Configure(USB_ControlRequest.wValue, USB_ControlRequest.wIndex);
+			}
+
+			break;
+		#endif
+
+		#if defined(EMISSION_HISTOGRAM_BINS)
+		case VENDOR_REQ_GetEmission:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				/* Send the histogram in place, with recording held off until it has gone */
+				Emission_Freeze();
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Emission_Histogram, MIN(sizeof(Emission_Histogram), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+
+				Emission_Release(USB_ControlRequest.wValue != 0);
+			}
+
+			break;
+		#endif
+
+		#if defined(VENDOR_STREAM)
+		case VENDOR_REQ_SetStreamRate:
+			if (!(USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST) && VendorStream_SetRate(USB_ControlRequest.wValue))
+			{
+				Endpoint_ClearSETUP();
+				Endpoint_ClearStatusStage();
+			}
+
+			break;
+		#endif
+	}
+}
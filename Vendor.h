@@ -0,0 +1,25 @@
+/** \file
+ *
+ *  Header file for Vendor.c.
+ */
+
+#ifndef _VENDOR_H_
+#define _VENDOR_H_
+
+	/* Includes: */
+		#include <LUFA/Drivers/USB/USB.h>
+
+		#include "VendorProtocol.h"
+		#include "Clock.h"
+		#include "Conceal.h"
+		#include "Emission.h"
+		#include "Jitter.h"
+		#include "Settings.h"
+		#include "Link.h"
+		#include "Trace.h"
+		#include "VendorStream.h"
+
+	/* Function Prototypes: */
+		void Vendor_ProcessControlRequest(void);
+
+#endif
@@ -0,0 +1,240 @@
+/** \file
+ *
+ *  Definitions shared by the ATMEGA16U2 firmware and the host tools, describing the vendor specific control
+ *  requests used to configure and inspect the device at runtime. All requests are sent to the device
+ *  recipient with a vendor request type, and all multi-byte fields are little endian. The alternate settings of
+ *  the speaker stream are listed here too, as the trace reports them.
+ */
+
+#ifndef _VENDOR_PROTOCOL_H_
+#define _VENDOR_PROTOCOL_H_
+
+	/* Includes: */
+		#include <stdint.h>
+
+	/* Macros: */
+		/** Version of the \ref AppSettings_t layout, stored alongside the settings in EEPROM. */
+		#define SETTINGS_VERSION          2
+
+		/** DSP stage flag, indicating the DC blocking high-pass filter. */
+		#define DSP_STAGE_DC_BLOCK        (1 << 0)
+
+		/** DSP stage flag, indicating the first output compensation biquad. */
+		#define DSP_STAGE_BIQUAD1         (1 << 1)
+
+		/** DSP stage flag, indicating the second output compensation biquad. */
+		#define DSP_STAGE_BIQUAD2         (1 << 2)
+
+		/** DSP stage flag, indicating the peak limiter. */
+		#define DSP_STAGE_LIMITER         (1 << 3)
+
+		/** Mask of all DSP stage flags. */
+		#define DSP_STAGE_MASK            (DSP_STAGE_DC_BLOCK | DSP_STAGE_BIQUAD1 | DSP_STAGE_BIQUAD2 | DSP_STAGE_LIMITER)
+
+		/** Trace status flag, indicating that a trigger event has been recorded. */
+		#define TRACE_FLAG_TRIGGERED      (1 << 0)
+
+		/** Trace status flag, indicating that recording stopped once the trigger event was halfway back through
+		 *  the trace buffer, so that the buffer holds the events either side of it.
+		 */
+		#define TRACE_FLAG_STOPPED        (1 << 1)
+
+		/** Number of channels in each level report, the most the link carries. */
+		#define LEVEL_REPORT_CHANNELS     2
+
+		/** Level report flag, indicating that the link carries two channels, so that the second is valid. */
+		#define LEVEL_FLAG_STEREO         (1 << 0)
+
+		/** Level report flag, indicating that the output reduces the samples, to 8 bits over the link or to the
+		 *  R-2R ladder's resolution, so that the levels after the reduction are valid.
+		 */
+		#define LEVEL_FLAG_REDUCED        (1 << 1)
+
+	/* Enums: */
+		/** Enum for the vendor specific control requests understood by the device. */
+		enum VendorRequests_t
+		{
+			VENDOR_REQ_GetSettings        = 0x01, /**< Reads the active settings followed by the pending settings,
+			                                       *   as two \ref AppSettings_t structures.
+			                                       */
+			VENDOR_REQ_SetSettings        = 0x02, /**< Writes a \ref AppSettings_t structure as the pending settings,
+			                                       *   which are saved to EEPROM while no stream is open and
+			                                       *   applied at the next stream start.
+			                                       */
+			VENDOR_REQ_ResetSettings      = 0x03, /**< Restores the compile time default settings as the pending settings. */
+			VENDOR_REQ_GetLinkStatus      = 0x04, /**< Reads the current state of the serial link as a \ref LinkStatus_t. */
+			VENDOR_REQ_GetClockStatus     = 0x05, /**< Reads the sample clock synchronisation state as a \ref ClockStatus_t. */
+			VENDOR_REQ_GetTrace           = 0x06, /**< Reads the event trace as a \ref TraceStatus_t followed by the
+			                                       *   trace buffer of \ref TraceEvent_t entries, then empties the
+			                                       *   buffer and re-arms the trigger. Stalled if the firmware was
+			                                       *   built without \c TRACE_EVENTS.
+			                                       */
+			VENDOR_REQ_SetTrace           = 0x07, /**< Selects the traced events from the mask of \c (1 << TRACE_EVENT_*)
+			                                       *   flags in \c wValue, and the events which trigger the trace from
+			                                       *   the mask in \c wIndex, with no data stage.
+			                                       */
+			VENDOR_REQ_GetBufferStatus    = 0x08, /**< Reads the state of the jitter buffer as a \ref BufferStatus_t. */
+			VENDOR_REQ_GetEmission        = 0x09, /**< Reads the histogram of the intervals between sample emissions as
+			                                       *   an \ref EmissionStatus_t followed by a 16-bit count for each bin,
+			                                       *   then empties it if \c wValue is non-zero. Stalled if the firmware
+			                                       *   was built without \c EMISSION_HISTOGRAM_BINS.
+			                                       */
+			VENDOR_REQ_SetStreamRate      = 0x0A, /**< Sets the sample rate in Hz of the vendor stream interface from
+			                                       *   \c wValue, with no data stage, taking effect when the stream
+			                                       *   next opens. Stalled for rates outside 8kHz to the firmware's
+			                                       *   \c AUDIO_MAX_SAMPLE_RATE, rates the probed link cannot carry, or
+			                                       *   if the firmware was built without \c VENDOR_STREAM.
+			                                       */
+		};
+
+		/** Enum for the events recorded in the event trace. */
+		enum TraceEvents_t
+		{
+			TRACE_EVENT_StartOfFrame      = 0, /**< USB start of frame; data is the low byte of the USB frame number */
+			TRACE_EVENT_Packet            = 1, /**< Sample frames taken from the streaming endpoint by one pass of the
+			                                    *   main loop, which may be part of a packet or span several; data is
+			                                    *   the number of sample frames
+			                                    */
+			TRACE_EVENT_Underrun          = 2, /**< Sample ring underrun in the sample ISR */
+			TRACE_EVENT_LinkDrop          = 3, /**< Sample frame dropped, with the link USART still busy */
+			TRACE_EVENT_RateChange        = 4, /**< Sampling frequency set by the host; data is the rate in kHz */
+			TRACE_EVENT_AltSetting        = 5, /**< Streaming interface switched; data is the interface number in the
+			                                    *   upper nibble, and the alternate setting in the lower nibble
+			                                    */
+		};
+
+		/** Enum for the alternate settings of the speaker streaming interface, as reported by
+		 *  \ref TRACE_EVENT_AltSetting.
+		 */
+		enum SpeakerAltSettings_t
+		{
+			SPEAKER_ALT_Idle = 0, /**< Stream closed, no endpoints */
+			SPEAKER_ALT_PCM  = 1, /**< Stream of \c AUDIO_IN_CHANNELS channels, in the downmix matrix's format */
+			SPEAKER_ALT_PCM8 = 2, /**< Stream of 8-bit mono PCM, forwarded as is over an 8-bit mono link */
+		};
+
+		/** Enum for the outcomes of the link rate probe, run when the device starts and again whenever the
+		 *  receiver comes out of reset.
+		 */
+		enum LinkProbeResults_t
+		{
+			LINK_PROBE_NoReceiver  = 0, /**< No receiver answered; the requested baud rate is used untested */
+			LINK_PROBE_Unsupported = 1, /**< The receiver predates probing; the requested baud rate is used untested */
+			LINK_PROBE_Clean       = 2, /**< A rate came back without errors, and caps the requested baud rate */
+			LINK_PROBE_Failed      = 3, /**< Every rate came back with errors; the link is capped at the slowest */
+		};
+
+	/* Type Defines: */
+		/** Type define for the runtime settings of the audio pipeline and the serial link. */
+		typedef struct
+		{
+			uint8_t LinkBaud; /**< Requested baud rate of the serial link, a value from \c Link_Bauds_t. */
+			uint8_t LinkFormat; /**< Requested sample format of the serial link, a mask of \c LINK_FORMAT_* flags. */
+			uint8_t RingDepth; /**< Number of sample frames buffered before playback starts, or zero to adapt the
+			                    *   depth to the host.
+			                    */
+			uint8_t DspStages; /**< Processing stages to run on the samples, a mask of \c DSP_STAGE_* flags. */
+		} __attribute__((packed)) AppSettings_t;
+
+		/** Type define for the current state of the serial link, as returned by \ref VENDOR_REQ_GetLinkStatus. */
+		typedef struct
+		{
+			uint8_t Negotiated; /**< Non-zero if the receiver accepted the last handshake. */
+			uint8_t LinkBaud; /**< Baud rate the link is running at, a value from \c Link_Bauds_t. */
+			uint8_t LinkFormat; /**< Sample format the link is running at, a mask of \c LINK_FORMAT_* flags. */
+			uint8_t ProbeResult; /**< Outcome of the last link rate probe, a value from \ref LinkProbeResults_t. */
+			uint8_t MaxBaud; /**< Fastest baud rate the link may be negotiated to, a value from \c Link_Bauds_t. */
+			uint16_t ProbeErrors; /**< Bit errors counted at the rate above \c MaxBaud, the last to fail the probe. */
+			uint16_t Drops; /**< Sample frames dropped because the USART was still busy with the previous one,
+			                 *   saturating.
+			                 */
+		} __attribute__((packed)) LinkStatus_t;
+
+		/** Type define for the state of the sample clock, as returned by \ref VENDOR_REQ_GetClockStatus. */
+		typedef struct
+		{
+			uint8_t SyncMode; /**< Sample clock synchronisation mode, a value from \c Clock_SyncModes_t. */
+			uint8_t Locked; /**< Non-zero if the drift was measured over the last window of start of frames. */
+			int32_t DriftCentiPPM; /**< Drift of the device clock against the USB frame rate, in hundredths of a ppm. */
+		} __attribute__((packed)) ClockStatus_t;
+
+		/** Type define for the state of the jitter buffer, as returned by \ref VENDOR_REQ_GetBufferStatus. */
+		typedef struct
+		{
+			uint8_t  Adaptive; /**< Non-zero if the target depth adapts to the host. */
+			uint8_t  TargetDepth; /**< Number of frames the ring is filled to before playback starts or resumes. */
+			uint8_t  Depth; /**< Number of frames currently in the ring. */
+			uint8_t  LowWater; /**< Fewest frames in the ring during playback since the last depth change. */
+			uint16_t Underruns; /**< Number of underruns since the device was reset. */
+			uint16_t Merges; /**< Number of frames taken out of the stream to shrink the depth. */
+			uint16_t LatencyUS; /**< Latency of the frames currently in the ring, in microseconds. */
+			uint16_t Concealments; /**< Number of underruns faded out and back in since the device was reset. */
+		} __attribute__((packed)) BufferStatus_t;
+
+		/** Type define for the header of the event trace, as returned by \ref VENDOR_REQ_GetTrace. All times are
+		 *  given as a count of USB start of frames since the device was reset, wrapping at 65536, and the number of
+		 *  system clock cycles since the last of them.
+		 */
+		typedef struct
+		{
+			uint8_t  Capacity; /**< Number of entries in the trace buffer. */
+			uint8_t  Count; /**< Number of valid entries in the trace buffer, ending just before \c Next. */
+			uint8_t  Next; /**< Index of the entry the next event is recorded into. */
+			uint8_t  Lost; /**< Events overwritten or missed since the last read, saturating at 255. */
+			uint8_t  Flags; /**< Trace state, a mask of \c TRACE_FLAG_* flags. */
+			uint16_t Frame; /**< Start of frame count when the trace was read. */
+			uint16_t Cycles; /**< Cycles since that start of frame when the trace was read. */
+		} __attribute__((packed)) TraceStatus_t;
+
+		/** Type define for an entry of the event trace. */
+		typedef struct
+		{
+			uint8_t  Event; /**< Event recorded, a value from \ref TraceEvents_t. */
+			uint8_t  Data; /**< Event specific data. */
+			uint16_t Frame; /**< Start of frame count when the event was recorded. */
+			uint16_t Cycles; /**< Cycles since that start of frame when the event was recorded. */
+		} __attribute__((packed)) TraceEvent_t;
+
+		/** Type define for the header of the sample emission histogram, as returned by \ref VENDOR_REQ_GetEmission.
+		 *  Each interval between two samples sent to the output is counted in the bin of its deviation from the
+		 *  nominal sample period, the middle bin starting at no deviation; the first and last bins also take
+		 *  every deviation beyond them. Counts saturate at 65535.
+		 */
+		typedef struct
+		{
+			uint8_t  Bins; /**< Number of bins following the header. */
+			uint8_t  BinCycles; /**< Width of each bin in system clock cycles. */
+			uint16_t NominalCycles; /**< Nominal sample period in system clock cycles. */
+			int16_t  MinCycles; /**< Smallest deviation from the nominal period seen, in system clock cycles. */
+			int16_t  MaxCycles; /**< Largest deviation from the nominal period seen, in system clock cycles. */
+		} __attribute__((packed)) EmissionStatus_t;
+
+		/** Type define for the levels of one channel in a level report. Peaks and RMS levels are magnitudes of
+		 *  full scale, which is 32768 for the 16-bit samples and 2 to the power of one less than the report's
+		 *  \c Bits for the samples after the reduction; a clip is a sample at either rail. Counts saturate at 65535.
+		 */
+		typedef struct
+		{
+			uint16_t Peak; /**< Largest magnitude of the 16-bit samples. */
+			uint16_t RMS; /**< RMS level of the 16-bit samples. */
+			uint16_t Clips; /**< Number of 16-bit samples at either rail. */
+			uint16_t LinkPeak; /**< Largest magnitude of the reduced samples sent to the output. */
+			uint16_t LinkRMS; /**< RMS level of the reduced samples sent to the output. */
+			uint16_t LinkClips; /**< Number of reduced samples at either rail. */
+		} __attribute__((packed)) LevelChannel_t;
+
+		/** Type define for a level report, sent on the interrupt endpoint of the level meter interface at the
+		 *  rate the firmware was built with. Each report covers the frames sent to the link since the one before,
+		 *  of which only one in every \c Stride was measured.
+		 */
+		typedef struct
+		{
+			uint8_t        Sequence; /**< Count of reports sent, so that the host can tell if it missed any. */
+			uint8_t        Flags; /**< Mask of \c LEVEL_FLAG_* flags. */
+			uint8_t        Stride; /**< Number of frames sent for each frame measured. */
+			uint8_t        Bits; /**< Resolution in bits of the reduced samples, or 16 if the output is not reduced. */
+			uint16_t       Frames; /**< Number of frames measured, saturating. */
+			LevelChannel_t Channels[LEVEL_REPORT_CHANNELS]; /**< Levels of each channel the link carries. */
+		} __attribute__((packed)) LevelReport_t;
+
+#endif
@@ -0,0 +1,99 @@
+/** \file
+ *
+ *  Vendor streaming interface, an alternative to the isochronous speaker stream for hosts which generate the
+ *  audio themselves. The host writes PCM in the speaker stream's format to a bulk endpoint, and the device only
+ *  takes each packet once the sample ring has room for it, so the host is flow controlled by the sample clock:
+ *  nothing is lost to a missed frame, and the host can queue as much audio ahead as it likes. The stream opens
+ *  when the host selects the interface's streaming alternate setting, at the rate last given with
+ *  \ref VENDOR_REQ_SetStreamRate, and is only played while the speaker stream is closed.
+ */
+
+#include "VendorStream.h"
+
+#if defined(VENDOR_STREAM)
+
+/** Indicates if the host has selected the streaming alternate setting of the vendor stream interface. */
+bool VendorStream_Enabled;
+
+/** Sample rate in Hz the vendor stream is played at, put into effect when it opens. */
+uint16_t VendorStream_SampleRate = VENDOR_STREAM_MIN_RATE;
+
+/** Configures the vendor stream's bulk endpoint, closing the stream. This must be called from the library USB
+ *  Configuration Changed event, in order of endpoint number, after the speaker stream's feedback endpoint.
+ *
+ *  \return Boolean \c true if the endpoint was configured, \c false otherwise
+ */
+bool VendorStream_ConfigureEndpoint(void)
+{
+	VendorStream_Enabled = false;
+
+	return Endpoint_ConfigureEndpoint(VENDOR_STREAM_EPADDR, EP_TYPE_BULK, VENDOR_STREAM_EPSIZE, VENDOR_STREAM_BANKS);
+}
+
+/** Processes the standard requests for the alternate setting of the vendor stream interface, which the library
+ *  leaves to the application. This should be called from the library USB Control Request reception event.
+ */
+void VendorStream_ProcessControlRequest(void)
+{
+	if (!(Endpoint_IsSETUPReceived()))
+	  return;
+
+	if ((USB_ControlRequest.bmRequestType & (CONTROL_REQTYPE_TYPE | CONTROL_REQTYPE_RECIPIENT)) != (REQTYPE_STANDARD | REQREC_INTERFACE))
+	  return;
+
+	if ((USB_ControlRequest.wIndex & 0xFF) != INTERFACE_ID_VendorStream)
+	  return;
+
+	switch (USB_ControlRequest.bRequest)
+	{
+		case REQ_SetInterface:
+			if (!(USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST) && (USB_ControlRequest.wValue <= 1))
+			{
+				Endpoint_ClearSETUP();
+				Endpoint_ClearStatusStage();
+
+				/* Drop any packet left from before, and restart the data toggle as for any new alternate setting */
+				Endpoint_ResetEndpoint(VENDOR_STREAM_EPADDR);
+				Endpoint_SelectEndpoint(VENDOR_STREAM_EPADDR);
+				Endpoint_ResetDataToggle();
+				Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+
+				VendorStream_Enabled = (USB_ControlRequest.wValue != 0);
+				EVENT_VendorStream_StartStop();
+			}
+
+			break;
+		case REQ_GetInterface:
+			if (USB_ControlRequest.bmRequestType & REQDIR_DEVICETOHOST)
+			{
+				Endpoint_ClearSETUP();
+				Endpoint_Write_8(VendorStream_Enabled);
+				Endpoint_ClearIN();
+				Endpoint_ClearStatusStage();
+			}
+
+			break;
+	}
+}
+
+/** Sets the sample rate the vendor stream is played at from the next time it opens. Rates the sample timer
+ *  cannot run at, rates beyond those the sample path's per-frame costs were sized for, or rates which the link
+ *  cannot carry even as 8-bit mono at the fastest rate its probe found clean, are refused.
+ *
+ *  \param[in] SampleRate  Sample rate in Hz.
+ *
+ *  \return Boolean \c true if the rate was accepted, \c false otherwise
+ */
+bool VendorStream_SetRate(const uint16_t SampleRate)
+{
+	if ((SampleRate < VENDOR_STREAM_MIN_RATE) || (SampleRate > VENDOR_STREAM_MAX_RATE))
+	  return false;
+
+	if (!(Link_FitsBandwidth(Link_MaxBaud, 0, SampleRate)))
+	  return false;
+
+	VendorStream_SampleRate = SampleRate;
+	return true;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/** \file
+ *
+ *  Header file for VendorStream.c.
+ */
+
+#ifndef _VENDOR_STREAM_H_
+#define _VENDOR_STREAM_H_
+
+	/* Includes: */
+		#include <LUFA/Drivers/USB/USB.h>
+
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "Descriptors.h"
+		#include "Link.h"
+		#include "Config/AppConfig.h"
+
+	/* Macros: */
+		/** Lowest and highest sample rates in Hz the vendor stream can be set to. The lowest is the slowest the sample
+		 *  timer can run at. The highest is the rate the per-frame costs of the downmix, the DSP chain, the jitter
+		 *  buffer controller and the sample ring were sized for, as the bulk endpoint's size does not bound it the
+		 *  way the speaker endpoint's does.
+		 */
+		#define VENDOR_STREAM_MIN_RATE       8000
+		#define VENDOR_STREAM_MAX_RATE       AUDIO_MAX_SAMPLE_RATE
+
+		/** Size in bytes of each frame of the vendor stream, one sample of each stream channel. */
+		#define VENDOR_STREAM_FRAME_BYTES    (AUDIO_IN_CHANNELS * AUDIO_IN_SUBFRAME_SIZE)
+
+	#if defined(VENDOR_STREAM) || defined(__DOXYGEN__)
+		/* External Variables: */
+			extern bool     VendorStream_Enabled;
+			extern uint16_t VendorStream_SampleRate;
+	#endif
+
+	/* Inline Functions: */
+		/** Determines if the host has the vendor stream open, by selecting its streaming alternate setting.
+		 *
+		 *  \return Boolean \c true if the vendor stream is open, \c false otherwise
+		 */
+		static inline bool VendorStream_IsEnabled(void)
+		{
+			#if defined(VENDOR_STREAM)
+			return VendorStream_Enabled;
+			#else
+			return false;
+			#endif
+		}
+
+		/** Determines if a whole frame of the vendor stream is waiting to be read. This selects the vendor stream's
+		 *  endpoint, ready for \ref VendorStream_ReadSample8() or \ref VendorStream_ReadSample16(). A packet that
+		 *  is left unread holds off the next one, which is how the host is flow controlled. Zero length packets,
+		 *  and whatever is left of a packet too short to hold another whole frame, are discarded, so that a frame
+		 *  is never read across two packets and the channels stay aligned.
+		 *
+		 *  \return Boolean \c true if a frame has been received, \c false otherwise
+		 */
+		static inline bool VendorStream_IsSampleReceived(void)
+		{
+			#if defined(VENDOR_STREAM)
+			if ((USB_DeviceState != DEVICE_STATE_Configured) || !(VendorStream_Enabled))
+			  return false;
+
+			Endpoint_SelectEndpoint(VENDOR_STREAM_EPADDR);
+
+			while (Endpoint_IsOUTReceived())
+			{
+				if (Endpoint_BytesInEndpoint() >= VENDOR_STREAM_FRAME_BYTES)
+				  return true;
+
+				Endpoint_ClearOUT();
+			}
+
+			return false;
+			#else
+			return false;
+			#endif
+		}
+
+		/** Reads the next 8-bit sample of the vendor stream, releasing the packet once it has been read in full.
+		 *  The endpoint must have been selected by \ref VendorStream_IsSampleReceived().
+		 *
+		 *  \return Signed 8-bit sample.
+		 */
+		static inline int8_t VendorStream_ReadSample8(void)
+		{
+			int8_t Sample = Endpoint_Read_8();
+
+			if (!(Endpoint_BytesInEndpoint()))
+			  Endpoint_ClearOUT();
+
+			return Sample;
+		}
+
+		/** Reads the next 16-bit sample of the vendor stream, releasing the packet once it has been read in full.
+		 *  The endpoint must have been selected by \ref VendorStream_IsSampleReceived().
+		 *
+		 *  \return Signed 16-bit sample.
+		 */
+		static inline int16_t VendorStream_ReadSample16(void)
+		{
+			int16_t Sample = Endpoint_Read_16_LE();
+
+			if (!(Endpoint_BytesInEndpoint()))
+			  Endpoint_ClearOUT();
+
+			return Sample;
+		}
+
+	/* Function Prototypes: */
+		#if defined(VENDOR_STREAM)
+		bool VendorStream_ConfigureEndpoint(void);
+		void VendorStream_ProcessControlRequest(void);
+		bool VendorStream_SetRate(const uint16_t SampleRate);
+
+		void EVENT_VendorStream_StartStop(void);
+		#endif
+
+#endif